@@ -0,0 +1,112 @@
+/**
+ *	Compare 'object', 'image' and 'cov' process data delivery.
+ *	Each mode runs in its own process against the same slave configuration,
+ *	reporting CPU time, GC activity and time spent inside 'data' handler.
+ *
+ *	usage: node bench/delivery.js <slaves.json> [frequency=1000] [seconds=10]
+ * */
+
+const { fork } = require('child_process');
+const { PerformanceObserver, performance } = require('perf_hooks');
+
+const [ config, frequency = 1000, seconds = 10, mode ] = process.argv.slice(2);
+
+if(!config){
+	console.error('usage: node bench/delivery.js <slaves.json> [frequency] [seconds]');
+	process.exit(1);
+}
+
+function runMode(){
+	const ECAT = require(`${__dirname}/..`);
+	const etherlab = new ECAT(config, Number(frequency));
+
+	const gc = { count: 0, duration: 0 };
+	const observer = new PerformanceObserver(list => {
+		for(const entry of list.getEntries()){
+			gc.count++;
+			gc.duration += entry.duration;
+		}
+	});
+	observer.observe({ entryTypes: ['gc'] });
+
+	const stats = { cycles: 0, handler: 0, sum: 0 };
+	let cpu;
+
+	etherlab.setDeliveryMode(mode);
+
+	etherlab.on('data', data => {
+		const start = performance.now();
+
+		// touch every value, as an application would
+		let sum = 0;
+		if(mode === 'image'){
+			for(let idx = 0; idx < data.length; idx++){
+				sum += data[idx];
+			}
+		} else if(mode === 'cov'){
+			const { values } = data;
+			for(let idx = 0; idx < values.length; idx++){
+				sum += values[idx];
+			}
+		} else {
+			for(const item of data){
+				sum += item.value ?? 0;
+			}
+		}
+
+		stats.sum = sum;
+		stats.cycles++;
+		stats.handler += performance.now() - start;
+	});
+
+	etherlab.on('ready', () => {
+		cpu = process.cpuUsage();
+		stats.cycles = 0;
+		stats.handler = 0;
+		gc.count = 0;
+		gc.duration = 0;
+
+		setTimeout(() => {
+			const used = process.cpuUsage(cpu);
+			const { coalesced } = etherlab.getDeliveryStats();
+
+			observer.disconnect();
+			process.send({
+				mode,
+				cycles: stats.cycles,
+				cpuMs: (used.user + used.system) / 1e3,
+				handlerUsPerCycle: (stats.handler * 1e3) / stats.cycles,
+				gcCount: gc.count,
+				gcMs: gc.duration,
+				coalesced,
+			});
+
+			etherlab.stop();
+			process.exit(0);
+		}, Number(seconds) * 1000);
+	});
+
+	etherlab.start();
+}
+
+async function main(){
+	const results = [];
+
+	for(const current of ['object', 'image', 'cov']){
+		results.push(await new Promise((resolve, reject) => {
+			const child = fork(__filename,
+				[ config, frequency, seconds, current ]);
+
+			child.on('message', resolve);
+			child.on('error', reject);
+		}));
+	}
+
+	console.table(results);
+}
+
+if(mode){
+	runMode();
+} else {
+	main();
+}
@@ -0,0 +1,668 @@
+/**
+ * Hot paths of the helper over synthetic slave configurations, run against
+ * the simulated master so no EtherCAT hardware is needed:
+ *
+ *   parse         ConfigParser::parse() of the whole slave JSON
+ *   resolve       domain_resolve(), i.e. get_domain_index() of every entry
+ *   main_routine  one cycle in OP, simulated master's exchange included
+ *   marshal       native part of routine_cb in 'image' delivery: snapshot
+ *                 publish, take-over and copy into the JS buffer. Cost of
+ *                 N-API objects is measured by bench/delivery.js
+ *   sdo_bulk      64 SDO writes to the first slave while running, twice
+ *                 what its request queue takes. Fails if any transfer is
+ *                 rejected, or reading them back gives other values
+ *   dc_follow     one cycle in OP with DC drift compensation, against a
+ *                 reference clock 0.7 periods ahead. Fails if the reported
+ *                 difference isn't normalised into half a period
+ *
+ * Every benchmark is calibrated to run at least --min-time, then repeated
+ * --repeat times, the median is reported. Allocations are counted through
+ * malloc() on glibc, through global operator new elsewhere.
+ *
+ * usage: ecat_bench [--json[=file]] [--filter name] [--min-time ms]
+ *                   [--repeat n]
+ */
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <new>
+#include <string>
+#include <vector>
+
+#include <TripleBuffer.hpp>
+#include <etherlab-helper.h>
+
+#include "config-parser.h"
+
+using namespace EcatHelper;
+
+namespace fs = std::filesystem;
+
+/****************************************************************************/
+
+static std::atomic<uint64_t> alloc_count { 0 };
+static std::atomic<uint64_t> alloc_bytes { 0 };
+
+inline static void count_alloc(const size_t& size)
+{
+	alloc_count.fetch_add(1, std::memory_order_relaxed);
+	alloc_bytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+#ifdef __GLIBC__
+
+// rapidjson allocates through malloc() directly, operator new ends up
+// there as well, so every allocation is counted exactly once
+extern "C" {
+
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+
+void* malloc(size_t size)
+{
+	count_alloc(size);
+	return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size)
+{
+	count_alloc(count * size);
+	return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size)
+{
+	count_alloc(size);
+	return __libc_realloc(ptr, size);
+}
+}
+
+#else
+
+void* operator new(size_t size)
+{
+	count_alloc(size);
+
+	void* ptr = malloc(size ? size : 1);
+	if (!ptr) {
+		throw std::bad_alloc();
+	}
+
+	return ptr;
+}
+
+void operator delete(void* ptr) noexcept
+{
+	free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+	free(ptr);
+}
+
+#endif
+
+/****************************************************************************/
+
+typedef struct bench_config_s {
+	uint32_t slaves;
+	uint32_t entries;
+} bench_config_al;
+
+static const bench_config_al configs[] = {
+	{ 10, 100 },
+	{ 50, 1000 },
+	{ 250, 5000 },
+	{ 1000, 20000 },
+};
+
+static const ecat_size_al entry_sizes[] = { 1, 8, 16, 32, 1, 16, 32, 64 };
+
+typedef struct bench_options_s {
+	bool json = false;
+	std::string json_path; /**< Empty means stdout. */
+	std::string filter;
+	uint64_t min_time_ns = 200'000'000;
+	uint32_t repeat = 5;
+} bench_options_al;
+
+typedef struct bench_result_s {
+	std::string name;
+	uint32_t slaves = 0;
+	uint32_t entries = 0;
+
+	uint64_t iterations = 0; /**< Per repetition. */
+	double ns_per_op = 0;
+	double ns_per_op_min = 0;
+	double entries_per_s = 0;
+	double allocs_per_op = 0;
+	double bytes_per_op = 0;
+} bench_result_al;
+
+static bench_options_al options;
+static std::vector<bench_result_al> results;
+
+inline static uint64_t now_ns()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch())
+		.count();
+}
+
+/**
+ * Half of the entries of every slave are outputs in SM2, the other half
+ * inputs in SM3, four entries per PDO. Slaves come up in OP at once.
+ * With dc_offset_ns, every slave runs DC-synchronous and the first one is
+ * the reference clock, that much ahead of application time.
+ */
+static std::string build_config(
+	const bench_config_al& config, const int64_t& dc_offset_ns = 0)
+{
+	uint32_t per_slave = config.entries / config.slaves;
+	std::string json = "[";
+	char buf[256];
+
+	for (uint32_t slave = 0; slave < config.slaves; slave++) {
+		snprintf(buf, sizeof(buf),
+			"%s{\"alias\":0,\"position\":%u,\"vendor_id\":\"0x00000002\","
+			"\"product_code\":\"0x%08x\","
+			"\"simulation\":{\"startup_cycles\":0,\"clock_offset_ns\":%" PRId64
+			"},",
+			slave ? "," : "", slave, 0x10000000 | slave,
+			slave ? 0 : dc_offset_ns);
+		json += buf;
+
+		if (dc_offset_ns) {
+			json += "\"dc\":{\"assign_activate\":\"0x0300\"},";
+		}
+
+		json += "\"syncs\":[";
+
+		uint32_t outputs = per_slave / 2;
+
+		for (uint8_t sm = 2; sm <= 3; sm++) {
+			uint32_t count = sm == 2 ? outputs : per_slave - outputs;
+			uint16_t pdo_base = sm == 2 ? 0x1600 : 0x1a00;
+			uint16_t entry_base = sm == 2 ? 0x7000 : 0x6000;
+
+			snprintf(buf, sizeof(buf),
+				"%s{\"index\":%u,\"watchdog_enabled\":false,\"pdos\":[",
+				sm == 3 ? "," : "", sm);
+			json += buf;
+
+			for (uint32_t idx = 0; idx < count; idx++) {
+				if (!(idx % 4)) {
+					snprintf(buf, sizeof(buf),
+						"%s{\"index\":\"0x%04x\",\"entries\":[",
+						idx ? "]}," : "", pdo_base + idx / 4);
+					json += buf;
+				}
+
+				snprintf(buf, sizeof(buf),
+					"%s{\"index\":\"0x%04x\",\"subindex\":\"0x%02x\","
+					"\"size\":%u,\"add_to_domain\":true,"
+					"\"swap_endian\":%s,\"signed\":%s}",
+					idx % 4 ? "," : "", entry_base + ((idx / 4) << 4),
+					idx % 4 + 1, entry_sizes[idx % 8],
+					idx % 3 ? "false" : "true", idx % 5 ? "false" : "true");
+				json += buf;
+			}
+
+			json += count ? "]}]}" : "]}";
+		}
+
+		json += "]}";
+	}
+
+	json += "]";
+
+	return json;
+}
+
+/**
+ * Runs fn(iterations) until a repetition lasts min_time, then repeats it.
+ * fn returns entries processed per call.
+ */
+template <typename F>
+static void measure(const char* name, const bench_config_al& config, F fn)
+{
+	if (!options.filter.empty()
+		&& !strstr(name, options.filter.c_str())) {
+		return;
+	}
+
+	uint64_t iterations = 1;
+	uint64_t elapsed = 0;
+
+	// calibration also warms up caches and lazily allocated state
+	while (true) {
+		uint64_t start = now_ns();
+		fn(iterations);
+		elapsed = now_ns() - start;
+
+		if (elapsed >= options.min_time_ns || iterations >= (1ULL << 32)) {
+			break;
+		}
+
+		// aim slightly above min_time, at most 10 times more per step
+		double scale = elapsed
+			? std::min(10.0, 1.2 * options.min_time_ns / elapsed)
+			: 10.0;
+		iterations = std::max<uint64_t>(iterations + 1, iterations * scale);
+	}
+
+	std::vector<double> samples;
+	uint64_t entries = 0;
+	uint64_t allocs = alloc_count.load(std::memory_order_relaxed);
+	uint64_t bytes = alloc_bytes.load(std::memory_order_relaxed);
+
+	for (uint32_t rep = 0; rep < options.repeat; rep++) {
+		uint64_t start = now_ns();
+		entries = fn(iterations);
+		samples.push_back(double(now_ns() - start) / iterations);
+	}
+
+	allocs = alloc_count.load(std::memory_order_relaxed) - allocs;
+	bytes = alloc_bytes.load(std::memory_order_relaxed) - bytes;
+
+	std::sort(samples.begin(), samples.end());
+
+	bench_result_al result;
+	result.name = name;
+	result.slaves = config.slaves;
+	result.entries = config.entries;
+	result.iterations = iterations;
+	result.ns_per_op = samples[samples.size() / 2];
+	result.ns_per_op_min = samples.front();
+	result.entries_per_s = entries * 1e9 / result.ns_per_op;
+	result.allocs_per_op
+		= double(allocs) / ((uint64_t)options.repeat * iterations);
+	result.bytes_per_op = double(bytes) / ((uint64_t)options.repeat * iterations);
+
+	if (!options.json || !options.json_path.empty()) {
+		printf("%-14s %7u %7u %14.1f %14.3e %12.2f %12.1f\n", name,
+			result.slaves, result.entries, result.ns_per_op,
+			result.entries_per_s, result.allocs_per_op, result.bytes_per_op);
+		fflush(stdout);
+	}
+
+	results.push_back(result);
+}
+
+static void bench_parse(const bench_config_al& config, const std::string& json)
+{
+	std::vector<ecat_slave_entry_al> slave_entries;
+	std::vector<ecat_startup_config_al> startup_parameters;
+	std::vector<ecat_domain_config_al> domain_configs;
+	std::vector<ecat_dc_config_al> dc_configs;
+	ecat_size_slave_al slave_length;
+	ecat_size_param_al parameters_length;
+
+	measure("parse", config, [&](uint64_t iterations) {
+		for (uint64_t iter = 0; iter < iterations; iter++) {
+			// parser appends, the same as a master loading its only config
+			slave_entries.clear();
+			startup_parameters.clear();
+
+			ConfigParser::parse(json.c_str(), &slave_entries, &slave_length,
+				&startup_parameters, &parameters_length, &domain_configs,
+				&dc_configs);
+		}
+
+		return (uint64_t)slave_entries.size();
+	});
+}
+
+/**
+ * Bulk SDO transfer on the running master, every cycle the completed
+ * transfers are handed back to the batch. Returns false if it doesn't
+ * complete within a second of cycles.
+ */
+static bool run_sdo_batch(std::vector<ecat_sdo_job_al>& jobs)
+{
+	SDO::Batch batch;
+	batch.assign(jobs.data(), jobs.size());
+
+	size_t pending = batch.submit();
+
+	for (uint32_t cycle = 0; pending && cycle < get_frequency(); cycle++) {
+		main_routine();
+
+		ecat_sdo_job_al done;
+		while (pending && sdo_request_poll(&done)) {
+			ecat_sdo_job_al& job = jobs[done.tag];
+			job.value = done.value;
+			job.retval = done.retval;
+
+			pending = batch.complete();
+		}
+	}
+
+	return !pending;
+}
+
+static bool bench_sdo_bulk(const bench_config_al& config)
+{
+	const uint32_t count = 64;
+
+	std::vector<ecat_sdo_job_al> writes(count), reads(count);
+	for (uint32_t idx = 0; idx < count; idx++) {
+		ecat_sdo_job_al& job = writes[idx];
+		job.tag = idx;
+		job.position = 0;
+		job.index = 0x2000;
+		job.subindex = idx + 1;
+		job.size = sizeof(uint32_t);
+		job.rtype = ECAT_SDO_WRITE;
+		job.value.u32 = 0xbe000000 | idx;
+
+		reads[idx] = job;
+		reads[idx].rtype = ECAT_SDO_READ;
+		reads[idx].value.u64 = 0;
+	}
+
+	bool valid = run_sdo_batch(writes) && run_sdo_batch(reads);
+
+	for (uint32_t idx = 0; valid && idx < count; idx++) {
+		if (writes[idx].retval || reads[idx].retval
+			|| reads[idx].value.u32 != writes[idx].value.u32) {
+
+			fprintf(stderr,
+				"SDO transfer %u: write %d, read %d, value 0x%08x\n", idx,
+				writes[idx].retval, reads[idx].retval, reads[idx].value.u32);
+			valid = false;
+		}
+	}
+
+	if (!valid) {
+		fprintf(stderr, "SDO bulk of %u transfers to one slave failed\n",
+			count * 2);
+	}
+
+	measure("sdo_bulk", config, [&](uint64_t iterations) {
+		for (uint64_t iter = 0; iter < iterations; iter++) {
+			run_sdo_batch(writes);
+		}
+
+		return (uint64_t)count;
+	});
+
+	return valid;
+}
+
+static bool bench_master(const bench_config_al& config, const std::string& json,
+	const uint32_t& index)
+{
+	fs::path path = fs::temp_directory_path()
+		/ ("ecat_bench_" + std::to_string(getpid()) + "_"
+			+ std::to_string(index) + ".json");
+
+	std::ofstream(path) << json;
+
+	use_master(open_master(index));
+	set_memory_lock(false);
+	set_frequency(1000);
+
+	if (set_json_path(path)) {
+		fprintf(stderr, "Can't load %s\n", path.c_str());
+		fs::remove(path);
+		return false;
+	}
+
+	init();
+	prerun_routine();
+
+	ecat_entries_al* entries;
+	attach_process_data(&entries);
+
+	ecat_size_io_al length = entries->size();
+	std::vector<ecat_image_value_al> image(length, 0);
+	attach_process_image(image.data(), length);
+
+	// first cycles take slaves and master to OP
+	for (int cycle = 0; cycle < 10; cycle++) {
+		main_routine();
+	}
+
+	if (!operational_status()) {
+		fprintf(stderr, "Master %u is not in OP, states 0x%02x\n", index,
+			application_layer_states());
+	}
+
+	measure("main_routine", config, [&](uint64_t iterations) {
+		for (uint64_t iter = 0; iter < iterations; iter++) {
+			main_routine();
+		}
+
+		return (uint64_t)length;
+	});
+
+	std::vector<ecat_slave_entry_al> keys(entries->begin(), entries->end());
+	volatile ecat_size_io_al sink = 0;
+
+	measure("resolve", config, [&](uint64_t iterations) {
+		for (uint64_t iter = 0; iter < iterations; iter++) {
+			ecat_size_io_al sum = 0;
+			for (const ecat_slave_entry_al& key : keys) {
+				sum += domain_resolve(key.position, key.index, key.subindex);
+			}
+			sink = sum;
+		}
+
+		return (uint64_t)keys.size();
+	});
+
+	(void)sink;
+
+	// cyclic thread publishes the decoded image, JS thread takes it over
+	// and copies it into the Float64Array handed to the callback
+	TripleBuffer<std::vector<ecat_image_value_al>> mailbox;
+	mailbox.for_each([&](std::vector<ecat_image_value_al>& slot) {
+		slot.assign(image.begin(), image.end());
+	});
+	std::vector<ecat_image_value_al> js_image(length, 0);
+
+	measure("marshal", config, [&](uint64_t iterations) {
+		for (uint64_t iter = 0; iter < iterations; iter++) {
+			mailbox.back()[iter % length] = iter;
+			mailbox.publish();
+
+			if (mailbox.update()) {
+				const std::vector<ecat_image_value_al>& front = mailbox.front();
+				std::copy(front.begin(), front.end(), js_image.data());
+			}
+		}
+
+		return (uint64_t)length;
+	});
+
+	bool valid = true;
+	if (options.filter.empty()
+		|| strstr("sdo_bulk", options.filter.c_str()) != nullptr) {
+		valid = bench_sdo_bulk(config);
+	}
+
+	detach_process_image();
+	postrun_routine();
+
+	fs::remove(path);
+
+	return valid;
+}
+
+/**
+ * Application time is advanced as the cyclic thread does, by one period
+ * plus the wakeup correction. A reference clock ahead by more than half a
+ * period is the nearest one behind, e.g. +700 us is -300 us at 1 ms.
+ */
+static bool bench_dc(const bench_config_al& config, const uint32_t& index)
+{
+	const uint32_t frequency = 1000;
+	const int32_t period_ns = 1'000'000'000 / frequency;
+	const int64_t offset_ns = period_ns * 7 / 10;
+
+	fs::path path = fs::temp_directory_path()
+		/ ("ecat_bench_" + std::to_string(getpid()) + "_"
+			+ std::to_string(index) + ".json");
+
+	std::ofstream(path) << build_config(config, offset_ns);
+
+	use_master(open_master(index));
+	set_memory_lock(false);
+	set_frequency(frequency);
+	set_dc_drift_compensation(true);
+
+	if (set_json_path(path)) {
+		fprintf(stderr, "Can't load %s\n", path.c_str());
+		fs::remove(path);
+		return false;
+	}
+
+	init();
+	prerun_routine();
+
+	uint64_t wakeup_ns = 0;
+	auto cycle = [&wakeup_ns, &period_ns]() {
+		set_application_time(wakeup_ns);
+		main_routine();
+		wakeup_ns += period_ns + dc_wakeup_adjust();
+	};
+
+	for (int idx = 0; idx < 10; idx++) {
+		cycle();
+	}
+
+	ecat_dc_report_al report;
+	dc_report(&report);
+
+	// application time minus reference clock
+	int64_t expected = period_ns - offset_ns;
+	bool valid = report.diff_ns == expected;
+
+	if (!valid) {
+		fprintf(stderr, "DC difference %d ns, expected %" PRId64 " ns\n",
+			report.diff_ns, expected);
+	}
+
+	measure("dc_follow", config, [&](uint64_t iterations) {
+		for (uint64_t iter = 0; iter < iterations; iter++) {
+			cycle();
+		}
+
+		return (uint64_t)config.entries;
+	});
+
+	postrun_routine();
+	fs::remove(path);
+
+	return valid;
+}
+
+static void write_json(FILE* file)
+{
+	fprintf(file,
+		"{\n\t\"format\": 1,\n\t\"compiler\": \"%s\",\n\t\"min_time_ns\": "
+		"%" PRIu64 ",\n\t\"repeat\": %u,\n\t\"results\": [",
+		__VERSION__, options.min_time_ns, options.repeat);
+
+	for (size_t idx = 0; idx < results.size(); idx++) {
+		const bench_result_al& result = results[idx];
+
+		fprintf(file,
+			"%s\n\t\t{ \"benchmark\": \"%s\", \"slaves\": %u, \"entries\": "
+			"%u, \"iterations\": %" PRIu64 ", \"ns_per_op\": %.2f, "
+			"\"ns_per_op_min\": %.2f, \"entries_per_s\": %.1f, "
+			"\"allocs_per_op\": %.3f, \"bytes_per_op\": %.1f }",
+			idx ? "," : "", result.name.c_str(), result.slaves,
+			result.entries, result.iterations, result.ns_per_op,
+			result.ns_per_op_min, result.entries_per_s, result.allocs_per_op,
+			result.bytes_per_op);
+	}
+
+	fprintf(file, "\n\t]\n}\n");
+}
+
+int main(int argc, char** argv)
+{
+	for (int idx = 1; idx < argc; idx++) {
+		std::string arg = argv[idx];
+		const char* next = idx + 1 < argc ? argv[idx + 1] : nullptr;
+
+		if (arg == "--json") {
+			options.json = true;
+		} else if (arg.rfind("--json=", 0) == 0) {
+			options.json = true;
+			options.json_path = arg.substr(7);
+		} else if (arg == "--filter" && next) {
+			options.filter = argv[++idx];
+		} else if (arg == "--min-time" && next) {
+			options.min_time_ns = strtoull(argv[++idx], nullptr, 10) * 1'000'000;
+		} else if (arg == "--repeat" && next) {
+			options.repeat = std::max(atoi(argv[++idx]), 1);
+		} else {
+			fprintf(stderr,
+				"usage: %s [--json[=file]] [--filter name] [--min-time ms] "
+				"[--repeat n]\n",
+				argv[0]);
+			return 1;
+		}
+	}
+
+	// helper reports on stdout, keep it clean for JSON
+	FILE* report = stdout;
+	if (options.json && options.json_path.empty()) {
+		fflush(stdout);
+		report = fdopen(dup(STDOUT_FILENO), "w");
+
+		if (!report || !freopen("/dev/null", "w", stdout)) {
+			perror("Can't redirect stdout");
+			return 1;
+		}
+	}
+
+	if (!options.json || !options.json_path.empty()) {
+		printf("%-14s %7s %7s %14s %14s %12s %12s\n", "benchmark", "slaves",
+			"entries", "ns/op", "entries/s", "allocs/op", "bytes/op");
+	}
+
+	uint32_t index = 0;
+	bool valid = true;
+	for (const bench_config_al& config : configs) {
+		std::string json = build_config(config);
+
+		bench_parse(config, json);
+		valid &= bench_master(config, json, index++);
+
+		if (options.filter.empty() || strstr("dc_follow", options.filter.c_str()) != nullptr) {
+			valid &= bench_dc(config, index++);
+		}
+	}
+
+	if (options.json) {
+		FILE* file = options.json_path.empty()
+			? report
+			: fopen(options.json_path.c_str(), "w");
+
+		if (!file) {
+			perror("Can't write results");
+			return 1;
+		}
+
+		write_json(file);
+		fclose(file);
+	}
+
+	return valid ? 0 : 1;
+}
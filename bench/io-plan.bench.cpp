@@ -0,0 +1,225 @@
+/**
+ * Compare the previous per-entry switch in main_routine() with the compiled
+ * IO plan over synthetic domains. 'dirty/entry' only encodes 1% of outputs,
+ * the way main_routine() does between periodic output refreshes.
+ *
+ * usage: io_plan_bench [iterations=20000]
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "io-plan.h"
+
+using namespace EcatHelper;
+
+// previous layout of a domain entry, kept here as baseline
+typedef struct legacy_entry_s {
+	ecat_slave_entry_al entry;
+	ecat_value_al value;
+	ecat_value_al written_value;
+} legacy_entry_al;
+
+static const ecat_size_al entry_sizes[] = { 1, 8, 16, 32, 64, 16, 32, 1 };
+
+inline static uint64_t timestamp()
+{
+#if defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+	return std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+}
+
+static void build_domain(ecat_size_io_al length, ecat_entries_al* entries,
+	std::vector<uint8_t>* pd)
+{
+	uint32_t offset = 0;
+	uint8_t bit_position = 0;
+
+	entries->clear();
+
+	// every synthetic slave has 8 channels of the same kind
+	for (ecat_size_io_al idx = 0; idx < length; idx++) {
+		ecat_slave_entry_al entry = {};
+		ecat_size_io_al slave = idx / 8;
+
+		entry.position = slave;
+		entry.index = 0x6000 + ((idx % 8) << 4);
+		entry.subindex = 1;
+		entry.size = entry_sizes[slave % 8];
+		entry.direction = slave % 2 ? EC_DIR_OUTPUT : EC_DIR_INPUT;
+		entry.swap_endian = (slave % 3) == 0;
+		entry.is_signed = (slave % 5) == 0;
+
+		if (entry.size == 1) {
+			entry.offset = offset;
+			entry.bit_position = bit_position++;
+
+			if (bit_position == 8) {
+				bit_position = 0;
+				offset++;
+			}
+		} else {
+			if (bit_position) {
+				bit_position = 0;
+				offset++;
+			}
+
+			entry.offset = offset;
+			offset += entry.size / 8;
+		}
+
+		entries->push_back(entry);
+	}
+
+	pd->assign(offset + 8, 0);
+
+	for (size_t idx = 0; idx < pd->size(); idx++) {
+		(*pd)[idx] = rand();
+	}
+}
+
+static void legacy_routine(std::vector<legacy_entry_al>& IOs, uint8_t* pd,
+	ecat_image_value_al* image)
+{
+	size_t length = IOs.size();
+
+	for (size_t dmn_idx = 0; dmn_idx < length; dmn_idx++) {
+		ecat_slave_entry_al& entry = IOs[dmn_idx].entry;
+		ecat_value_al& value = IOs[dmn_idx].value;
+
+		if (entry.direction == EC_DIR_OUTPUT) {
+			ecat_value_al& written = IOs[dmn_idx].written_value;
+
+			switch (entry.size) {
+			case 1: {
+				EC_WRITE_BIT(
+					pd + entry.offset, entry.bit_position, written.u8 & 0x1);
+			} break;
+
+			case 8: {
+				EC_WRITE_U8(pd + entry.offset, written.u8);
+			} break;
+
+			case 16: {
+				EC_WRITE_U16(pd + entry.offset, written.u16);
+			} break;
+
+			case 32: {
+				EC_WRITE_U32(pd + entry.offset, written.u32);
+			} break;
+
+			case 64: {
+				EC_WRITE_U64(pd + entry.offset, written.u64);
+			} break;
+			}
+		}
+
+		switch (entry.size) {
+		case 1: {
+			value.u8 = EC_READ_BIT(pd + entry.offset, entry.bit_position) & 0x1;
+			image[dmn_idx] = value.u8;
+		} break;
+
+		case 8: {
+			value.u8 = EC_READ_U8(pd + entry.offset);
+			image[dmn_idx] = entry.is_signed ? value.i8 : value.u8;
+		} break;
+
+		case 16: {
+			uint16_t tmp16 = EC_READ_U16(pd + entry.offset);
+			value.u16 = entry.swap_endian ? swap_endian16(tmp16) : tmp16;
+			image[dmn_idx] = entry.is_signed ? value.i16 : value.u16;
+		} break;
+
+		case 32: {
+			uint32_t tmp32 = EC_READ_U32(pd + entry.offset);
+			value.u32 = entry.swap_endian ? swap_endian32(tmp32) : tmp32;
+			image[dmn_idx] = entry.is_signed ? value.i32 : value.u32;
+		} break;
+
+		default: {
+			uint64_t tmp64 = EC_READ_U64(pd + entry.offset);
+			value.u64 = entry.swap_endian ? swap_endian64(tmp64) : tmp64;
+			image[dmn_idx] = entry.is_signed ? value.i64 : value.u64;
+		} break;
+		}
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const uint32_t iterations = argc > 1 ? atoi(argv[1]) : 20000;
+	const ecat_size_io_al domain_sizes[] = { 100, 1000, 10000 };
+
+	printf("%8s %14s %14s %14s %12s %12s\n", "entries", "legacy/entry",
+		"plan/entry", "dirty/entry", "legacy/plan", "legacy/dirty");
+
+	for (ecat_size_io_al length : domain_sizes) {
+		ecat_entries_al entries;
+		std::vector<uint8_t> pd;
+
+		build_domain(length, &entries, &pd);
+
+		std::vector<legacy_entry_al> legacy;
+		for (const ecat_slave_entry_al& entry : entries) {
+			legacy.push_back({ .entry = entry });
+		}
+
+		IOPlan::io_plan_al plan;
+		IOPlan::build(entries, &plan);
+
+		std::vector<uint64_t> inputs(length, 0);
+		std::vector<uint64_t> outputs(length, 0);
+		std::vector<ecat_image_value_al> image(length, 0);
+		std::vector<uint64_t> dirty(IOPlan::dirty_words(length), 0);
+
+		for (ecat_size_io_al idx = 0; idx < length; idx += 100) {
+			IOPlan::mark_dirty(dirty.data(), idx);
+		}
+
+		uint64_t start = timestamp();
+		for (uint32_t iter = 0; iter < iterations; iter++) {
+			legacy_routine(legacy, pd.data(), image.data());
+		}
+		double legacy_per_entry
+			= double(timestamp() - start) / iterations / length;
+
+		start = timestamp();
+		for (uint32_t iter = 0; iter < iterations; iter++) {
+			IOPlan::encode(plan, pd.data(), outputs.data());
+			IOPlan::decode(plan, pd.data(), inputs.data(), image.data());
+		}
+		double plan_per_entry = double(timestamp() - start) / iterations / length;
+
+		start = timestamp();
+		for (uint32_t iter = 0; iter < iterations; iter++) {
+			IOPlan::encode_dirty(
+				plan, pd.data(), outputs.data(), dirty.data());
+			IOPlan::decode(plan, pd.data(), inputs.data(), image.data());
+		}
+		double dirty_per_entry
+			= double(timestamp() - start) / iterations / length;
+
+		printf("%8d %14.2f %14.2f %14.2f %11.2fx %11.2fx\n", length,
+			legacy_per_entry, plan_per_entry, dirty_per_entry,
+			legacy_per_entry / plan_per_entry,
+			legacy_per_entry / dirty_per_entry);
+	}
+
+#if defined(__x86_64__) || defined(__i386__)
+	printf("\nvalues are TSC cycles per entry\n");
+#else
+	printf("\nvalues are nanoseconds per entry\n");
+#endif
+
+	return 0;
+}
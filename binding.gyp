@@ -40,6 +40,7 @@
 		],
 		"variables": {
 			"build_debug": '<!(printf %d ${ECAT_BUILD_DEBUG} || printf %d 0)',
+			"simulation": '<!(printf %d ${ECAT_SIMULATION} || printf %d 0)',
 		},
 		'defines': [ "NO_LOCK=1" ],
 		'conditions': [
@@ -47,6 +48,15 @@
 				"defines": [ "VERBOSE=<(build_debug)" ],
 				"cflags": [ "-g3" ],
 				"cflags_cc": [ "-g3" ],
+			}],
+			['simulation > 0', {
+				"defines": [ "ECAT_SIMULATION=1" ],
+				"include_dirs+": [
+					"src/etherlab-helper/sim",
+					"src/etherlab-helper/lib/rapidjson/include"
+				],
+				"sources": [ "src/etherlab-helper/sim/ecrt-sim.cpp" ],
+				"libraries!": [ "-lethercat" ],
 			}]
 		]
 	}]
@@ -6,44 +6,88 @@ const { hrtime } = process;
 
 const MovingAvg = require('./class/movingAverage.class.js');
 
-const _config = {
-	slaveJSON: undefined,
-	data: undefined,
-	state: undefined,
-	interval: 0n,
-	frequency: 1000,
-	domain: undefined,
-	doSortSlave: false,
+// CiA 402 drive states, indexed by axis status 'state'
+const AXIS_STATES = [
+	'not ready to switch on',
+	'switch on disabled',
+	'ready to switch on',
+	'switched on',
+	'operation enabled',
+	'quick stop active',
+	'fault reaction active',
+	'fault',
+];
+
+// delivery modes, as numbered by the helper
+const DELIVERY_MODES = {
+	object: 0,
+	image: 1,
+	cov: 2,
 };
 
-const _cycle = {
-	frequency: 1000,
-	period: 0,
-	latency: {
-		current: 0n,
-		last: 0n,
-		diff: 0n,
-	},
-	timer: 0n,
-};
-
-const _average = {
-	lastN: 10,
-	jitter: new MovingAvg(this.lastN),
-	latency: new MovingAvg(this.lastN),
-	get values(){
-		return {
-			latency: this.latency.val,
-			jitter: this.jitter.val,
-		}
-	},
+// trajectory segment types, as numbered by the helper
+const SEGMENT_TYPES = {
+	setpoint: 0,
+	linear: 1,
+	pvt: 2,
+	move: 3,
 };
 
 class ECAT extends EventEmitter{
-	constructor(slaveJSON, freq, doSortSlave = false){
+	/**
+	 *	@param {string} slaveJSON - json file path
+	 *	@param {number} freq - frequency in Hertz
+	 *	@param {boolean} doSortSlave - to sort the slaves, 'true' must be passed
+	 *	@param {number} masterIndex - EtherCAT master to be used, every
+	 *		master runs its own cyclic thread
+	 * 	@example const etherlab = new ECAT('./slaves.json', 1000, false, 1);
+	 * */
+	constructor(slaveJSON, freq, doSortSlave = false, masterIndex = 0){
 		super();
 		const self = this;
 
+		if(!Number.isInteger(masterIndex) || masterIndex < 0){
+			throw `Master index must be an integer and not less than 0`;
+		}
+
+		self._ecat = masterIndex ? ecat.openMaster(masterIndex) : ecat;
+		self.masterIndex = masterIndex;
+
+		self._config = {
+			slaveJSON: undefined,
+			data: undefined,
+			state: undefined,
+			interval: 0n,
+			frequency: 1000,
+			domain: undefined,
+			doSortSlave: false,
+			deliveryMode: 'object',
+			layout: undefined,
+		};
+
+		self._cycle = {
+			frequency: 1000,
+			period: 0,
+			latency: {
+				current: 0n,
+				last: 0n,
+				diff: 0n,
+			},
+			timer: 0n,
+		};
+
+		self._average = {
+			lastN: 10,
+			jitter: new MovingAvg(10),
+			latency: new MovingAvg(10),
+			get values(){
+				return {
+					latency: this.latency.val,
+					jitter: this.jitter.val,
+				}
+			},
+		};
+
 		self._timer = 0n;
 		self.isReady = false;
 
@@ -78,8 +122,8 @@ class ECAT extends EventEmitter{
 				return;
 			}
 
-			ecat.setJSON(filepath);
-			_config.slaveJSON = filepath;
+			this._ecat.setJSON(filepath);
+			this._config.slaveJSON = filepath;
 
 			return;
 		}
@@ -99,11 +143,92 @@ class ECAT extends EventEmitter{
 			throw `Frequency must be an integer and greater than 0`;
 		}
 
-		_cycle.frequency = freq;
-		_config.frequency = _cycle.frequency;
-		_cycle.period = ecat.setFrequency(_cycle.frequency);
+		this._cycle.frequency = freq;
+		this._config.frequency = this._cycle.frequency;
+		this._cycle.period = this._ecat.setFrequency(this._cycle.frequency);
 
-		return _cycle;
+		return this._cycle;
+	}
+
+	/**
+	 *	Only outputs written since last cycle are copied into domain.
+	 *	For robustness, all outputs can be rewritten periodically
+	 *	@param {number} cycles - rewrite all outputs every n cycles,
+	 *		0 means all outputs are only written on the first cycle
+	 * 	@example etherlab.setOutputRefresh(1000);
+	 * */
+	setOutputRefresh(cycles){
+		if(isNaN(cycles) || !Number.isInteger(cycles) || cycles < 0){
+			throw `Cycles must be an integer and not less than 0`;
+		}
+
+		return this._ecat.setOutputRefresh(cycles);
+	}
+
+	/**
+	 *	Set how process data is delivered to 'data' event
+	 *		- 'object': array of objects, allocated every cycle
+	 *		- 'image': the same Float64Array every cycle, its element order
+	 *		  is described by getLayout()
+	 *		- 'cov': only entries changed since their last delivery, as
+	 *		  { handles: Int32Array, values: Float64Array }. Changes are
+	 *		  filtered by setCovRule(), the first event carries every entry.
+	 *		  Event is emitted whenever anything changed, regardless of
+	 *		  setInterval(), so no change is ever lost. Both arrays share
+	 *		  memory reused by the next event
+	 *	@param {('object'|'image'|'cov')} mode - delivery mode
+	 * 	@example etherlab.setDeliveryMode('cov');
+	 * */
+	setDeliveryMode(mode){
+		if(DELIVERY_MODES[mode] === undefined){
+			throw `Delivery mode must be 'object', 'image' or 'cov'`;
+		}
+
+		this._config.deliveryMode = mode;
+	}
+
+	/**
+	 *	Get static layout of process image, fetched once from C++ side
+	 *	@returns {Object[]} position, index, subindex, size, signed,
+	 *		direction and domain name of each element in process image.
+	 *		Element's index is the same as the handle returned by resolve()
+	 * 	@example const layout = etherlab.getLayout();
+	 * */
+	getLayout(){
+		if(this._config.layout === undefined){
+			this._config.layout = this._ecat.getLayout();
+		}
+
+		return this._config.layout;
+	}
+
+	/**
+	 *	Set change-of-value rule of an entry for 'cov' delivery. Without a
+	 *	rule, any change of an entry is delivered
+	 *	@param {number} handle - domain handle from resolve()
+	 *	@param {Object} [rule]
+	 *	@param {number} [rule.deadband=0] - changes up to deadband since last
+	 *		delivered value are ignored
+	 *	@param {number|bigint} [rule.mask] - only these bits of an integer
+	 *		entry are compared, all bits by default
+	 * 	@example etherlab.setCovRule(etherlab.resolve(2, 0x6000, 0x11), { deadband: 10 });
+	 *	@throws RangeError if handle isn't an entry of the process image
+	 * */
+	setCovRule(handle, rule = {}){
+		if(!Number.isInteger(handle) || handle < 0){
+			throw `Handle must be an integer and not less than 0`;
+		}
+
+		const { deadband = 0, mask } = rule;
+		this._ecat.setCovRule(handle, deadband, mask);
+	}
+
+	/**
+	 *	Remove all change-of-value rules, any change is delivered again
+	 * 	@example etherlab.clearCovRules();
+	 * */
+	clearCovRules(){
+		this._ecat.clearCovRules();
 	}
 
 	/**
@@ -120,7 +245,7 @@ class ECAT extends EventEmitter{
 		self.setSlaveConfig(configuration);
 		self.setFrequency(freq);
 
-		ecat.init(_config.slaveJSON);
+		this._ecat.init(this._config.slaveJSON);
 	}
 
 	/**
@@ -130,21 +255,21 @@ class ECAT extends EventEmitter{
 	_calcLatency(){
 		const self = this;
 
-		_cycle.latency.current = hrtime.bigint() - _cycle.timer;
-		_cycle.timer = hrtime.bigint();
+		this._cycle.latency.current = hrtime.bigint() - this._cycle.timer;
+		this._cycle.timer = hrtime.bigint();
 
-		if(_cycle.latency.last == 0n){
-			_cycle.latency.last = _cycle.latency.current;
+		if(this._cycle.latency.last == 0n){
+			this._cycle.latency.last = this._cycle.latency.current;
 			return;
 		}
 
-		_cycle.latency.diff = Math.abs(
-				Number(_cycle.latency.last - _cycle.latency.current)
+		this._cycle.latency.diff = Math.abs(
+				Number(this._cycle.latency.last - this._cycle.latency.current)
 			);
-		_cycle.latency.last = _cycle.latency.current;
+		this._cycle.latency.last = this._cycle.latency.current;
 
-		_average.jitter.add(Number(_cycle.latency.diff));
-		_average.latency.add(Number(_cycle.latency.current));
+		this._average.jitter.add(Number(this._cycle.latency.diff));
+		this._average.latency.add(Number(this._cycle.latency.current));
 	}
 
 	/**
@@ -153,7 +278,7 @@ class ECAT extends EventEmitter{
 	 * */
 	stop(){
 		const self = this;
-		ecat.stop();
+		this._ecat.stop();
 
 		// wait until Master state's OP flag is cleared
 		while((self.getMasterStateDetails()).OP);
@@ -167,27 +292,40 @@ class ECAT extends EventEmitter{
 	start(){
 		const self = this;
 
-		if(_config.slaveJSON === undefined){
+		if(this._config.slaveJSON === undefined){
 			throw 'Slave filepath is undefined!';
 		}
 
 		try{
-			_cycle.timer = hrtime.bigint();
-			self._timer = _cycle.timer;
+			this._cycle.timer = hrtime.bigint();
+			self._timer = this._cycle.timer;
 
-			ecat.start(async (...args) => {
+			const deliveryMode = this._config.deliveryMode;
+			const useImage = deliveryMode === 'image';
+			const useCov = deliveryMode === 'cov';
+
+			this._ecat.start(async (...args) => {
 				try{
 					const data = args[0];
 					const state = args[1];
+					const overrun = args[2];
+
+					if(overrun){
+						self._emit('overrun', overrun);
+					}
+
+					if(args[3]){
+						self._emit('underrun');
+					}
 					const masterState = self.getMasterStateDetails();
 					const isOperational = masterState.OP;
 
-					_config.data = data;
+					this._config.data = data;
 
-					if(_config.state != state){
+					if(this._config.state != state){
 						self._emit('state', state);
 
-						_config.state = state;
+						this._config.state = state;
 
 						if(!self.isReady && isOperational){
 							self._emit('ready', isOperational);
@@ -198,22 +336,37 @@ class ECAT extends EventEmitter{
 					// if master is not in OP state, skip emitting data
 					if(!isOperational){
 						// reset timer
-						_cycle.timer = hrtime.bigint();
-						self._timer = _cycle.timer;
+						this._cycle.timer = hrtime.bigint();
+						self._timer = this._cycle.timer;
+
+						// first event in OP carries every entry again
+						if(useCov){
+							this._ecat.covResync();
+						}
 						return;
 					}
 
 					const current = hrtime.bigint();
 					self._calcLatency();
 
-					if(!_config.interval || current - self._timer >= _config.interval){
-						self._emit('data', data, _cycle.latency.current);
+					if(useCov){
+						// changes are delivered once, never throttled
+						if(data.handles.length){
+							self._emit('data', data, this._cycle.latency.current);
+							self._timer = current;
+						}
+					}else if(!this._config.interval || current - self._timer >= this._config.interval){
+						self._emit('data', data, this._cycle.latency.current);
 						self._timer = hrtime.bigint();
 					}
 				} catch(error) {
 					console.error('start Error', error);
 				}
-			});
+			}, DELIVERY_MODES[deliveryMode]);
+
+			if(useImage || useCov){
+				this._config.layout = this._ecat.getLayout();
+			}
 		} catch(error) {
 			self._emit('error', error);
 		}
@@ -229,7 +382,7 @@ class ECAT extends EventEmitter{
 	 * 	@example etherlab.read(1, 0x7000, 0x01);
 	 * */
 	read(position, index, subindex){
-		return ecat.domainRead(position, index, subindex);
+		return this._ecat.domainRead(position, index, subindex);
 	}
 
 	/**
@@ -243,7 +396,7 @@ class ECAT extends EventEmitter{
 	 * 	@example etherlab.writeIndex(1, 0x7000, 0x01, 0x1fff);
 	 * */
 	write(position, index, subindex, value){
-		return ecat.domainWrite(position, index, subindex, value);
+		return this._ecat.domainWrite(position, index, subindex, value);
 	}
 
 	/**
@@ -256,7 +409,7 @@ class ECAT extends EventEmitter{
 	 * 	@example etherlab.read(1, 0x7000, 0x01);
 	 * */
 	domainRead(position, index, subindex){
-		return ecat.domainRead(position, index, subindex);
+		return this._ecat.domainRead(position, index, subindex);
 	}
 
 	/**
@@ -270,7 +423,76 @@ class ECAT extends EventEmitter{
 	 * 	@example etherlab.writeIndex(1, 0x7000, 0x01, 0x1fff);
 	 * */
 	domainWrite(position, index, subindex, value){
-		return ecat.domainWrite(position, index, subindex, value);
+		return this._ecat.domainWrite(position, index, subindex, value);
+	}
+
+	/**
+	 *	Resolve domain identified by slave position, index and subindex into
+	 *	a handle, to be used with readHandle() and writeHandle()
+	 *	@param {number} position - slave position
+	 *	@param {number} index - CoE index
+	 *	@param {number} subindex - CoE subindex
+	 *	@returns {number} handle if domain exists, otherwise returns -1
+	 * 	@example const handle = etherlab.resolve(1, 0x7000, 0x01);
+	 * */
+	resolve(position, index, subindex){
+		return this._ecat.resolve(position, index, subindex);
+	}
+
+	/**
+	 *	read value from domain identified by handle from resolve()
+	 *	@param {number} handle - domain handle
+	 *	@returns {number} domain value if handle is valid, otherwise undefined
+	 * 	@example etherlab.readHandle(handle);
+	 * */
+	readHandle(handle){
+		return this._ecat.domainReadHandle(handle);
+	}
+
+	/**
+	 *	Write value into domain identified by handle from resolve()
+	 *	@param {number} handle - domain handle
+	 *	@param {number} value - value to be written
+	 *	@returns {boolean} false if handle is invalid or master is not OP
+	 * 	@example etherlab.writeHandle(handle, 0x1fff);
+	 * */
+	writeHandle(handle, value){
+		return this._ecat.domainWriteHandle(handle, value);
+	}
+
+	/**
+	 *	Start a batch of writes. Following write() calls are staged and
+	 *	applied together within the same cycle after commitWrite()
+	 * 	@example etherlab.beginWrite();
+	 * */
+	beginWrite(){
+		this._ecat.domainWriteBegin();
+	}
+
+	/**
+	 *	Commit writes staged since beginWrite()
+	 *	@returns {boolean} true if batch is committed
+	 * 	@example etherlab.commitWrite();
+	 * */
+	commitWrite(){
+		return this._ecat.domainWriteCommit();
+	}
+
+	/**
+	 *	Start a batch of reads. Following read() calls return values from
+	 *	the same cycle until endRead() is called
+	 * 	@example etherlab.beginRead();
+	 * */
+	beginRead(){
+		this._ecat.domainReadBegin();
+	}
+
+	/**
+	 *	End batch of reads started by beginRead()
+	 * 	@example etherlab.endRead();
+	 * */
+	endRead(){
+		this._ecat.domainReadEnd();
 	}
 
 	/**
@@ -282,7 +504,7 @@ class ECAT extends EventEmitter{
 	 *		Will return undefine if mapped domain is empty
 	 * */
 	getMappedDomains(doPrint = false){
-		return ecat.getMappedDomains(doPrint);
+		return this._ecat.getMappedDomains(doPrint);
 	}
 
 	/**
@@ -295,13 +517,13 @@ class ECAT extends EventEmitter{
 	 * */
 	writeIndex(...args){
 		if(args.length === 2){
-			return ecat.writeIndex(args[0], args[1]);
+			return this._ecat.domainWriteHandle(args[0], args[1]);
 		}
 
 		if(typeof(args[0]) === 'object'){
 			const {index, value} = args[0];
 			if(index != undefined && value != undefined){
-				return ecat.writeIndex(index, value);
+				return this._ecat.domainWriteHandle(index, value);
 			}
 		}
 
@@ -313,18 +535,46 @@ class ECAT extends EventEmitter{
 	 *	@param {Object[]} arr - array of object
 	 *	@param {number} arr[].index - domain index
 	 *	@param {number} arr[].value - value to be written
-	 *	@returns {array} status of each write status
-	 * 	@example etherlab.writeIndex([{index: 1, value: 0x1fff} , {index: 2, value: 0x0000}]);
+	 *	@returns {array} status of each write status, all writes are applied
+	 *	within the same cycle or none of them is
+	 * 	@example etherlab.writeIndexes([{index: 1, value: 0x1fff} , {index: 2, value: 0x0000}]);
 	 * */
 	writeIndexes(arr){
-		const self = this;
+		const handles = new Int32Array(arr.length);
+		const values = new Float64Array(arr.length);
 
-		const statuses = [];
-		for(const item of arr){
-			statuses.push(self.writeIndex(item));
-		}
+		arr.forEach((item, i) => {
+			handles[i] = item.index;
+			values[i] = item.value;
+		});
+
+		const status = this.writeMany(handles, values);
+
+		return arr.map(() => status);
+	}
 
-		return statuses;
+	/**
+	 *	Read multiple domains in a single call. All values come from the
+	 *	same cycle
+	 *	@param {Int32Array|Uint32Array} handles - domain handles from resolve()
+	 *	@param {(Float64Array|BigInt64Array)} out - receives one value per handle
+	 *	@returns {boolean} false if any handle is invalid or master is not OP
+	 * 	@example etherlab.readMany(handles, new Float64Array(handles.length));
+	 * */
+	readMany(handles, out){
+		return this._ecat.domainReadMany(handles, out);
+	}
+
+	/**
+	 *	Write multiple domains in a single call. The batch is applied as a
+	 *	whole within the same cycle, nothing is written if any handle is invalid
+	 *	@param {Int32Array|Uint32Array} handles - domain handles from resolve()
+	 *	@param {(Float64Array|BigInt64Array)} values - one value per handle
+	 *	@returns {boolean} false if any handle is invalid or master is not OP
+	 * 	@example etherlab.writeMany(handles, new Float64Array([0x1fff, 0]));
+	 * */
+	writeMany(handles, values){
+		return this._ecat.domainWriteMany(handles, values);
 	}
 
 	/**
@@ -395,7 +645,7 @@ class ECAT extends EventEmitter{
 	 * */
 	setInterval(val, unit = 'ms'){
 		const self = this;
-		_config.interval = self._toNanoseconds(val, unit);
+		this._config.interval = self._toNanoseconds(val, unit);
 	}
 
 	/**
@@ -404,17 +654,365 @@ class ECAT extends EventEmitter{
 	 * 	@example const domain = await etherlab.getDomain();
 	 * */
 	getDomain(){
-		return ecat.getAllocatedDomain();
+		return this._ecat.getAllocatedDomain();
+	}
+
+	/**
+	 *	set CPU affinity and scheduling of cyclic thread, applied on start().
+	 *	Without it, cyclic thread runs SCHED_FIFO at highest priority on any CPU
+	 *	@param {Object} opts
+	 *	@param {number} [opts.cpu] - CPU to pin cyclic thread to, e.g. an isolcpus core, not with 'deadline'
+	 *	@param {('fifo'|'rr'|'deadline'|'other')} [opts.policy='fifo'] - scheduling policy
+	 *	@param {number} [opts.priority] - priority, highest of policy by default
+	 *	@param {number} [opts.runtime] - 'deadline' runtime in ns, half of deadline by default
+	 *	@param {number} [opts.deadline] - 'deadline' deadline in ns, period by default
+	 *	@param {number} [opts.period] - 'deadline' period in ns, cycle period by default
+	 * 	@example etherlab.setRealtime({ cpu: 3, policy: 'fifo', priority: 90 });
+	 * */
+	setRealtime(opts = {}){
+		this._ecat.setRtConfig(opts);
+	}
+
+	/**
+	 *	get CPU affinity and scheduling actually applied to cyclic thread
+	 * 	@returns {Object} cpus, policy, priority, deadline parameters and error
+	 *	if any setting was refused, undefined until cyclic thread has started
+	 * 	@example const { cpus, policy, priority } = etherlab.getRealtimeSettings();
+	 * */
+	getRealtimeSettings(){
+		return this._ecat.getRtSettings();
+	}
+
+	/**
+	 *	lock all current and future memory of the process with mlockall()
+	 *	before cyclic loop starts, so the loop never waits for a page fault.
+	 *	Applied on start(), released on stop()
+	 *	@param {boolean} [enable=true] - lock memory
+	 * 	@example etherlab.setMemoryLock(true);
+	 * */
+	setMemoryLock(enable = true){
+		this._ecat.setMemoryLock(enable);
+	}
+
+	/**
+	 *	get memory locking status and page faults of cyclic thread, until
+	 *	the loop started and since then. Loop faults are sampled every second
+	 * 	@returns {Object} locked, lockedBytes and pageFaults
+	 * 	@example const { pageFaults } = etherlab.getMemoryReport();
+	 * */
+	getMemoryReport(){
+		return this._ecat.getMemoryReport();
+	}
+
+	/**
+	 *	let the master's cycle follow the DC reference clock, instead of
+	 *	writing master time into the reference clock. Only takes effect if
+	 *	a slave has 'dc' configured, applied on start()
+	 *	@param {boolean} [enable=true] - compensate master clock drift
+	 * 	@example etherlab.setDcDriftCompensation(true);
+	 * */
+	setDcDriftCompensation(enable = true){
+		this._ecat.setDcDriftCompensation(enable);
+	}
+
+	/**
+	 *	get Distributed Clocks status of the master
+	 * 	@returns {Object} enabled, followReference, referencePosition,
+	 *		diff (last application time - reference clock, in ns) and
+	 *		adjust (drift correction per cycle, in ns)
+	 * 	@example const { diff } = etherlab.getDcStatus();
+	 * */
+	getDcStatus(){
+		return this._ecat.getDcStatus();
 	}
 
 	/**
-	 *	get calculated latency and jitter
+	 *	add a CiA 402 drive handled by the cyclic thread. Statusword and
+	 *	controlword must be mapped, the other objects are used if mapped.
+	 *	Axes can only be added or removed while stopped
+	 *	@param {Object} opts
+	 *	@param {number} opts.position - slave position
+	 *	@param {number} [opts.mode=8] - modes of operation written every
+	 *		cycle, 8 CSP, 9 CSV, -1 to leave it to the caller
+	 *	@param {boolean} [opts.autoFaultReset=false] - reset faults without
+	 *		calling resetAxisFault()
+	 *	@param {number} [opts.velocityFactor=1] - target velocity units per
+	 *		count/s, velocities of segments are given in counts/s
+	 *	@param {number} [opts.holdDeceleration=0] - deceleration in counts/s^2
+	 *		used when trajectory runs out while moving, 0 stops at once
+	 *	@param {number} [opts.controlword=0x6040] - object index, the same for
+	 *		statusword (0x6041), modeOfOperation (0x6060), targetPosition
+	 *		(0x607A), targetVelocity (0x60FF) and positionActual (0x6064)
+	 * 	@returns {number} axis number
+	 * 	@example const axis = etherlab.addAxis({ position: 1, mode: 8 });
+	 * */
+	addAxis(opts){
+		if(!opts || !Number.isInteger(opts.position) || opts.position < 0){
+			throw `Axis position must be an integer and not less than 0`;
+		}
+
+		const axis = this._ecat.axisAdd(opts);
+		if(axis < 0){
+			throw `Axis can't be added while master is running`;
+		}
+
+		return axis;
+	}
+
+	/**
+	 *	remove all axes, only while stopped
+	 * 	@example etherlab.clearAxes();
+	 * */
+	clearAxes(){
+		this._ecat.axisClear();
+	}
+
+	/**
+	 *	bring axis to 'operation enabled', one transition per cycle
+	 *	@param {number} axis - axis number
+	 * 	@example etherlab.enableAxis(axis);
+	 * */
+	enableAxis(axis){
+		return this._ecat.axisEnable(axis);
+	}
+
+	/**
+	 *	bring axis back to 'ready to switch on', power stage off
+	 *	@param {number} axis - axis number
+	 * 	@example etherlab.disableAxis(axis);
+	 * */
+	disableAxis(axis){
+		return this._ecat.axisDisable(axis);
+	}
+
+	/**
+	 *	stop axis with its quick stop ramp, it stays stopped until enabled
+	 *	again
+	 *	@param {number} axis - axis number
+	 * 	@example etherlab.quickStopAxis(axis);
+	 * */
+	quickStopAxis(axis){
+		return this._ecat.axisQuickStop(axis);
+	}
+
+	/**
+	 *	reset the fault axis is in, ignored if it isn't in fault
+	 *	@param {number} axis - axis number
+	 * 	@example etherlab.resetAxisFault(axis);
+	 * */
+	resetAxisFault(axis){
+		return this._ecat.axisFaultReset(axis);
+	}
+
+	/**
+	 *	queue setpoints, one is written per cycle while axis is in 'operation
+	 *	enabled'. Otherwise queue is emptied and target follows actual
+	 *	position. Same as 'setpoint' segments of pushSegments()
+	 *	@param {number} axis - axis number
+	 *	@param {Int32Array|Uint32Array} positions - target positions
+	 *	@param {Int32Array|Uint32Array} [velocities] - target velocities in counts/s,
+	 *		derived from positions if omitted or 0
+	 * 	@returns {number} setpoints queued, less than given if queue is full
+	 * 	@example const queued = etherlab.pushSetpoints(axis, Int32Array.of(100, 200));
+	 * */
+	pushSetpoints(axis, positions, velocities){
+		return this._ecat.axisPush(axis, positions, velocities);
+	}
+
+	/**
+	 *	queue trajectory segments, interpolated by the cyclic thread into one
+	 *	setpoint per cycle. Each segment starts where the previous one ended.
+	 *	A trajectory ending on 'linear' or 'setpoint' stops on its last
+	 *	position. If the queue runs dry while a 'pvt' moves, 'underrun' event
+	 *	is emitted and the axis is brought to a hold with holdDeceleration
+	 *	@param {number} axis - axis number
+	 *	@param {Object[]} segments
+	 *	@param {('setpoint'|'linear'|'pvt'|'move')} segments[].type -
+	 *		'setpoint' lasts one cycle, 'linear' reaches position with constant
+	 *		velocity after duration, 'pvt' reaches position and velocity after
+	 *		duration along a cubic, 'move' is a jerk-limited move from standstill
+	 *	@param {number} segments[].position - position at the end, in counts
+	 *	@param {number} [segments[].velocity=0] - velocity at the end in
+	 *		counts/s, 'pvt' and 'setpoint' only
+	 *	@param {number} [segments[].duration] - in ns, 'linear' and 'pvt' only
+	 *	@param {number} [segments[].maxVelocity] - counts/s, 'move' only
+	 *	@param {number} [segments[].maxAcceleration] - counts/s^2, 'move' only
+	 *	@param {number} [segments[].maxJerk] - counts/s^3, 'move' only
+	 * 	@returns {number} segments queued, less than given if queue is full
+	 * 	@example etherlab.pushSegments(axis, [{ type: 'pvt', position: 1000, velocity: 0, duration: 5e6 }]);
+	 * */
+	pushSegments(axis, segments){
+		if(!Array.isArray(segments)){
+			throw `Segments must be an array`;
+		}
+
+		const native = segments.map((segment) => {
+			const type = SEGMENT_TYPES[segment.type];
+
+			if(type === undefined){
+				throw `invalid segment type '${segment.type}'`;
+			}
+
+			return {...segment, type};
+		});
+
+		const queued = this._ecat.axisSubmit(axis, native);
+		if(queued < 0){
+			throw `Invalid segment or axis ${axis}`;
+		}
+
+		return queued;
+	}
+
+	/**
+	 *	queue a jerk-limited move to position, starting from standstill
+	 *	@param {number} axis - axis number
+	 *	@param {number} position - target position, in counts
+	 *	@param {Object} limits
+	 *	@param {number} limits.maxVelocity - counts/s
+	 *	@param {number} limits.maxAcceleration - counts/s^2
+	 *	@param {number} limits.maxJerk - counts/s^3
+	 * 	@returns {boolean} move is queued
+	 * 	@example etherlab.moveAxis(axis, 100000, { maxVelocity: 5e4, maxAcceleration: 2e5, maxJerk: 2e6 });
+	 * */
+	moveAxis(axis, position, limits){
+		return this.pushSegments(axis, [{ ...limits, type: 'move', position }]) === 1;
+	}
+
+	/**
+	 *	get axis state as seen by the cyclic thread
+	 *	@param {number} axis - axis number
+	 * 	@returns {Object} statusword, controlword, state, stateName,
+	 *		positionActual, targetPosition, targetVelocity, queued (segments),
+	 *		holding, underruns and faults
+	 * 	@example const { stateName } = etherlab.getAxisStatus(axis);
+	 * */
+	getAxisStatus(axis){
+		const status = this._ecat.axisStatus(axis);
+		if(status){
+			status.stateName = AXIS_STATES[status.state];
+		}
+
+		return status;
+	}
+
+	/**
+	 *	record process data of every cycle in OP into an append-only binary
+	 *	file. The cyclic thread only copies each cycle into memory, the file
+	 *	is written by a low priority thread. Started before start(), the
+	 *	file is opened when the master starts. Cycles are dropped, never
+	 *	waited for, if the file falls behind, see getRecordingStatus()
+	 *	@param {string} path - file to write, replaced if it exists
+	 *	@param {Object} [opts]
+	 *	@param {Array<(number|Object)>} [opts.entries] - handles from
+	 *		resolve() or { position, index, subindex } of entries to record,
+	 *		all domains are recorded as they are if omitted
+	 *	@param {number} [opts.ringSize] - cycles buffered in memory, 2 s of
+	 *		cycles by default
+	 * 	@example etherlab.startRecording('/tmp/run.ecrec', { entries: [{ position: 1, index: 0x6064, subindex: 0 }] });
+	 * */
+	startRecording(path, opts = {}){
+		const { entries, ringSize = 0 } = opts;
+
+		let handles;
+		if(entries){
+			handles = Int32Array.from(entries, (entry) => {
+				const handle = typeof entry === 'number'
+					? entry
+					: this._ecat.resolve(entry.position, entry.index, entry.subindex);
+
+				if(!Number.isInteger(handle) || handle < 0){
+					throw `Entry ${JSON.stringify(entry)} is not mapped`;
+				}
+
+				return handle;
+			});
+		}
+
+		if(this._ecat.recordStart(path, handles, ringSize) < 0){
+			throw `Recording to '${path}' can't be started`;
+		}
+	}
+
+	/**
+	 *	stop recording, the file is complete once this returns. Recording
+	 *	also ends when the master stops
+	 * 	@example etherlab.stopRecording();
+	 * */
+	stopRecording(){
+		this._ecat.recordStop();
+	}
+
+	/**
+	 *	get recording state
+	 * 	@returns {Object} active, pending (waits for start()), path,
+	 *		records (written to file), dropped (cycles lost) and bytes
+	 * 	@example const { dropped } = etherlab.getRecordingStatus();
+	 * */
+	getRecordingStatus(){
+		return this._ecat.getRecordStatus();
+	}
+
+	/**
+	 *	read a file written by startRecording(), also while it is being
+	 *	written. The file is mapped and decoded into one Float64Array per
+	 *	entry, so a range of records keeps memory bounded for long runs
+	 *	@param {string} path - recording file
+	 *	@param {Object} [opts]
+	 *	@param {number} [opts.first=0] - first record to read
+	 *	@param {number} [opts.count] - records to read, all by default
+	 * 	@returns {Object} header, entries (position, index, subindex, size,
+	 *		domain, signed, output), first, cycles and timestamps
+	 *		(BigUint64Array, CLOCK_MONOTONIC ns) and values (Float64Array per
+	 *		entry)
+	 * 	@example const { entries, timestamps, values } = ECAT.readRecording('/tmp/run.ecrec');
+	 * */
+	static readRecording(path, opts = {}){
+		const { first = 0, count } = opts;
+
+		return ecat.readRecording(path, first, count);
+	}
+
+	/**
+	 *	set how cyclic thread handles cycles missed because of an overrun.
+	 *	'skip' drops missed cycles and realigns to the period grid, 'burst'
+	 *	runs up to maxBurst missed cycles back-to-back and drops the rest.
+	 *	'overrun' event is emitted whenever a cycle overran
+	 *	@param {('skip'|'burst')} [mode='skip'] - overrun policy
+	 *	@param {number} [maxBurst=0] - most cycles run back-to-back in 'burst'
+	 * 	@example etherlab.setOverrunPolicy('burst', 2);
+	 * */
+	setOverrunPolicy(mode = 'skip', maxBurst = 0){
+		if(mode !== 'skip' && mode !== 'burst'){
+			throw `invalid overrun policy '${mode}'`;
+		}
+
+		this._ecat.setOverrunPolicy(mode === 'burst' ? 1 : 0, maxBurst);
+	}
+
+	/**
+	 *	get cycle timing measured by the cyclic thread itself, in ns.
+	 *	latency is actual vs. scheduled wakeup, execution is time spent in a
+	 *	cycle, period is time between two frame sends. Each has count, min,
+	 *	max, mean, p50, p90, p99, p999 and p9999. jitter is the worst period
+	 *	deviation, overruns counts cycles which ended past next wakeup and
+	 *	skipped counts cycles dropped by overrun policy
+	 *	@param {boolean} [reset=false] - start a new measurement window
+	 * 	@returns {Object} cycle timing statistics
+	 * 	@example const { jitter, period } = etherlab.getCycleStats();
+	 * */
+	getCycleStats(reset = false){
+		return this._ecat.getCycleStats(reset);
+	}
+
+	/**
+	 *	get calculated latency and jitter of data event, as seen by event loop
 	 * 	@returns {Object} latency and jitter
 	 * 	@example etherlab.getLatencyAndJitter('us');
 	 * */
 	getLatencyAndJitter(unit = 'us'){
 		const self = this;
-		const values = _average.values;
+		const values = this._average.values;
 
 		for(const key in values){
 			values[key] = self.fromNanoseconds(values[key], unit);
@@ -423,13 +1021,24 @@ class ECAT extends EventEmitter{
 		return {...values, unit};
 	}
 
+	/**
+	 *	get counters of process data handed from cyclic task to JS.
+	 *	Cyclic task never waits for JS, if JS is late only the latest
+	 *	process data is delivered and the older ones are counted as coalesced
+	 * 	@returns {Object} published, delivered, coalesced and dropped counters
+	 * 	@example etherlab.getDeliveryStats();
+	 * */
+	getDeliveryStats(){
+		return this._ecat.getDeliveryStats();
+	}
+
 	/**
 	 *	get current ethercat master state
 	 * 	@returns {number} master state
 	 * 	@example etherlab.getMasterState();
 	 * */
 	getMasterState(){
-		return ecat.getMasterState();
+		return this._ecat.getMasterState();
 	}
 
 	/**
@@ -462,66 +1071,107 @@ class ECAT extends EventEmitter{
 	 * 	@example const domain = await etherlab.getValues();
 	 * */
 	getValues(){
-		return ecat.getDomainValues();
+		return this._ecat.getDomainValues();
+	}
+
+	/**
+	 *	Resolve SDO type into transfer size and signedness
+	 * 	@private
+	 *	@param {string} type - SDO type
+	 *	@returns {Object} size in bytes and signedness
+	 * */
+	_sdoType(type){
+		switch(type){
+			case 'uint8': return { size: 1, signed: false };
+			case 'int8': return { size: 1, signed: true };
+			case 'uint16': return { size: 2, signed: false };
+			case 'int16': return { size: 2, signed: true };
+			case 'uint32': return { size: 4, signed: false };
+			case 'int32': return { size: 4, signed: true };
+			case 'uint64': return { size: 8, signed: false };
+			case 'int64': return { size: 8, signed: true };
+			default: {
+				throw new Error(`invalid type '${type}'\n`);
+			} break;
+		}
 	}
 
 	/**
 	 *	Read SDO value
-	 *	Will throw error if SDO doesn't exist
+	 *	Transfer is done by a native worker thread, event loop is not blocked.
+	 *	Promise is rejected with abortCode and message if slave aborts the
+	 *	transfer, or with code 'ETIMEDOUT' if request can't be sent in time
 	 *	@param {number} position - slave position
 	 *	@param {number} index - SDO index
 	 *	@param {number} subindex - SDO subindex
 	 *	@param {string} type - SDO type
-	 *	@param {number} [timeout=100] - timeout in ms
-	 * 	@returns {number} SDO value
-	 * 	@example const domain = etherlab.sdoRead(3, 0x1c32, 0x1);
+	 *	@param {Object} [opts]
+	 *	@param {number} [opts.timeout=1000] - timeout in ms, 0 takes the default
+	 * 	@returns {Promise<number|BigInt>} SDO value, 64-bit types as BigInt
+	 * 	@example const value = await etherlab.sdoRead(3, 0x1c32, 0x1, 'uint16');
 	 * */
 	sdoRead(position, index, subindex, type, opts = {}){
-		const self = this;
-
-		const { timeout, verbose } = opts;
-
-		let size;
-		switch(type){
-			case 'uint8': size = 1; break;
-			case 'uint16': size = 2; break;
-			case 'uint32': size = 4; break;
-			default: {
-				throw new Error(`invalid type '%{type}'\n`);
-			} break;
-		}
+		const { timeout } = opts;
+		const { size, signed } = this._sdoType(type);
 
-		return ecat.sdoRead(position, index, subindex, size, timeout, Number(verbose));
+		return this._ecat.sdoReadAsync(position, index, subindex, size, signed, timeout);
 	}
 
 	/**
 	 *	Write SDO value
-	 *	Will throw error if SDO doesn't exist
-	 *	@param {number} value - value to write
+	 *	Transfer is done by a native worker thread, event loop is not blocked.
+	 *	Promise is rejected with abortCode and message if slave aborts the
+	 *	transfer, or with code 'ETIMEDOUT' if request can't be sent in time
 	 *	@param {number} position - slave position
 	 *	@param {number} index - SDO index
 	 *	@param {number} subindex - SDO subindex
 	 *	@param {string} type - SDO type
-	 *	@param {number} [timeout=100] - timeout in ms
-	 * 	@returns {number} SDO value
-	 * 	@example const domain = etherlab.sdoRead(3, 0x1c32, 0x1);
+	 *	@param {(number|BigInt)} value - value to write
+	 *	@param {Object} [opts]
+	 *	@param {number} [opts.timeout=1000] - timeout in ms, 0 takes the default
+	 * 	@returns {Promise<boolean>} resolved once slave accepted the value
+	 * 	@example await etherlab.sdoWrite(3, 0x1c32, 0x1, 'uint16', 2);
 	 * */
 	sdoWrite(position, index, subindex, type, value, opts = {}){
-		const self = this;
+		const { timeout } = opts;
+		const { size, signed } = this._sdoType(type);
 
-		const { timeout, verbose } = opts;
+		return this._ecat.sdoWriteAsync(position, index, subindex, size, signed, timeout, value);
+	}
 
-		let size;
-		switch(type){
-			case 'uint8': size = 1; break;
-			case 'uint16': size = 2; break;
-			case 'uint32': size = 4; break;
-			default: {
-				throw new Error(`invalid type '${type}'\n`);
-			} break;
-		}
+	/**
+	 *	Read and write many SDOs at once. Transfers to different slaves run
+	 *	concurrently, transfers to the same slave run in the given order.
+	 *	Promise is never rejected because of a failed transfer, each result
+	 *	carries either value or error
+	 *	@param {Object[]} list - transfers, a transfer with value is a write
+	 *	@param {number} list[].position - slave position
+	 *	@param {number} list[].index - SDO index
+	 *	@param {number} list[].subindex - SDO subindex
+	 *	@param {string} list[].type - SDO type
+	 *	@param {(number|BigInt)} [list[].value] - value to write
+	 *	@param {Object} [opts]
+	 *	@param {number} [opts.timeout=1000] - timeout in ms for bulk to start
+	 * 	@returns {Promise<Object[]>} one { value } or { error } per transfer
+	 * 	@example const results = await etherlab.sdoBulk([
+	 * 		{ position: 1, index: 0x1c32, subindex: 0x1, type: 'uint16' },
+	 * 		{ position: 2, index: 0x8000, subindex: 0x1, type: 'int16', value: -100 },
+	 * 	]);
+	 * */
+	sdoBulk(list, opts = {}){
+		const { timeout } = opts;
+
+		const requests = list.map(({ position, index, subindex, type, value }) => {
+			const { size, signed } = this._sdoType(type);
+
+			return {
+				position, index, subindex, size, signed,
+				write: value !== undefined,
+				value,
+			};
+		});
 
-		return ecat.sdoWrite(value, position, index, subindex, size, timeout, Number(verbose));
+		return this._ecat.sdoBulk(requests, timeout);
 	}
 }
 
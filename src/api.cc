@@ -1,305 +1,2456 @@
 #include <etherlab-helper.h>
+#include <HdrHistogram.hpp>
 #include <TimespecHelper.hpp>
+#include <TripleBuffer.hpp>
 #include <napi.h>
 
+#include "etherlab-helper/src/recorder.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+
 #ifndef NSEC_PER_SEC
 #define NSEC_PER_SEC 1000000000
 #endif
 
-static int8_t running_state = -1;
-static uint32_t period_ns = 0;
+/****************************** Master Instance ********************************
+ *
+ * Every EtherCAT master opened by JS has its own cyclic thread, statistics
+ * and scheduling. Exported functions are bound to one instance, which is
+ * selected for EcatHelper calls on entry.
+ *
+ * ****************************************************************************/
+
+struct ProcessSnapshot {
+	std::vector<EcatHelper::ecat_image_value_al> values;
+	uint8_t al_states = 0;
+
+	// cumulative overruns when snapshot was taken
+	uint64_t overruns = 0;
+
+	// cumulative axis trajectory underruns when snapshot was taken
+	uint64_t underruns = 0;
+};
+
+struct DeliveryStats {
+	// snapshots produced by cyclic thread
+	std::atomic<uint64_t> published { 0 };
+
+	// snapshots passed to JS callback
+	std::atomic<uint64_t> delivered { 0 };
+
+	// snapshots overwritten by a newer one before JS could take it
+	std::atomic<uint64_t> coalesced { 0 };
+
+	// snapshots which couldn't be announced to JS, i.e. full queue
+	std::atomic<uint64_t> dropped { 0 };
+};
+
+// measured by cyclic thread itself, in ns
+struct CycleStats {
+	// actual wakeup vs. scheduled wakeup
+	HdrHistogram latency;
+
+	// main_routine() execution time
+	HdrHistogram execution;
+
+	// time between two consecutive frame sends
+	HdrHistogram period;
+
+	// cycles which ended after next wakeup was due
+	std::atomic<uint64_t> overruns { 0 };
+
+	// cycles dropped by overrun policy
+	std::atomic<uint64_t> skipped { 0 };
+};
+
+enum OverrunMode : uint8_t {
+	// drop missed cycles and realign to the period grid
+	OVERRUN_SKIP = 0,
+
+	// run missed cycles back-to-back, at most max_burst of them
+	OVERRUN_BURST = 1,
+};
+
+struct OverrunPolicy {
+	std::atomic<uint8_t> mode { OVERRUN_SKIP };
+	std::atomic<uint32_t> max_burst { 0 };
+};
+
+#ifndef SCHED_DEADLINE
+#define SCHED_DEADLINE 6
+#endif
+
+// sched_setattr() has no glibc wrapper on older systems
+struct ecat_sched_attr {
+	uint32_t size;
+	uint32_t sched_policy;
+	uint64_t sched_flags;
+	int32_t sched_nice;
+	uint32_t sched_priority;
+	uint64_t sched_runtime;
+	uint64_t sched_deadline;
+	uint64_t sched_period;
+};
+
+// scheduling of cyclic thread, requested by JS and applied by the thread
+struct RtConfig {
+	// CPU to pin cyclic thread to, -1 leaves affinity untouched
+	int32_t cpu = -1;
+
+	int32_t policy = SCHED_FIFO;
+
+	// 0 means the highest priority of policy
+	int32_t priority = 0;
+
+	// SCHED_DEADLINE parameters in ns, 0 means derived from cycle period
+	uint64_t runtime = 0;
+	uint64_t deadline = 0;
+	uint64_t period = 0;
+};
+
+// what cyclic thread actually ended up with
+struct RtApplied {
+	RtConfig config;
+	std::vector<int32_t> cpus;
+	std::string error;
+	std::atomic<bool> ready { false };
+};
+
+// change-of-value rule of one process data entry
+struct CovRule {
+	// change smaller than or equal to deadband isn't delivered
+	double deadband = 0;
+
+	// only these bits of integer value are compared, all bits means the
+	// value is compared as it is, i.e. floating point entries too
+	uint64_t mask = UINT64_MAX;
+};
+
+enum DeliveryMode {
+	DELIVERY_OBJECT = 0,
+	DELIVERY_IMAGE = 1,
+	DELIVERY_COV = 2,
+};
+
+struct MasterInstance {
+	EcatHelper::Master* master = nullptr;
+
+	int8_t running_state = -1;
+	uint32_t period_ns = 0;
+
+	DeliveryStats delivery_stats;
+	CycleStats cycle_stats;
+	OverrunPolicy overrun_policy;
+
+	RtConfig rt_config;
+	RtApplied rt_applied;
+
+	// set while a drain of cyclic SDO completions is queued
+	std::atomic<bool> sdo_drain_pending { false };
+
+	// indexed by handle, one per process image entry
+	std::vector<CovRule> cov_rules;
+
+	// next change-of-value delivery carries every entry
+	bool cov_resync = false;
+};
+
+// instances are never freed, functions bound to them may outlive JS objects
+static std::map<uint32_t, std::unique_ptr<MasterInstance>> instances;
+
+static MasterInstance* open_instance(const uint32_t& index)
+{
+	std::unique_ptr<MasterInstance>& instance = instances[index];
+
+	if (!instance) {
+		instance.reset(new MasterInstance());
+		instance->master = EcatHelper::open_master(index);
+	}
+
+	return instance.get();
+}
+
+// instance the called function is bound to, also used by EcatHelper calls
+static MasterInstance* bind_master(const Napi::CallbackInfo& info)
+{
+	MasterInstance* instance = static_cast<MasterInstance*>(info.Data());
+
+	EcatHelper::use_master(instance->master);
+
+	return instance;
+}
+
+/************************** End of Master Instance *****************************/
+
+/******************************* SDO Worker ************************************
+ *
+ * Blocking SDO transfers are serviced by a dedicated native thread, so the
+ * event loop keeps running while a slave mailbox is busy. While the cyclic
+ * thread is running, transfers go through its preallocated ecrt_sdo_request
+ * pool instead. Either way each request is settled through a Promise once
+ * its transfer finishes.
+ *
+ * ****************************************************************************/
+
+#define SDO_DEFAULT_TIMEOUT_MS 1000
+
+struct SdoJob;
+
+// what the tag of a pooled transfer points to, idx is the bulk position
+struct SdoTicket {
+	SdoJob* job = nullptr;
+	uint32_t idx = 0;
+};
+
+struct SdoJob {
+	SdoJob(Napi::Env env) : deferred(Napi::Promise::Deferred::New(env)) {};
+
+	Napi::Promise::Deferred deferred;
+
+	// master the transfer is done on
+	EcatHelper::Master* master = nullptr;
+
+	EcatHelper::ecat_pos_al position = 0;
+	EcatHelper::ecat_index_al index = 0;
+	EcatHelper::ecat_sub_al subindex = 0;
+	EcatHelper::sdo_req_type_al rtype = EcatHelper::ECAT_SDO_READ;
+	size_t size = 0;
+	bool is_signed = false;
+	EcatHelper::ecat_value_al value = {};
+
+	// request is dropped if it can't be dispatched before deadline
+	std::chrono::steady_clock::time_point deadline = {};
+	bool timed_out = false;
+
+	int32_t retval = 0;
+	uint32_t abort_code = 0;
+
+	SdoTicket ticket;
+
+	// bulk request, transfers fanned out across slaves by the worker, or
+	// queued to the cyclic thread while bus is running
+	bool is_bulk = false;
+	std::vector<EcatHelper::ecat_sdo_job_al> batch;
+	std::vector<bool> batch_signed;
+	std::vector<SdoTicket> batch_tickets;
+
+	// paces pooled transfers to the request queue of each slave, only
+	// touched on JS thread
+	EcatHelper::SDO::Batch pooled;
+};
+
+struct SdoWorker {
+	std::thread thread;
+	std::mutex lock;
+	std::condition_variable wakeup;
+	std::deque<SdoJob*> queue;
+	bool running = false;
+
+	Napi::ThreadSafeFunction tsfn;
+
+	// unsettled requests, only touched on JS thread
+	uint32_t in_flight = 0;
+};
+
+static SdoWorker sdo_worker;
+
+static Napi::Value sdo_value(Napi::Env env, const size_t& size,
+	const bool& is_signed, const EcatHelper::ecat_value_al& value)
+{
+	switch (size) {
+
+	case 1: {
+		return Napi::Number::New(env, is_signed ? value.i8 : value.u8);
+	} break;
+
+	case 2: {
+		return Napi::Number::New(env, is_signed ? value.i16 : value.u16);
+	} break;
+
+	case 4: {
+		return Napi::Number::New(env, is_signed ? value.i32 : value.u32);
+	} break;
+
+	default: {
+		return is_signed ? Napi::BigInt::New(env, value.i64)
+						 : Napi::BigInt::New(env, value.u64);
+	} break;
+
+	}
+}
+
+// request never reached the slave, or the slave never answered
+static Napi::Error sdo_errno_error(Napi::Env env, const int32_t& retval)
+{
+	bool busy = retval == EcatHelper::SDO::ECAT_SDO_REQ_ERR_BUSY;
+
+	Napi::Error err = Napi::Error::New(env,
+		busy ? "SDO request queue is full" : "SDO request timeout");
+	err.Set("code", Napi::String::New(env, busy ? "EBUSY" : "ETIMEDOUT"));
+
+	return err;
+}
+
+static bool is_errno_retval(const int32_t& retval)
+{
+	return retval == EcatHelper::SDO::ECAT_SDO_REQ_ERR_BUSY
+		|| retval == EcatHelper::SDO::ECAT_SDO_REQ_ERR_TIMEOUT;
+}
+
+static Napi::Error sdo_error(Napi::Env env, const int32_t& retval,
+	const uint32_t& abort_code)
+{
+	Napi::Error err = Napi::Error::New(env,
+		abort_code ? EcatHelper::sdo_error_message(abort_code)
+				   : std::string("SDO transfer failed"));
+	err.Set("code", Napi::Number::New(env, retval));
+	err.Set("abortCode", Napi::Number::New(env, abort_code));
+
+	return err;
+}
+
+// bulk request never rejects, each transfer reports its own outcome
+static void sdo_settle_batch(Napi::Env env, SdoJob* job)
+{
+	size_t count = job->batch.size();
+	Napi::Array results = Napi::Array::New(env, count);
+
+	for (size_t idx = 0; idx < count; idx++) {
+		const EcatHelper::ecat_sdo_job_al& transfer = job->batch[idx];
+		Napi::Object result = Napi::Object::New(env);
+
+		if (job->timed_out) {
+			result.Set("error",
+				sdo_errno_error(env, EcatHelper::SDO::ECAT_SDO_REQ_ERR_TIMEOUT)
+					.Value());
+		} else if (is_errno_retval(transfer.retval)) {
+			result.Set("error", sdo_errno_error(env, transfer.retval).Value());
+		} else if (transfer.retval) {
+			result.Set("error",
+				sdo_error(env, transfer.retval, transfer.abort_code).Value());
+		} else if (transfer.rtype == EcatHelper::ECAT_SDO_READ) {
+			result.Set("value",
+				sdo_value(env, transfer.size, job->batch_signed[idx],
+					transfer.value));
+		} else {
+			result.Set("value", Napi::Boolean::New(env, true));
+		}
+
+		results[idx] = result;
+	}
+
+	job->deferred.Resolve(results);
+}
+
+static void sdo_settle(Napi::Env env, Napi::Function, SdoJob* job)
+{
+	if (job->is_bulk) {
+		sdo_settle_batch(env, job);
+	} else if (job->timed_out) {
+		job->deferred.Reject(
+			sdo_errno_error(env, EcatHelper::SDO::ECAT_SDO_REQ_ERR_TIMEOUT)
+				.Value());
+	} else if (is_errno_retval(job->retval)) {
+		job->deferred.Reject(sdo_errno_error(env, job->retval).Value());
+	} else if (job->retval) {
+		job->deferred.Reject(
+			sdo_error(env, job->retval, job->abort_code).Value());
+	} else if (job->rtype == EcatHelper::ECAT_SDO_WRITE) {
+		job->deferred.Resolve(Napi::Boolean::New(env, true));
+	} else {
+		job->deferred.Resolve(
+			sdo_value(env, job->size, job->is_signed, job->value));
+	}
+
+	delete job;
+
+	// idle worker must not keep node alive
+	if (!--sdo_worker.in_flight) {
+		sdo_worker.tsfn.Unref(env);
+	}
+}
+
+static void sdo_drain(
+	Napi::Env env, Napi::Function js_cb, MasterInstance* instance)
+{
+	instance->sdo_drain_pending.store(false, std::memory_order_release);
+	EcatHelper::use_master(instance->master);
+
+	EcatHelper::ecat_sdo_job_al done;
+
+	while (EcatHelper::sdo_request_poll(&done)) {
+		SdoTicket* ticket = reinterpret_cast<SdoTicket*>(done.tag);
+		SdoJob* job = ticket->job;
+
+		if (job->is_bulk) {
+			EcatHelper::ecat_sdo_job_al& transfer = job->batch[ticket->idx];
+			transfer.value = done.value;
+			transfer.retval = done.retval;
+
+			// queued transfers are failed once the bus is stopped, the
+			// rest must not be queued to requests nobody services
+			if (instance->running_state != 1) {
+				job->pooled.cancel();
+			}
+
+			// next transfer of the slave takes the freed queue slot
+			if (job->pooled.complete()) {
+				continue;
+			}
+		} else {
+			job->value = done.value;
+			job->retval = done.retval;
+		}
+
+		sdo_settle(env, js_cb, job);
+	}
+}
+
+// called by cyclic thread, wakes JS thread up if any SDO request finished
+static void sdo_drain_notify(MasterInstance* instance)
+{
+	if (!EcatHelper::sdo_request_completed()
+		|| instance->sdo_drain_pending.exchange(
+			true, std::memory_order_acq_rel)) {
+
+		return;
+	}
+
+	if (sdo_worker.tsfn.NonBlockingCall(instance, sdo_drain) != napi_ok) {
+		instance->sdo_drain_pending.store(false, std::memory_order_release);
+	}
+}
+
+static void sdo_worker_entry()
+{
+	for (;;) {
+		SdoJob* job;
+
+		{
+			std::unique_lock<std::mutex> guard(sdo_worker.lock);
+			sdo_worker.wakeup.wait(guard, [] {
+				return !sdo_worker.running || !sdo_worker.queue.empty();
+			});
+
+			if (!sdo_worker.running) {
+				break;
+			}
+
+			job = sdo_worker.queue.front();
+			sdo_worker.queue.pop_front();
+		}
+
+		EcatHelper::use_master(job->master);
+
+		if (std::chrono::steady_clock::now() > job->deadline) {
+			job->timed_out = true;
+		} else if (job->is_bulk) {
+			EcatHelper::SDO::transfer_many(job->batch.data(), job->batch.size());
+		} else if (job->rtype == EcatHelper::ECAT_SDO_READ) {
+			size_t result_size = 0;
+			job->retval = EcatHelper::sdo_upload(job->position, job->index,
+				job->subindex, job->size, &result_size, job->value.bytes,
+				&job->abort_code);
+		} else {
+			job->retval = EcatHelper::sdo_download(job->position, job->index,
+				job->subindex, job->size, job->value.bytes, &job->abort_code);
+		}
+
+		if (sdo_worker.tsfn.BlockingCall(job, sdo_settle) != napi_ok) {
+			delete job;
+		}
+	}
+
+	sdo_worker.tsfn.Release();
+}
+
+static void sdo_worker_cleanup(void*)
+{
+	{
+		std::lock_guard<std::mutex> guard(sdo_worker.lock);
+		sdo_worker.running = false;
+	}
+
+	sdo_worker.wakeup.notify_one();
+	sdo_worker.thread.join();
+
+	// requests left in queue are never settled, environment is going away
+	for (SdoJob* job : sdo_worker.queue) {
+		delete job;
+	}
+	sdo_worker.queue.clear();
+}
+
+static void sdo_worker_start(Napi::Env env)
+{
+	if (sdo_worker.running) {
+		return;
+	}
+
+	sdo_worker.tsfn = Napi::ThreadSafeFunction::New(env,
+		Napi::Function::New(env, [](const Napi::CallbackInfo&) {}),
+		"EcatSdoWorker",
+		0, // Unlimited queue, every completion must be settled
+		1);
+	sdo_worker.tsfn.Unref(env);
+
+	sdo_worker.running = true;
+	sdo_worker.thread = std::thread(sdo_worker_entry);
+
+	napi_add_env_cleanup_hook(env, sdo_worker_cleanup, nullptr);
+}
+
+// 0 or no timeout at all takes the default, a request never waits forever
+static uint32_t sdo_timeout(const Napi::Value& value)
+{
+	uint32_t timeout_ms = value.IsNumber() ? value.As<Napi::Number>().Uint32Value() : 0;
+
+	return timeout_ms ? timeout_ms : SDO_DEFAULT_TIMEOUT_MS;
+}
+
+static void sdo_enqueue(SdoJob* job)
+{
+	{
+		std::lock_guard<std::mutex> guard(sdo_worker.lock);
+		sdo_worker.queue.push_back(job);
+	}
+
+	sdo_worker.wakeup.notify_one();
+}
+
+static Napi::Value sdo_submit(const Napi::CallbackInfo& info,
+	const EcatHelper::sdo_req_type_al& rtype)
+{
+	Napi::Env env = info.Env();
+	MasterInstance* instance = bind_master(info);
+
+	sdo_worker_start(env);
+
+	SdoJob* job = new SdoJob(env);
+	job->master = instance->master;
+	job->rtype = rtype;
+	job->position = info[0].As<Napi::Number>().Uint32Value();
+	job->index = info[1].As<Napi::Number>().Uint32Value();
+	job->subindex = info[2].As<Napi::Number>().Uint32Value();
+	job->size = std::min<size_t>(info[3].As<Napi::Number>().Uint32Value(),
+		sizeof(job->value.u64));
+	job->is_signed = info[4].ToBoolean();
+
+	uint32_t timeout_ms = sdo_timeout(info[5]);
+	job->deadline = std::chrono::steady_clock::now()
+		+ std::chrono::milliseconds(timeout_ms);
+
+	if (rtype == EcatHelper::ECAT_SDO_WRITE) {
+		if (info[6].IsBigInt()) {
+			bool lossless;
+			job->value.i64 = info[6].As<Napi::BigInt>().Int64Value(&lossless);
+		} else {
+			job->value.i64 = info[6].As<Napi::Number>().Int64Value();
+		}
+	}
+
+	Napi::Promise promise = job->deferred.Promise();
+
+	if (!sdo_worker.in_flight++) {
+		sdo_worker.tsfn.Ref(env);
+	}
+
+	// while bus is running, transfers are driven by cyclic thread
+	// without blocking anybody
+	if (instance->running_state == 1) {
+		job->ticket.job = job;
+
+		EcatHelper::ecat_sdo_job_al request;
+		request.tag = reinterpret_cast<uint64_t>(&job->ticket);
+		request.position = job->position;
+		request.index = job->index;
+		request.subindex = job->subindex;
+		request.size = job->size;
+		request.rtype = job->rtype;
+		request.timeout = timeout_ms;
+		request.value = job->value;
+
+		if ((job->retval = EcatHelper::sdo_request_submit(request))) {
+			sdo_settle(env, Napi::Function(), job);
+		}
+
+		return promise;
+	}
+
+	sdo_enqueue(job);
+
+	return promise;
+}
+
+Napi::Value js_sdo_read_async(const Napi::CallbackInfo& info)
+{
+	return sdo_submit(info, EcatHelper::ECAT_SDO_READ);
+}
+
+Napi::Value js_sdo_write_async(const Napi::CallbackInfo& info)
+{
+	return sdo_submit(info, EcatHelper::ECAT_SDO_WRITE);
+}
+
+/*
+ * Bulk transfer, takes an array of
+ * { position, index, subindex, size, signed, write, value } and an optional
+ * timeout in ms. Resolves with one { value } or { error } per transfer
+ */
+Napi::Value js_sdo_bulk(const Napi::CallbackInfo& info)
+{
+	Napi::Env env = info.Env();
+	MasterInstance* instance = bind_master(info);
+
+	sdo_worker_start(env);
+
+	Napi::Array requests = info[0].As<Napi::Array>();
+	uint32_t count = requests.Length();
+
+	SdoJob* job = new SdoJob(env);
+	Napi::Promise promise = job->deferred.Promise();
+
+	if (!count) {
+		job->deferred.Resolve(Napi::Array::New(env));
+		delete job;
+
+		return promise;
+	}
+
+	job->master = instance->master;
+	job->is_bulk = true;
+	job->batch.resize(count);
+	job->batch_signed.resize(count);
+
+	for (uint32_t idx = 0; idx < count; idx++) {
+		Napi::Object request = requests.Get(idx).As<Napi::Object>();
+		EcatHelper::ecat_sdo_job_al& transfer = job->batch[idx];
+
+		transfer.position = request.Get("position").As<Napi::Number>().Uint32Value();
+		transfer.index = request.Get("index").As<Napi::Number>().Uint32Value();
+		transfer.subindex = request.Get("subindex").As<Napi::Number>().Uint32Value();
+		transfer.size = std::min<size_t>(
+			request.Get("size").As<Napi::Number>().Uint32Value(),
+			sizeof(transfer.value.u64));
+		job->batch_signed[idx] = request.Get("signed").ToBoolean();
+		transfer.rtype = request.Get("write").ToBoolean()
+			? EcatHelper::ECAT_SDO_WRITE : EcatHelper::ECAT_SDO_READ;
+
+		if (transfer.rtype == EcatHelper::ECAT_SDO_WRITE) {
+			Napi::Value value = request.Get("value");
+
+			if (value.IsBigInt()) {
+				bool lossless;
+				transfer.value.i64 = value.As<Napi::BigInt>().Int64Value(&lossless);
+			} else {
+				transfer.value.i64 = value.As<Napi::Number>().Int64Value();
+			}
+		}
+	}
+
+	uint32_t timeout_ms = sdo_timeout(info[1]);
+	job->deadline = std::chrono::steady_clock::now()
+		+ std::chrono::milliseconds(timeout_ms);
+
+	if (!sdo_worker.in_flight++) {
+		sdo_worker.tsfn.Ref(env);
+	}
+
+	// while bus is running, blocking transfers would stall the mailbox of
+	// the running bus, they are queued to cyclic thread one by one instead,
+	// as many per slave as its request queue takes
+	if (instance->running_state == 1) {
+		job->batch_tickets.resize(count);
+
+		for (uint32_t idx = 0; idx < count; idx++) {
+			EcatHelper::ecat_sdo_job_al& transfer = job->batch[idx];
+
+			job->batch_tickets[idx] = { job, idx };
+			transfer.tag = reinterpret_cast<uint64_t>(&job->batch_tickets[idx]);
+			transfer.timeout = timeout_ms;
+		}
+
+		job->pooled.assign(job->batch.data(), count);
+
+		// nothing got queued, drain will never see this job
+		if (!job->pooled.submit()) {
+			sdo_settle(env, Napi::Function(), job);
+		}
+
+		return promise;
+	}
+
+	sdo_enqueue(job);
+
+	return promise;
+}
+
+/*************************** End of SDO Worker ********************************/
+
+/************************** Thread Safe Function *******************************
+ *
+ * https://napi.inspiredware.com/special-topics/thread-safe-functions.html
+ *
+ * ****************************************************************************/
+
+struct TsfnContext {
+	TsfnContext(Napi::Env env) : deferred(Napi::Promise::Deferred::New(env)) {};
+
+	// Native Promise returned to JavaScript
+	Napi::Promise::Deferred deferred;
+
+	// Native thread
+	std::thread nativeThread;
+
+	Napi::ThreadSafeFunction tsfn;
+
+	DeliveryMode delivery = DELIVERY_OBJECT;
+
+	// process image passed to JS callback, allocated once
+	Napi::Reference<Napi::Float64Array> image;
+
+	// change-of-value delivery, values last passed to JS and buffers of
+	// changed handles and values, allocated once
+	std::vector<EcatHelper::ecat_image_value_al> cov_last;
+	bool cov_primed = false;
+	uint8_t cov_states = 0;
+	Napi::Reference<Napi::ArrayBuffer> cov_handles;
+	Napi::Reference<Napi::ArrayBuffer> cov_values;
+
+	// static part of process data, i.e. position, index, subindex, etc.
+	std::vector<EcatHelper::ecat_slave_entry_al>* domain_data = nullptr;
+
+	// latest snapshot handed from cyclic thread to JS thread
+	TripleBuffer<ProcessSnapshot> mailbox;
+
+	// set while a JS call is queued, so cyclic thread queues at most one
+	std::atomic<bool> pending { false };
+
+	// overruns and underruns of last snapshot passed to JS
+	uint64_t delivered_overruns = 0;
+	uint64_t delivered_underruns = 0;
+
+	MasterInstance* instance = nullptr;
+};
+
+void finalizer_cb(Napi::Env env, void *finalizeData, TsfnContext *context)
+{
+	// Join the thread
+	context->nativeThread.join();
+
+	// Resolve the Promise previously returned to JS via the js_create_thread method.
+	context->deferred.Resolve(Napi::Boolean::New(env, true));
+	delete context;
+}
+
+static void rt_error(RtApplied* rt_applied, const char* what)
+{
+	perror(what);
+
+	if (!rt_applied->error.empty()) {
+		rt_applied->error += "; ";
+	}
+	rt_applied->error += std::string(what) + ": " + strerror(errno);
+}
+
+// called by cyclic thread on itself, before entering the loop
+static void apply_rt_config(MasterInstance* instance)
+{
+	const RtConfig& config = instance->rt_config;
+	RtApplied& rt_applied = instance->rt_applied;
+
+	rt_applied.error.clear();
+
+	if (config.cpu >= 0) {
+		cpu_set_t cpuset;
+		CPU_ZERO(&cpuset);
+		CPU_SET(config.cpu, &cpuset);
+
+		if (pthread_setaffinity_np(pthread_self(), sizeof(cpuset), &cpuset)) {
+			rt_error(&rt_applied, "pthread_setaffinity_np failed");
+		}
+	}
+
+	if (config.policy == SCHED_DEADLINE) {
+		struct ecat_sched_attr attr = {};
+		attr.size = sizeof(attr);
+		attr.sched_policy = SCHED_DEADLINE;
+		attr.sched_period = config.period ? config.period : instance->period_ns;
+		attr.sched_deadline = config.deadline ? config.deadline
+			: attr.sched_period;
+		attr.sched_runtime = config.runtime ? config.runtime
+			: attr.sched_deadline / 2;
+
+		if (syscall(SYS_sched_setattr, 0, &attr, 0) == -1) {
+			rt_error(&rt_applied, "sched_setattr failed");
+		}
+	} else {
+		struct sched_param param = {};
+		param.sched_priority = config.priority
+			? config.priority : sched_get_priority_max(config.policy);
+
+		if (sched_setscheduler(0, config.policy, &param) == -1) {
+			rt_error(&rt_applied, "sched_setscheduler failed");
+		}
+	}
+
+	// report settings as seen by the kernel
+	RtConfig& applied = rt_applied.config;
+	applied = config;
+
+	struct ecat_sched_attr attr = {};
+	if (syscall(SYS_sched_getattr, 0, &attr, sizeof(attr), 0) == 0) {
+		applied.policy = attr.sched_policy;
+		applied.priority = attr.sched_priority;
+		applied.runtime = attr.sched_runtime;
+		applied.deadline = attr.sched_deadline;
+		applied.period = attr.sched_period;
+	} else {
+		applied.policy = sched_getscheduler(0);
+	}
+
+	cpu_set_t cpuset;
+	rt_applied.cpus.clear();
+	if (!pthread_getaffinity_np(pthread_self(), sizeof(cpuset), &cpuset)) {
+		for (int32_t cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+			if (CPU_ISSET(cpu, &cpuset)) {
+				rt_applied.cpus.push_back(cpu);
+			}
+		}
+	}
+
+	rt_applied.ready.store(true, std::memory_order_release);
+}
+
+// two's complement bits of an integer entry value, out of range saturates
+static uint64_t cov_bits(const double& value)
+{
+	if (value < 0) {
+		return value >= -9223372036854775808.0 ? (uint64_t)(int64_t)value
+											   : (uint64_t)INT64_MIN;
+	}
+
+	return value < 18446744073709551616.0 ? (uint64_t)value : UINT64_MAX;
+}
+
+// collects entries changed since their last delivery, first call takes all
+static size_t cov_collect(TsfnContext* context, const ProcessSnapshot& snapshot,
+	int32_t* handles, EcatHelper::ecat_image_value_al* values)
+{
+	// sized to the image at start, entries without rule hold default one
+	const std::vector<CovRule>& rules = context->instance->cov_rules;
+
+	std::vector<EcatHelper::ecat_image_value_al>& last = context->cov_last;
+	size_t length = snapshot.values.size();
+	size_t count = 0;
+
+	if (context->instance->cov_resync) {
+		context->instance->cov_resync = false;
+		context->cov_primed = false;
+	}
+
+	for (size_t idx = 0; idx < length; idx++) {
+		double value = snapshot.values[idx];
+		const CovRule& rule = rules[idx];
+
+		double delta;
+		if (rule.mask == UINT64_MAX) {
+			delta = value - last[idx];
+		} else {
+			delta = (double)(cov_bits(value) & rule.mask)
+				- (double)(cov_bits(last[idx]) & rule.mask);
+		}
+
+		bool changed = rule.deadband > 0 ? std::fabs(delta) > rule.deadband
+										 : delta != 0;
+
+		if (context->cov_primed && !changed) {
+			continue;
+		}
+
+		last[idx] = value;
+		handles[count] = idx;
+		values[count] = value;
+		count++;
+	}
+
+	context->cov_primed = true;
+
+	return count;
+}
+
+void thread_entry(TsfnContext *context) {
+	MasterInstance* instance = context->instance;
+	DeliveryStats& delivery_stats = instance->delivery_stats;
+	CycleStats& cycle_stats = instance->cycle_stats;
+	OverrunPolicy& overrun_policy = instance->overrun_policy;
+	const uint32_t period_ns = instance->period_ns;
+
+	// every EcatHelper call of this thread goes to its own master
+	EcatHelper::use_master(instance->master);
+
+	auto routine_cb = [](Napi::Env env, Napi::Function js_cb,
+		TsfnContext* context) {
+
+		// clear before taking snapshot, so newer one will queue another call
+		context->pending.store(false, std::memory_order_release);
+
+		if (!context->mailbox.update()) {
+			return;
+		}
+
+		context->instance->delivery_stats.delivered.fetch_add(
+			1, std::memory_order_relaxed);
+
+		const ProcessSnapshot& snapshot = context->mailbox.front();
+		Napi::Value states = Napi::Number::New(env, snapshot.al_states);
+
+		// any cycle overran since previous delivery, including coalesced ones.
+		// counters come along, so JS needn't query the whole cycle stats
+		Napi::Value overrun = Napi::Boolean::New(env, false);
+		if (snapshot.overruns != context->delivered_overruns) {
+			Napi::Object counters = Napi::Object::New(env);
+			counters.Set("overruns", Napi::Number::New(env, snapshot.overruns));
+			counters.Set("skipped", Napi::Number::New(env,
+				context->instance->cycle_stats.skipped.load(
+					std::memory_order_relaxed)));
+
+			overrun = counters;
+		}
+		context->delivered_overruns = snapshot.overruns;
+
+		// any axis ran out of trajectory while moving
+		Napi::Value underrun = Napi::Boolean::New(env,
+			snapshot.underruns != context->delivered_underruns);
+		context->delivered_underruns = snapshot.underruns;
+
+		if (context->delivery == DELIVERY_COV) {
+			Napi::ArrayBuffer handle_buffer = context->cov_handles.Value();
+			Napi::ArrayBuffer value_buffer = context->cov_values.Value();
+
+			size_t count = cov_collect(context, snapshot,
+				(int32_t*)handle_buffer.Data(),
+				(EcatHelper::ecat_image_value_al*)value_buffer.Data());
+
+			// nothing JS would act on, skip the call altogether
+			if (!count && snapshot.al_states == context->cov_states
+				&& !overrun.ToBoolean() && !underrun.ToBoolean()) {
+				return;
+			}
+			context->cov_states = snapshot.al_states;
+
+			Napi::Object changes = Napi::Object::New(env);
+			changes.Set("handles",
+				Napi::Int32Array::New(env, count, handle_buffer, 0));
+			changes.Set("values",
+				Napi::Float64Array::New(env, count, value_buffer, 0));
+
+			js_cb.Call({ changes, states, overrun, underrun });
+			return;
+		}
+
+		if (context->delivery == DELIVERY_IMAGE) {
+			Napi::Float64Array image = context->image.Value();
+			std::copy(snapshot.values.begin(), snapshot.values.end(),
+				image.Data());
+
+			js_cb.Call({ image, states, overrun, underrun });
+			return;
+		}
+
+		std::vector<EcatHelper::ecat_slave_entry_al>* domain_data
+			= context->domain_data;
+
+		size_t pd_size = domain_data->size();
+		Napi::Array array = Napi::Array::New(env, pd_size);
+
+		for(size_t dmn_idx = 0; dmn_idx < pd_size; dmn_idx++){
+			Napi::Object elem = Napi::Object::New(env);
+
+			elem.Set("position", Napi::Value::From(env, domain_data->at(dmn_idx).position));
+			elem.Set("index", Napi::Value::From(env, (*domain_data).at(dmn_idx).index));
+			elem.Set("subindex", Napi::Value::From(env, (*domain_data).at(dmn_idx).subindex));
+			elem.Set("size", Napi::Value::From(env, domain_data->at(dmn_idx).size));
+			elem.Set("value", Napi::Number::New(env, snapshot.values[dmn_idx]));
+
+			array[dmn_idx] = elem;
+		}
+
+		js_cb.Call({ array, states, overrun, underrun });
+	};
+
+	struct timespec wakeup_time;
+
+	/* Set affinity, policy and priority */
+	apply_rt_config(instance);
+
+	EcatHelper::prerun_routine();
+
+	clock_gettime(CLOCK_MONOTONIC, &wakeup_time);
+	wakeup_time.tv_sec += 1; /* start in future */
+	wakeup_time.tv_nsec = 0;
+
+	instance->running_state = 1;
+
+	struct timespec wakeup_actual, send_time, last_send_time = {}, now;
+	int64_t elapsed_ns;
+	uint64_t overruns = 0;
+
+	while (1) {
+		clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wakeup_time, NULL);
+		clock_gettime(CLOCK_MONOTONIC, &wakeup_actual);
+
+		Timespec::diff(wakeup_actual, wakeup_time, &elapsed_ns);
+		cycle_stats.latency.record(std::max<int64_t>(elapsed_ns, 0));
+
+		if (!instance->running_state) {
+			fprintf(stderr, "\nBreak Cyclic Process (master %d)\n",
+				EcatHelper::master_index());
+			context->tsfn.Abort();
+			break;
+		}
+
+		// decode process data straight into snapshot owned by this thread
+		ProcessSnapshot& snapshot = context->mailbox.back();
+		EcatHelper::attach_process_image(
+			snapshot.values.data(), snapshot.values.size());
+
+		// DC application time is the scheduled wakeup, free of latency
+		EcatHelper::set_application_time(Timespec::to_ns(wakeup_time));
+
+		EcatHelper::main_routine();
+
+		// frame is sent at the end of main_routine()
+		clock_gettime(CLOCK_MONOTONIC, &send_time);
+
+		Timespec::diff(send_time, wakeup_actual, &elapsed_ns);
+		cycle_stats.execution.record(elapsed_ns);
+
+		if (last_send_time.tv_sec) {
+			Timespec::diff(send_time, last_send_time, &elapsed_ns);
+			cycle_stats.period.record(elapsed_ns);
+		}
+		last_send_time = send_time;
+
+		// frame went out after next one was due
+		Timespec::diff(send_time, wakeup_time, &elapsed_ns);
+		if (elapsed_ns > period_ns) {
+			overruns++;
+			cycle_stats.overruns.store(overruns, std::memory_order_relaxed);
+		}
+
+		sdo_drain_notify(instance);
+
+		snapshot.al_states = EcatHelper::application_layer_states();
+		snapshot.overruns = overruns;
+		snapshot.underruns = EcatHelper::axis_underruns();
+		delivery_stats.published.fetch_add(1, std::memory_order_relaxed);
+
+		if (context->mailbox.publish()) {
+			delivery_stats.coalesced.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		// never wait for JS, if a call is still queued it will pick up
+		// the latest snapshot anyway
+		if (!context->pending.exchange(true, std::memory_order_acq_rel)) {
+			napi_status status
+				= context->tsfn.NonBlockingCall(context, routine_cb);
+
+			if (status != napi_ok) {
+				context->pending.store(false, std::memory_order_release);
+				delivery_stats.dropped.fetch_add(1, std::memory_order_relaxed);
+			}
+		}
+
+		// with drift compensation, master follows DC reference clock
+		Timespec::copy(&wakeup_time, wakeup_time,
+			period_ns + EcatHelper::dc_wakeup_adjust());
+
+		// behind schedule, either realign or let a capped number of
+		// missed cycles run back-to-back
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		Timespec::diff(now, wakeup_time, &elapsed_ns);
+
+		if (elapsed_ns > 0) {
+			uint64_t missed = elapsed_ns / period_ns + 1;
+			uint64_t allowed
+				= overrun_policy.mode.load(std::memory_order_relaxed)
+					== OVERRUN_BURST
+				? overrun_policy.max_burst.load(std::memory_order_relaxed)
+				: 0;
+
+			if (missed > allowed) {
+				uint64_t skip = missed - allowed;
+
+				Timespec::copy(&wakeup_time, wakeup_time, skip * period_ns);
+				cycle_stats.skipped.fetch_add(skip, std::memory_order_relaxed);
+			}
+		}
+	}
+
+	EcatHelper::detach_process_image();
+	EcatHelper::postrun_routine();
+
+	// requests cancelled by postrun are settled as well
+	sdo_drain_notify(instance);
+}
+/********************** End of Thread Safe Function ***************************/
+
+Napi::Value js_thread_start(const Napi::CallbackInfo &info)
+{
+	Napi::Env env = info.Env();
+	MasterInstance* instance = bind_master(info);
+
+	// Construct context data
+	auto _ctx = new TsfnContext(env);
+	_ctx->instance = instance;
+
+	// Create a new ThreadSafeFunction.
+	_ctx->tsfn = Napi::ThreadSafeFunction::New(
+			env, // Environment
+			info[0].As<Napi::Function>(), // JS function from caller
+			"EcatThread", // Resource name
+			1, // Max queue size, only the latest snapshot is ever delivered
+			1, // Initial thread count
+			_ctx, // Context,
+			finalizer_cb, // Finalizer
+			(void *)nullptr	// Finalizer data
+		);
+
+	// process data must be known before the cyclic thread starts,
+	// every buffer exchanged with JS is allocated here once
+	EcatHelper::init();
+	EcatHelper::attach_process_data(&_ctx->domain_data);
+
+	size_t length = _ctx->domain_data->size();
+	_ctx->mailbox.for_each([length](ProcessSnapshot& snapshot) {
+		snapshot.values.assign(length, 0);
+	});
+
+	// optional zero-allocation delivery, the same Float64Array is passed to
+	// JS callback every cycle, or only changed entries are passed
+	if (info.Length() > 1 && info[1].IsNumber()) {
+		_ctx->delivery = (DeliveryMode)info[1].As<Napi::Number>().Uint32Value();
+	} else if (info.Length() > 1 && info[1].ToBoolean()) {
+		_ctx->delivery = DELIVERY_IMAGE;
+	}
+
+	if (_ctx->delivery == DELIVERY_IMAGE) {
+		_ctx->image = Napi::Reference<Napi::Float64Array>::New(
+			Napi::Float64Array::New(env, length), 1);
+	}
+
+	if (_ctx->delivery == DELIVERY_COV) {
+		instance->cov_rules.resize(length);
+		_ctx->cov_last.assign(length, 0);
+		_ctx->cov_primed = false;
+		_ctx->cov_states = 0;
+		_ctx->cov_handles = Napi::Reference<Napi::ArrayBuffer>::New(
+			Napi::ArrayBuffer::New(env, length * sizeof(int32_t)), 1);
+		_ctx->cov_values = Napi::Reference<Napi::ArrayBuffer>::New(
+			Napi::ArrayBuffer::New(env,
+				length * sizeof(EcatHelper::ecat_image_value_al)), 1);
+	}
+
+	DeliveryStats& delivery_stats = instance->delivery_stats;
+	delivery_stats.published = 0;
+	delivery_stats.delivered = 0;
+	delivery_stats.coalesced = 0;
+	delivery_stats.dropped = 0;
+
+	CycleStats& cycle_stats = instance->cycle_stats;
+	cycle_stats.latency.reset();
+	cycle_stats.execution.reset();
+	cycle_stats.period.reset();
+	cycle_stats.overruns = 0;
+	cycle_stats.skipped = 0;
+	_ctx->delivered_overruns = 0;
+	_ctx->delivered_underruns = EcatHelper::axis_underruns();
+
+	instance->period_ns = EcatHelper::get_period();
+	instance->rt_applied.ready = false;
+
+	// cyclic thread resolves axes in prerun routine, none may be added
+	// or removed from here on
+	EcatHelper::axis_freeze();
+
+	_ctx->nativeThread = std::thread(thread_entry, _ctx);
+
+	return _ctx->deferred.Promise();
+}
+
+Napi::Value js_thread_stop(const Napi::CallbackInfo &info)
+{
+	Napi::Env env = info.Env();
+	MasterInstance* instance = bind_master(info);
+
+	instance->running_state = 0;
+
+	return Napi::Number::New(env, instance->running_state);
+}
+
+Napi::Value js_init(const Napi::CallbackInfo& info)
+{
+	Napi::Env env = info.Env();
+	bind_master(info);
+
+	EcatHelper::init();
+
+	return Napi::Boolean::New(env, true);
+}
+
+Napi::Value js_set_json_path(const Napi::CallbackInfo& info)
+{
+	Napi::Env env = info.Env();
+	bind_master(info);
+
+	std::string json_path = info[0].As<Napi::String>();
+
+	EcatHelper::set_json_path(json_path);
+
+	return Napi::Boolean::New(env, true);
+}
+
+Napi::Value js_set_frequency(const Napi::CallbackInfo& info)
+{
+	Napi::Env env = info.Env();
+	MasterInstance* instance = bind_master(info);
+
+	uint32_t frequency = info[0].As<Napi::Number>();
+
+	EcatHelper::set_frequency(frequency);
+	instance->period_ns = EcatHelper::get_period();
+
+	return Napi::Number::New(env, instance->period_ns);
+}
+
+Napi::Value js_set_output_refresh(const Napi::CallbackInfo& info)
+{
+	Napi::Env env = info.Env();
+	bind_master(info);
+
+	uint32_t cycles = info[0].As<Napi::Number>().Uint32Value();
+
+	EcatHelper::set_output_refresh(cycles);
+
+	return Napi::Number::New(env, cycles);
+}
+
+Napi::Value js_domain_write(const Napi::CallbackInfo& info)
+{
+	Napi::Env env = info.Env();
+	bind_master(info);
+
+	EcatHelper::ecat_pos_al pos = info[0].As<Napi::Number>().Uint32Value();
+	EcatHelper::ecat_index_al index = info[1].As<Napi::Number>().Uint32Value();
+	EcatHelper::ecat_sub_al subindex = info[2].As<Napi::Number>().Uint32Value();
+	EcatHelper::ecat_value_al value = {};
+	value.u32 = info[3].As<Napi::Number>().Uint32Value();
+
+	if(EcatHelper::domain_write(pos, index, subindex, value)){
+		return Napi::Boolean::New(env, false);
+	}
+
+	return Napi::Boolean::New(env, true);
+}
+
+Napi::Value js_domain_read(const Napi::CallbackInfo& info)
+{
+	Napi::Env env = info.Env();
+	bind_master(info);
+
+	EcatHelper::ecat_pos_al pos = info[0].As<Napi::Number>().Uint32Value();
+	EcatHelper::ecat_index_al index = info[1].As<Napi::Number>().Uint32Value();
+	EcatHelper::ecat_sub_al subindex = info[2].As<Napi::Number>().Uint32Value();
+	EcatHelper::ecat_value_al value = {};
+
+	if(EcatHelper::domain_read(pos, index, subindex, &value)){
+		return env.Undefined();
+	}
+
+	return Napi::Number::New(env, value.u32);
+}
+
+static double to_number(const EcatHelper::ecat_slave_entry_al& entry,
+	const EcatHelper::ecat_value_al& value)
+{
+	switch(entry.size){
+
+	case 1: {
+		return value.u8 & 0x1;
+	} break;
+
+	case 8: {
+		return entry.is_signed ? value.i8 : value.u8;
+	} break;
+
+	case 16: {
+		return entry.is_signed ? value.i16 : value.u16;
+	} break;
+
+	case 32: {
+		return entry.is_signed ? value.i32 : value.u32;
+	} break;
+
+	default: {
+		return entry.is_signed ? value.i64 : value.u64;
+	} break;
+
+	}
+}
+
+Napi::Value js_domain_resolve(const Napi::CallbackInfo& info)
+{
+	Napi::Env env = info.Env();
+	bind_master(info);
+
+	EcatHelper::ecat_pos_al pos = info[0].As<Napi::Number>().Uint32Value();
+	EcatHelper::ecat_index_al index = info[1].As<Napi::Number>().Uint32Value();
+	EcatHelper::ecat_sub_al subindex = info[2].As<Napi::Number>().Uint32Value();
+
+	return Napi::Number::New(env,
+		EcatHelper::domain_resolve(pos, index, subindex));
+}
+
+Napi::Value js_domain_write_handle(const Napi::CallbackInfo& info)
+{
+	Napi::Env env = info.Env();
+	bind_master(info);
+
+	EcatHelper::ecat_size_io_al handle = info[0].As<Napi::Number>().Int32Value();
+	EcatHelper::ecat_value_al value = {};
+	value.i64 = info[1].As<Napi::Number>().Int64Value();
+
+	if(EcatHelper::domain_write(handle, value)){
+		return Napi::Boolean::New(env, false);
+	}
+
+	return Napi::Boolean::New(env, true);
+}
+
+Napi::Value js_domain_read_handle(const Napi::CallbackInfo& info)
+{
+	Napi::Env env = info.Env();
+	bind_master(info);
+
+	EcatHelper::ecat_size_io_al handle = info[0].As<Napi::Number>().Int32Value();
+	EcatHelper::ecat_value_al value = {};
+
+	if(EcatHelper::domain_read(handle, &value)){
+		return env.Undefined();
+	}
+
+	std::vector<EcatHelper::ecat_slave_entry_al>* domain_data;
+	EcatHelper::attach_process_data(&domain_data);
+
+	return Napi::Number::New(env, to_number(domain_data->at(handle), value));
+}
+
+static int64_t to_int64(const EcatHelper::ecat_slave_entry_al& entry,
+	const EcatHelper::ecat_value_al& value)
+{
+	switch(entry.size){
+
+	case 1: {
+		return value.u8 & 0x1;
+	} break;
+
+	case 8: {
+		return entry.is_signed ? value.i8 : value.u8;
+	} break;
+
+	case 16: {
+		return entry.is_signed ? value.i16 : value.u16;
+	} break;
+
+	case 32: {
+		return entry.is_signed ? value.i32 : value.u32;
+	} break;
+
+	default: {
+		return value.i64;
+	} break;
+
+	}
+}
+
+/*
+ * Batch calls reuse one scratch buffer, only grown when a larger
+ * batch comes in
+ */
+static std::vector<uint64_t> batch_scratch;
+
+/*
+ * Handles and setpoints come as Int32Array or Uint32Array, both are read as
+ * int32. A handle above INT32_MAX turns negative and is rejected like any
+ * other invalid handle
+ */
+static bool is_int32_array(const Napi::Value& value)
+{
+	if(!value.IsTypedArray()){
+		return false;
+	}
+
+	napi_typedarray_type type = value.As<Napi::TypedArray>().TypedArrayType();
+
+	return type == napi_int32_array || type == napi_uint32_array;
+}
+
+static const int32_t* int32_data(const Napi::TypedArray& array)
+{
+	return reinterpret_cast<const int32_t*>(
+		static_cast<const uint8_t*>(array.ArrayBuffer().Data()) + array.ByteOffset());
+}
+
+/*
+ * Raw value of a JS number, false if it is NaN, infinite or out of the
+ * range of int64 and uint64, where casting would be undefined
+ */
+static bool number_to_raw(const double& value, uint64_t* raw)
+{
+	if(!(value >= -9223372036854775808.0 && value < 18446744073709551616.0)){
+		return false;
+	}
+
+	*raw = value < 0 ? (uint64_t)(int64_t)value : (uint64_t)value;
+
+	return true;
+}
+
+static bool batch_args(const Napi::CallbackInfo& info,
+	Napi::TypedArray* handles, Napi::TypedArray* values)
+{
+	Napi::Env env = info.Env();
+
+	if(!info[0].IsTypedArray() || !info[1].IsTypedArray()){
+		Napi::TypeError::New(env, "Expected (Int32Array|Uint32Array, Float64Array|BigInt64Array)").ThrowAsJavaScriptException();
+		return false;
+	}
+
+	*handles = info[0].As<Napi::TypedArray>();
+	*values = info[1].As<Napi::TypedArray>();
+
+	if(!is_int32_array(info[0])){
+		Napi::TypeError::New(env, "Handles must be an Int32Array or Uint32Array").ThrowAsJavaScriptException();
+		return false;
+	}
+
+	if(values->TypedArrayType() != napi_float64_array &&
+		values->TypedArrayType() != napi_bigint64_array){
+		Napi::TypeError::New(env, "Values must be a Float64Array or BigInt64Array").ThrowAsJavaScriptException();
+		return false;
+	}
+
+	if(values->ElementLength() < handles->ElementLength()){
+		Napi::RangeError::New(env, "Values shorter than handles").ThrowAsJavaScriptException();
+		return false;
+	}
+
+	if(batch_scratch.size() < handles->ElementLength()){
+		batch_scratch.resize(handles->ElementLength());
+	}
+
+	return true;
+}
+
+Napi::Value js_domain_write_many(const Napi::CallbackInfo& info)
+{
+	Napi::Env env = info.Env();
+	bind_master(info);
+	Napi::TypedArray handles;
+	Napi::TypedArray values;
+
+	if(!batch_args(info, &handles, &values)){
+		return env.Undefined();
+	}
+
+	size_t count = handles.ElementLength();
+
+	if(values.TypedArrayType() == napi_bigint64_array){
+		const int64_t* in = values.As<Napi::BigInt64Array>().Data();
+
+		for(size_t i = 0; i < count; i++){
+			batch_scratch[i] = in[i];
+		}
+	}else{
+		const double* in = values.As<Napi::Float64Array>().Data();
+
+		// batch is applied as a whole or not at all
+		for(size_t i = 0; i < count; i++){
+			if(!number_to_raw(in[i], &batch_scratch[i])){
+				Napi::RangeError::New(env, "Values must be finite 64-bit integers").ThrowAsJavaScriptException();
+				return env.Undefined();
+			}
+		}
+	}
+
+	if(EcatHelper::domain_write_many(int32_data(handles), count, batch_scratch.data())){
+		return Napi::Boolean::New(env, false);
+	}
+
+	return Napi::Boolean::New(env, true);
+}
+
+Napi::Value js_domain_read_many(const Napi::CallbackInfo& info)
+{
+	Napi::Env env = info.Env();
+	bind_master(info);
+	Napi::TypedArray handles;
+	Napi::TypedArray values;
+
+	if(!batch_args(info, &handles, &values)){
+		return env.Undefined();
+	}
+
+	size_t count = handles.ElementLength();
+	const int32_t* index = int32_data(handles);
+
+	if(EcatHelper::domain_read_many(index, count, batch_scratch.data())){
+		return Napi::Boolean::New(env, false);
+	}
+
+	std::vector<EcatHelper::ecat_slave_entry_al>* domain_data;
+	EcatHelper::attach_process_data(&domain_data);
+
+	EcatHelper::ecat_value_al value;
+
+	if(values.TypedArrayType() == napi_bigint64_array){
+		int64_t* out = values.As<Napi::BigInt64Array>().Data();
+
+		for(size_t i = 0; i < count; i++){
+			value.u64 = batch_scratch[i];
+			out[i] = to_int64((*domain_data)[index[i]], value);
+		}
+	}else{
+		double* out = values.As<Napi::Float64Array>().Data();
+
+		for(size_t i = 0; i < count; i++){
+			value.u64 = batch_scratch[i];
+			out[i] = to_number((*domain_data)[index[i]], value);
+		}
+	}
+
+	return Napi::Boolean::New(env, true);
+}
+
+Napi::Value js_domain_write_begin(const Napi::CallbackInfo& info)
+{
+	Napi::Env env = info.Env();
+	bind_master(info);
+
+	EcatHelper::domain_write_begin();
+
+	return env.Undefined();
+}
+
+Napi::Value js_domain_write_commit(const Napi::CallbackInfo& info)
+{
+	Napi::Env env = info.Env();
+	bind_master(info);
+
+	if(EcatHelper::domain_write_commit()){
+		return Napi::Boolean::New(env, false);
+	}
+
+	return Napi::Boolean::New(env, true);
+}
+
+Napi::Value js_domain_read_begin(const Napi::CallbackInfo& info)
+{
+	Napi::Env env = info.Env();
+	bind_master(info);
+
+	EcatHelper::domain_read_begin();
+
+	return env.Undefined();
+}
+
+Napi::Value js_domain_read_end(const Napi::CallbackInfo& info)
+{
+	Napi::Env env = info.Env();
+	bind_master(info);
+
+	EcatHelper::domain_read_end();
+
+	return env.Undefined();
+}
+
+Napi::Value js_sdo_read(const Napi::CallbackInfo& info)
+{
+	Napi::Env env = info.Env();
+	bind_master(info);
+
+	EcatHelper::ecat_pos_al pos = info[0].As<Napi::Number>().Uint32Value();
+	EcatHelper::ecat_index_al index = info[1].As<Napi::Number>().Uint32Value();
+	EcatHelper::ecat_sub_al subindex = info[2].As<Napi::Number>().Uint32Value();
+	size_t size = info[3].As<Napi::Number>().Uint32Value();
+	size_t result_size = 0;
+	EcatHelper::ecat_value_al value = {};
+
+	if(EcatHelper::sdo_upload(
+		pos, index, subindex, size, &result_size, value.bytes)){
+
+		return env.Undefined();
+	}
+
+	return Napi::Number::New(env, value.u32);
+}
+
+Napi::Value js_sdo_write(const Napi::CallbackInfo& info)
+{
+	Napi::Env env = info.Env();
+	bind_master(info);
+
+	EcatHelper::ecat_pos_al pos = info[0].As<Napi::Number>().Uint32Value();
+	EcatHelper::ecat_index_al index = info[1].As<Napi::Number>().Uint32Value();
+	EcatHelper::ecat_sub_al subindex = info[2].As<Napi::Number>().Uint32Value();
+	size_t size = info[3].As<Napi::Number>().Uint32Value();
+	EcatHelper::ecat_value_al value = {};
+
+	if(EcatHelper::sdo_download(pos, index, subindex, size, value.bytes)){
+		return Napi::Boolean::New(env, false);
+	}
+
+	return Napi::Boolean::New(env, true);
+}
+
+Napi::Value js_get_layout(const Napi::CallbackInfo& info)
+{
+	Napi::Env env = info.Env();
+	bind_master(info);
+
+	std::vector<EcatHelper::ecat_slave_entry_al>* domain_data;
+	EcatHelper::attach_process_data(&domain_data);
+
+	size_t pd_size = domain_data->size();
+	Napi::Array layout = Napi::Array::New(env, pd_size);
+
+	for(size_t dmn_idx = 0; dmn_idx < pd_size; dmn_idx++){
+		const EcatHelper::ecat_slave_entry_al& entry = domain_data->at(dmn_idx);
+		Napi::Object elem = Napi::Object::New(env);
+
+		elem.Set("position", Napi::Value::From(env, entry.position));
+		elem.Set("index", Napi::Value::From(env, entry.index));
+		elem.Set("subindex", Napi::Value::From(env, entry.subindex));
+		elem.Set("size", Napi::Value::From(env, entry.size));
+		elem.Set("signed", Napi::Boolean::New(env, entry.is_signed));
+		elem.Set("direction", Napi::Value::From(env, entry.direction));
+		elem.Set("domain", Napi::String::New(env, EcatHelper::domain_name(entry.domain)));
+
+		layout[dmn_idx] = elem;
+	}
+
+	return layout;
+}
+
+Napi::Value js_get_delivery_stats(const Napi::CallbackInfo& info)
+{
+	Napi::Env env = info.Env();
+	MasterInstance* instance = bind_master(info);
+
+	Napi::Object stats = Napi::Object::New(env);
+
+	const DeliveryStats& delivery_stats = instance->delivery_stats;
+
+	stats.Set("published", Napi::Number::New(env, delivery_stats.published.load()));
+	stats.Set("delivered", Napi::Number::New(env, delivery_stats.delivered.load()));
+	stats.Set("coalesced", Napi::Number::New(env, delivery_stats.coalesced.load()));
+	stats.Set("dropped", Napi::Number::New(env, delivery_stats.dropped.load()));
+
+	return stats;
+}
+
+static Napi::Object histogram_summary(Napi::Env env,
+	const HdrHistogram& histogram)
+{
+	static const double pct[] = { 50, 90, 99, 99.9, 99.99 };
+	static const char* names[] = { "p50", "p90", "p99", "p999", "p9999" };
+	uint64_t values[sizeof(pct) / sizeof(pct[0])];
+
+	histogram.percentiles(pct, sizeof(pct) / sizeof(pct[0]), values);
+
+	Napi::Object summary = Napi::Object::New(env);
+	summary.Set("count", Napi::Number::New(env, histogram.count()));
+	summary.Set("min", Napi::Number::New(env, histogram.min()));
+	summary.Set("max", Napi::Number::New(env, histogram.max()));
+	summary.Set("mean", Napi::Number::New(env, histogram.mean()));
+
+	for (size_t idx = 0; idx < sizeof(pct) / sizeof(pct[0]); idx++) {
+		summary.Set(names[idx], Napi::Number::New(env, values[idx]));
+	}
+
+	return summary;
+}
+
+static const char* policy_name(const int32_t& policy)
+{
+	switch (policy) {
+
+	case SCHED_OTHER: {
+		return "other";
+	} break;
+
+	case SCHED_FIFO: {
+		return "fifo";
+	} break;
+
+	case SCHED_RR: {
+		return "rr";
+	} break;
+
+	case SCHED_DEADLINE: {
+		return "deadline";
+	} break;
+
+	default: {
+		return "unknown";
+	} break;
+
+	}
+}
+
+/*
+ * Takes { cpu, policy, priority, runtime, deadline, period }, applied by
+ * cyclic thread on next start
+ */
+Napi::Value js_set_rt_config(const Napi::CallbackInfo& info)
+{
+	Napi::Env env = info.Env();
+	MasterInstance* instance = bind_master(info);
+
+	Napi::Object opts = info[0].As<Napi::Object>();
+	RtConfig config;
+
+	if (opts.Has("cpu")) {
+		config.cpu = opts.Get("cpu").As<Napi::Number>().Int32Value();
+
+		if (config.cpu >= CPU_SETSIZE) {
+			Napi::RangeError::New(env, "Invalid CPU").ThrowAsJavaScriptException();
+			return env.Undefined();
+		}
+	}
+
+	if (opts.Has("policy")) {
+		std::string policy = opts.Get("policy").As<Napi::String>().Utf8Value();
+
+		if (policy == "fifo") {
+			config.policy = SCHED_FIFO;
+		} else if (policy == "rr") {
+			config.policy = SCHED_RR;
+		} else if (policy == "deadline") {
+			config.policy = SCHED_DEADLINE;
+		} else if (policy == "other") {
+			config.policy = SCHED_OTHER;
+		} else {
+			Napi::TypeError::New(env, "Policy must be 'fifo', 'rr', 'deadline' or 'other'").ThrowAsJavaScriptException();
+			return env.Undefined();
+		}
+	}
+
+	if (opts.Has("priority")) {
+		config.priority = opts.Get("priority").As<Napi::Number>().Int32Value();
+	}
+
+	if (opts.Has("runtime")) {
+		config.runtime = opts.Get("runtime").As<Napi::Number>().Int64Value();
+	}
+
+	if (opts.Has("deadline")) {
+		config.deadline = opts.Get("deadline").As<Napi::Number>().Int64Value();
+	}
+
+	if (opts.Has("period")) {
+		config.period = opts.Get("period").As<Napi::Number>().Int64Value();
+	}
+
+	// kernel refuses SCHED_DEADLINE for a thread whose affinity is
+	// narrower than its root domain, so the cyclic thread would start
+	// pinned but without any realtime policy
+	if (config.cpu >= 0 && config.policy == SCHED_DEADLINE) {
+		Napi::TypeError::New(env, "CPU pinning can't be combined with 'deadline' policy").ThrowAsJavaScriptException();
+		return env.Undefined();
+	}
+
+	instance->rt_config = config;
+
+	return env.Undefined();
+}
+
+Napi::Value js_get_rt_settings(const Napi::CallbackInfo& info)
+{
+	Napi::Env env = info.Env();
+	MasterInstance* instance = bind_master(info);
+
+	const RtApplied& rt_applied = instance->rt_applied;
+
+	// not applied yet
+	if (!rt_applied.ready.load(std::memory_order_acquire)) {
+		return env.Undefined();
+	}
 
-/************************** Thread Safe Function *******************************
- *
- * https://napi.inspiredware.com/special-topics/thread-safe-functions.html
- *
- * ****************************************************************************/
+	const RtConfig& applied = rt_applied.config;
+	Napi::Object settings = Napi::Object::New(env);
 
-struct TsfnContext {
-	TsfnContext(Napi::Env env) : deferred(Napi::Promise::Deferred::New(env)) {};
+	Napi::Array cpus = Napi::Array::New(env, rt_applied.cpus.size());
+	for (size_t idx = 0; idx < rt_applied.cpus.size(); idx++) {
+		cpus[idx] = Napi::Number::New(env, rt_applied.cpus[idx]);
+	}
 
-	// Native Promise returned to JavaScript
-	Napi::Promise::Deferred deferred;
+	settings.Set("cpus", cpus);
+	settings.Set("policy", Napi::String::New(env, policy_name(applied.policy)));
+	settings.Set("priority", Napi::Number::New(env, applied.priority));
 
-	// Native thread
-	std::thread nativeThread;
+	if (applied.policy == SCHED_DEADLINE) {
+		settings.Set("runtime", Napi::Number::New(env, applied.runtime));
+		settings.Set("deadline", Napi::Number::New(env, applied.deadline));
+		settings.Set("period", Napi::Number::New(env, applied.period));
+	}
 
-	Napi::ThreadSafeFunction tsfn;
-};
+	if (!rt_applied.error.empty()) {
+		settings.Set("error", Napi::String::New(env, rt_applied.error));
+	}
 
-void finalizer_cb(Napi::Env env, void *finalizeData, TsfnContext *context)
+	return settings;
+}
+
+Napi::Value js_set_memory_lock(const Napi::CallbackInfo& info)
 {
-	// Join the thread
-	context->nativeThread.join();
+	Napi::Env env = info.Env();
+	bind_master(info);
 
-	// Resolve the Promise previously returned to JS via the js_create_thread method.
-	context->deferred.Resolve(Napi::Boolean::New(env, true));
-	delete context;
-}
+	EcatHelper::set_memory_lock(info[0].ToBoolean());
 
-void thread_entry(TsfnContext *context) {
-	auto routine_cb = [](Napi::Env env, Napi::Function js_cb,
-		std::vector<EcatHelper::ecat_slave_entry_al>* domain_data) {
+	return env.Undefined();
+}
 
-		size_t pd_size = domain_data->size();
-		Napi::Value states
-			= Napi::Number::New(env, EcatHelper::application_layer_states());
-		Napi::Array array = Napi::Array::New(env, pd_size);
+Napi::Value js_get_memory_report(const Napi::CallbackInfo& info)
+{
+	Napi::Env env = info.Env();
+	bind_master(info);
 
-		for(size_t dmn_idx = 0; dmn_idx < pd_size; dmn_idx++){
-			Napi::Object elem = Napi::Object::New(env);
+	EcatHelper::ecat_memory_report_al report;
+	EcatHelper::memory_report(&report);
 
-			uint8_t bit_size = domain_data->at(dmn_idx).size;
-			uint8_t is_signed = domain_data->at(dmn_idx).is_signed;
+	Napi::Object faults = Napi::Object::New(env);
+	faults.Set("startupMinor", Napi::Number::New(env, report.minor_faults_startup));
+	faults.Set("startupMajor", Napi::Number::New(env, report.major_faults_startup));
+	faults.Set("loopMinor", Napi::Number::New(env, report.minor_faults_loop));
+	faults.Set("loopMajor", Napi::Number::New(env, report.major_faults_loop));
 
-			elem.Set("position", Napi::Value::From(env, domain_data->at(dmn_idx).position));
-			elem.Set("index", Napi::Value::From(env, (*domain_data).at(dmn_idx).index));
-			elem.Set("subindex", Napi::Value::From(env, (*domain_data).at(dmn_idx).subindex));
-			elem.Set("size", Napi::Value::From(env, bit_size));
-
-			EcatHelper::ecat_value_al* value = &(domain_data->at(dmn_idx).value);
-			switch(bit_size){
-
-			case 1: {
-				elem.Set("value", Napi::Number::New(env, value->u8 & 0x1));
-			} break;
-
-			case 8: {
-				if(is_signed) {
-					elem.Set("value", Napi::Number::New(env, value->i8));
-				} else {
-					elem.Set("value", Napi::Number::New(env, value->u8));
-				}
-			} break;
-
-			case 16: {
-				if(is_signed) {
-					elem.Set("value", Napi::Number::New(env, value->i16));
-				} else {
-					elem.Set("value", Napi::Number::New(env, value->u16));
-				}
-			} break;
-
-			case 32: {
-				if(is_signed) {
-					elem.Set("value", Napi::Number::New(env, value->i32));
-				} else {
-					elem.Set("value", Napi::Number::New(env, value->u32));
-				}
-			} break;
+	Napi::Object result = Napi::Object::New(env);
+	result.Set("locked", Napi::Boolean::New(env, report.locked));
+	result.Set("lockedBytes", Napi::Number::New(env, report.locked_bytes));
+	result.Set("pageFaults", faults);
 
-			}
+	return result;
+}
 
-			array[dmn_idx] = elem;
-		}
+Napi::Value js_set_overrun_policy(const Napi::CallbackInfo& info)
+{
+	Napi::Env env = info.Env();
+	MasterInstance* instance = bind_master(info);
 
-		js_cb.Call({ array, states });
-	};
+	OverrunPolicy& overrun_policy = instance->overrun_policy;
 
-	std::vector<EcatHelper::ecat_slave_entry_al>* domain_data;
-	EcatHelper::attach_process_data(&domain_data);
+	overrun_policy.mode = info[0].As<Napi::Number>().Uint32Value()
+		? OVERRUN_BURST : OVERRUN_SKIP;
+	overrun_policy.max_burst = info.Length() > 1
+		? info[1].As<Napi::Number>().Uint32Value() : 0;
 
-	struct timespec wakeup_time;
+	return env.Undefined();
+}
 
-	/* Set priority */
-	struct sched_param param = {};
-	param.sched_priority = sched_get_priority_max(SCHED_FIFO);
+Napi::Value js_get_cycle_stats(const Napi::CallbackInfo& info)
+{
+	Napi::Env env = info.Env();
+	MasterInstance* instance = bind_master(info);
+
+	CycleStats& cycle_stats = instance->cycle_stats;
+	Napi::Object stats = Napi::Object::New(env);
+
+	stats.Set("latency", histogram_summary(env, cycle_stats.latency));
+	stats.Set("execution", histogram_summary(env, cycle_stats.execution));
+	stats.Set("period", histogram_summary(env, cycle_stats.period));
+	stats.Set("overruns", Napi::Number::New(env, cycle_stats.overruns.load()));
+	stats.Set("skipped", Napi::Number::New(env, cycle_stats.skipped.load()));
+
+	// worst deviation of period from the configured one
+	int64_t nominal = EcatHelper::get_period();
+	int64_t jitter = 0;
+	if (cycle_stats.period.count()) {
+		jitter = std::max({ (int64_t)cycle_stats.period.max() - nominal,
+			nominal - (int64_t)cycle_stats.period.min(), (int64_t)0 });
+	}
+	stats.Set("jitter", Napi::Number::New(env, jitter));
 
-	if (sched_setscheduler(0, SCHED_FIFO, &param) == -1) {
-		perror("sched_setscheduler failed");
+	// optionally start a new measurement window
+	if (info.Length() > 0 && info[0].ToBoolean()) {
+		cycle_stats.latency.request_reset();
+		cycle_stats.execution.request_reset();
+		cycle_stats.period.request_reset();
 	}
 
-	EcatHelper::prerun_routine();
+	return stats;
+}
 
-	clock_gettime(CLOCK_MONOTONIC, &wakeup_time);
-	wakeup_time.tv_sec += 1; /* start in future */
-	wakeup_time.tv_nsec = 0;
+Napi::Value js_set_dc_drift_compensation(const Napi::CallbackInfo& info)
+{
+	Napi::Env env = info.Env();
+	bind_master(info);
 
-	running_state = 1;
+	EcatHelper::set_dc_drift_compensation(info[0].ToBoolean());
 
-	while (1) {
-		clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wakeup_time, NULL);
+	return env.Undefined();
+}
 
-		if (!running_state) {
-			fprintf(stderr, "\nBreak Cyclic Process (running_state %d)\n",
-				running_state);
-			context->tsfn.Abort();
-			break;
-		}
+Napi::Value js_get_dc_status(const Napi::CallbackInfo& info)
+{
+	Napi::Env env = info.Env();
+	bind_master(info);
 
-		EcatHelper::main_routine();
+	EcatHelper::ecat_dc_report_al report;
+	EcatHelper::dc_report(&report);
 
-		napi_status status = context->tsfn.BlockingCall(domain_data, routine_cb);
+	Napi::Object status = Napi::Object::New(env);
+	status.Set("enabled", Napi::Boolean::New(env, report.enabled));
+	status.Set("followReference", Napi::Boolean::New(env, report.follow_reference));
+	status.Set("referencePosition", Napi::Number::New(env, report.reference_position));
+	status.Set("diff", Napi::Number::New(env, report.diff_ns));
+	status.Set("adjust", Napi::Number::New(env, report.adjust_ns));
 
-		if (status != napi_ok) {
-			Napi::Error::Fatal(
-					"thread_entry",
-					"Napi::ThreadSafeNapi::Function.BlockingCall() failed"
-				);
-		}
+	return status;
+}
 
-		wakeup_time.tv_nsec += period_ns;
-		Timespec::normalize_upper(&wakeup_time);
-	}
+/********************************* CiA 402 *************************************
+ *
+ * State machine and setpoints of drives are handled by the cyclic thread,
+ * JS only sets the requested state and queues setpoints ahead of time.
+ *
+ * ****************************************************************************/
 
-	EcatHelper::postrun_routine();
+static std::vector<EcatHelper::ecat_setpoint_al> setpoint_scratch;
+static std::vector<EcatHelper::ecat_segment_al> segment_scratch;
+
+static double segment_number(const Napi::Object& segment, const char* name)
+{
+	return segment.Has(name)
+		? segment.Get(name).As<Napi::Number>().DoubleValue() : 0;
 }
-/********************** End of Thread Safe Function ***************************/
 
-Napi::Value js_thread_start(const Napi::CallbackInfo &info)
+static uint16_t axis_object(const Napi::Object& config, const char* name,
+	const uint16_t& fallback)
+{
+	return config.Has(name)
+		? config.Get(name).As<Napi::Number>().Uint32Value() : fallback;
+}
+
+Napi::Value js_axis_add(const Napi::CallbackInfo& info)
 {
 	Napi::Env env = info.Env();
+	bind_master(info);
 
-	// Construct context data
-	auto _ctx = new TsfnContext(env);
+	if(!info[0].IsObject()){
+		Napi::TypeError::New(env, "Expected axis configuration object").ThrowAsJavaScriptException();
+		return env.Undefined();
+	}
 
-	// Create a new ThreadSafeFunction.
-	_ctx->tsfn = Napi::ThreadSafeFunction::New(
-			env, // Environment
-			info[0].As<Napi::Function>(), // JS function from caller
-			"EcatThread", // Resource name
-			0, // Max queue size (0 = unlimited).
-			1, // Initial thread count
-			_ctx, // Context,
-			finalizer_cb, // Finalizer
-			(void *)nullptr	// Finalizer data
-		);
+	Napi::Object config = info[0].As<Napi::Object>();
+	EcatHelper::ecat_axis_config_al axis;
 
-	_ctx->nativeThread = std::thread(thread_entry, _ctx);
+	axis.position = config.Get("position").As<Napi::Number>().Uint32Value();
+	if(config.Has("mode")){
+		axis.mode = config.Get("mode").As<Napi::Number>().Int32Value();
+	}
+	axis.auto_fault_reset = config.Get("autoFaultReset").ToBoolean();
+	if(config.Has("velocityFactor")){
+		axis.velocity_factor = config.Get("velocityFactor").As<Napi::Number>().DoubleValue();
+	}
+	if(config.Has("holdDeceleration")){
+		axis.hold_deceleration = config.Get("holdDeceleration").As<Napi::Number>().DoubleValue();
+	}
 
-	return _ctx->deferred.Promise();
+	axis.controlword = axis_object(config, "controlword", axis.controlword);
+	axis.statusword = axis_object(config, "statusword", axis.statusword);
+	axis.mode_of_operation = axis_object(config, "modeOfOperation", axis.mode_of_operation);
+	axis.target_position = axis_object(config, "targetPosition", axis.target_position);
+	axis.target_velocity = axis_object(config, "targetVelocity", axis.target_velocity);
+	axis.position_actual = axis_object(config, "positionActual", axis.position_actual);
+
+	return Napi::Number::New(env, EcatHelper::axis_add(axis));
 }
 
-Napi::Value js_thread_stop(const Napi::CallbackInfo &info)
+static Napi::Value axis_request(const Napi::CallbackInfo& info,
+	const EcatHelper::axis_request_al& request)
 {
 	Napi::Env env = info.Env();
+	bind_master(info);
 
-	running_state = 0;
+	int32_t axis = info[0].As<Napi::Number>().Int32Value();
 
-	return Napi::Number::New(env, running_state);
+	return Napi::Boolean::New(env, !EcatHelper::axis_request(axis, request));
 }
 
-Napi::Value js_init(const Napi::CallbackInfo& info)
+Napi::Value js_axis_enable(const Napi::CallbackInfo& info)
+{
+	return axis_request(info, EcatHelper::ECAT_AXIS_ENABLE);
+}
+
+Napi::Value js_axis_disable(const Napi::CallbackInfo& info)
+{
+	return axis_request(info, EcatHelper::ECAT_AXIS_DISABLE);
+}
+
+Napi::Value js_axis_quick_stop(const Napi::CallbackInfo& info)
+{
+	return axis_request(info, EcatHelper::ECAT_AXIS_QUICK_STOP);
+}
+
+Napi::Value js_axis_fault_reset(const Napi::CallbackInfo& info)
 {
 	Napi::Env env = info.Env();
+	bind_master(info);
 
-	EcatHelper::init();
+	int32_t axis = info[0].As<Napi::Number>().Int32Value();
 
-	return Napi::Boolean::New(env, true);
+	return Napi::Boolean::New(env, !EcatHelper::axis_fault_reset(axis));
 }
 
-Napi::Value js_set_json_path(const Napi::CallbackInfo& info)
+Napi::Value js_axis_push(const Napi::CallbackInfo& info)
 {
 	Napi::Env env = info.Env();
+	bind_master(info);
 
-	std::string json_path = info[0].As<Napi::String>();
+	int32_t axis = info[0].As<Napi::Number>().Int32Value();
 
-	EcatHelper::set_json_path(json_path);
+	if(!is_int32_array(info[1])){
+		Napi::TypeError::New(env, "Positions must be an Int32Array or Uint32Array").ThrowAsJavaScriptException();
+		return env.Undefined();
+	}
 
-	return Napi::Boolean::New(env, true);
+	Napi::TypedArray position_array = info[1].As<Napi::TypedArray>();
+	size_t count = position_array.ElementLength();
+	const int32_t* positions = int32_data(position_array);
+	const int32_t* velocities = nullptr;
+
+	if(info.Length() > 2 && !info[2].IsUndefined()){
+		if(!is_int32_array(info[2])){
+			Napi::TypeError::New(env, "Velocities must be an Int32Array or Uint32Array").ThrowAsJavaScriptException();
+			return env.Undefined();
+		}
+
+		Napi::TypedArray velocity_array = info[2].As<Napi::TypedArray>();
+		if(velocity_array.ElementLength() < count){
+			Napi::RangeError::New(env, "Velocities shorter than positions").ThrowAsJavaScriptException();
+			return env.Undefined();
+		}
+
+		velocities = int32_data(velocity_array);
+	}
+
+	if(setpoint_scratch.size() < count){
+		setpoint_scratch.resize(count);
+	}
+
+	for(size_t i = 0; i < count; i++){
+		setpoint_scratch[i].position = positions[i];
+		setpoint_scratch[i].velocity = velocities ? velocities[i] : 0;
+	}
+
+	size_t pushed = 0;
+	if(EcatHelper::axis_push(axis, setpoint_scratch.data(), count, &pushed)){
+		return Napi::Number::New(env, -1);
+	}
+
+	return Napi::Number::New(env, pushed);
 }
 
-Napi::Value js_set_frequency(const Napi::CallbackInfo& info)
+Napi::Value js_axis_submit(const Napi::CallbackInfo& info)
 {
 	Napi::Env env = info.Env();
+	bind_master(info);
 
-	uint32_t frequency = info[0].As<Napi::Number>();
+	int32_t axis = info[0].As<Napi::Number>().Int32Value();
 
-	EcatHelper::set_frequency(frequency);
-	period_ns = EcatHelper::get_period();
+	if(!info[1].IsArray()){
+		Napi::TypeError::New(env, "Segments must be an Array").ThrowAsJavaScriptException();
+		return env.Undefined();
+	}
+
+	Napi::Array segments = info[1].As<Napi::Array>();
+	size_t count = segments.Length();
+
+	if(segment_scratch.size() < count){
+		segment_scratch.resize(count);
+	}
 
-	return Napi::Number::New(env, period_ns);
+	for(size_t i = 0; i < count; i++){
+		Napi::Object src = segments.Get(i).As<Napi::Object>();
+		EcatHelper::ecat_segment_al& segment = segment_scratch[i];
+
+		segment.type = (EcatHelper::segment_type_al) src.Get("type").As<Napi::Number>().Uint32Value();
+		segment.position = src.Get("position").As<Napi::Number>().Int32Value();
+		segment.velocity = (int32_t) segment_number(src, "velocity");
+		segment.duration_ns = (int64_t) segment_number(src, "duration");
+		segment.max_velocity = segment_number(src, "maxVelocity");
+		segment.max_acceleration = segment_number(src, "maxAcceleration");
+		segment.max_jerk = segment_number(src, "maxJerk");
+	}
+
+	size_t pushed = 0;
+	if(EcatHelper::axis_submit(axis, segment_scratch.data(), count, &pushed)){
+		return Napi::Number::New(env, -1);
+	}
+
+	return Napi::Number::New(env, pushed);
 }
 
-Napi::Value js_domain_write(const Napi::CallbackInfo& info)
+Napi::Value js_axis_status(const Napi::CallbackInfo& info)
 {
 	Napi::Env env = info.Env();
+	bind_master(info);
 
-	EcatHelper::ecat_pos_al pos = info[0].As<Napi::Number>().Uint32Value();
-	EcatHelper::ecat_index_al index = info[1].As<Napi::Number>().Uint32Value();
-	EcatHelper::ecat_sub_al subindex = info[2].As<Napi::Number>().Uint32Value();
-	EcatHelper::ecat_value_al value = {};
-	value.u32 = info[3].As<Napi::Number>().Uint32Value();
+	int32_t axis = info[0].As<Napi::Number>().Int32Value();
+	EcatHelper::ecat_axis_status_al report;
 
-	if(EcatHelper::domain_write(pos, index, subindex, value)){
-		return Napi::Boolean::New(env, false);
+	if(EcatHelper::axis_status(axis, &report)){
+		return env.Undefined();
 	}
 
-	return Napi::Boolean::New(env, true);
+	Napi::Object status = Napi::Object::New(env);
+	status.Set("statusword", Napi::Number::New(env, report.statusword));
+	status.Set("controlword", Napi::Number::New(env, report.controlword));
+	status.Set("state", Napi::Number::New(env, report.state));
+	status.Set("positionActual", Napi::Number::New(env, report.position_actual));
+	status.Set("targetPosition", Napi::Number::New(env, report.setpoint.position));
+	status.Set("targetVelocity", Napi::Number::New(env, report.setpoint.velocity));
+	status.Set("queued", Napi::Number::New(env, report.queued));
+	status.Set("holding", Napi::Boolean::New(env, report.holding));
+	status.Set("underruns", Napi::Number::New(env, report.underruns));
+	status.Set("faults", Napi::Number::New(env, report.faults));
+
+	return status;
 }
 
-Napi::Value js_domain_read(const Napi::CallbackInfo& info)
+Napi::Value js_axis_clear(const Napi::CallbackInfo& info)
 {
 	Napi::Env env = info.Env();
+	bind_master(info);
 
-	EcatHelper::ecat_pos_al pos = info[0].As<Napi::Number>().Uint32Value();
-	EcatHelper::ecat_index_al index = info[1].As<Napi::Number>().Uint32Value();
-	EcatHelper::ecat_sub_al subindex = info[2].As<Napi::Number>().Uint32Value();
-	EcatHelper::ecat_value_al value = {};
+	EcatHelper::axis_clear();
 
-	if(EcatHelper::domain_read(pos, index, subindex, &value)){
+	return env.Undefined();
+}
+
+Napi::Value js_set_cov_rule(const Napi::CallbackInfo& info)
+{
+	Napi::Env env = info.Env();
+	MasterInstance* instance = bind_master(info);
+
+	int32_t handle = info[0].As<Napi::Number>().Int32Value();
+
+	// rules are kept for every entry of the process image
+	std::vector<EcatHelper::ecat_slave_entry_al>* domain_data;
+	EcatHelper::attach_process_data(&domain_data);
+	size_t length = domain_data->size();
+
+	if(handle < 0 || (size_t)handle >= length){
+		Napi::RangeError::New(env, "Invalid handle").ThrowAsJavaScriptException();
 		return env.Undefined();
 	}
 
-	return Napi::Number::New(env, value.u32);
+	CovRule rule;
+
+	if(info.Length() > 1 && info[1].IsNumber()){
+		rule.deadband = info[1].As<Napi::Number>().DoubleValue();
+	}
+
+	if(info.Length() > 2 && info[2].IsBigInt()){
+		bool lossless;
+		rule.mask = info[2].As<Napi::BigInt>().Uint64Value(&lossless);
+	}else if(info.Length() > 2 && info[2].IsNumber()){
+		rule.mask = (uint64_t)info[2].As<Napi::Number>().Int64Value();
+	}
+
+	std::vector<CovRule>& rules = instance->cov_rules;
+	if(rules.size() != length){
+		rules.resize(length);
+	}
+	rules[handle] = rule;
+
+	return env.Undefined();
 }
 
-Napi::Value js_sdo_read(const Napi::CallbackInfo& info)
+Napi::Value js_clear_cov_rules(const Napi::CallbackInfo& info)
 {
 	Napi::Env env = info.Env();
+	MasterInstance* instance = bind_master(info);
 
-	EcatHelper::ecat_pos_al pos = info[0].As<Napi::Number>().Uint32Value();
-	EcatHelper::ecat_index_al index = info[1].As<Napi::Number>().Uint32Value();
-	EcatHelper::ecat_sub_al subindex = info[2].As<Napi::Number>().Uint32Value();
-	size_t size = info[3].As<Napi::Number>().Uint32Value();
-	size_t result_size = 0;
-	EcatHelper::ecat_value_al value = {};
+	std::vector<CovRule>& rules = instance->cov_rules;
+	rules.assign(rules.size(), CovRule());
 
-	if(EcatHelper::sdo_upload(
-		pos, index, subindex, size, &result_size, value.bytes)){
+	return env.Undefined();
+}
+
+Napi::Value js_cov_resync(const Napi::CallbackInfo& info)
+{
+	Napi::Env env = info.Env();
+	MasterInstance* instance = bind_master(info);
+
+	instance->cov_resync = true;
+
+	return env.Undefined();
+}
+
+/********************************* Recording ***********************************
+ *
+ * Process data is copied by the cyclic thread and written to file by a low
+ * priority thread. Files are read back by mapping them, values of each entry
+ * are decoded into their own Float64Array.
+ *
+ * ****************************************************************************/
+
+Napi::Value js_record_start(const Napi::CallbackInfo& info)
+{
+	Napi::Env env = info.Env();
+	bind_master(info);
 
+	if(!info[0].IsString()){
+		Napi::TypeError::New(env, "Expected file path").ThrowAsJavaScriptException();
 		return env.Undefined();
 	}
 
-	return Napi::Number::New(env, value.u32);
+	std::string path = info[0].As<Napi::String>().Utf8Value();
+
+	// no handles records every domain as it is
+	const EcatHelper::ecat_size_io_al* handles = nullptr;
+	size_t count = 0;
+
+	if(info.Length() > 1 && info[1].IsTypedArray()){
+		if(!is_int32_array(info[1])){
+			Napi::TypeError::New(env, "Handles must be an Int32Array or Uint32Array").ThrowAsJavaScriptException();
+			return env.Undefined();
+		}
+
+		Napi::TypedArray array = info[1].As<Napi::TypedArray>();
+
+		handles = int32_data(array);
+		count = array.ElementLength();
+	}
+
+	size_t ring_records = info.Length() > 2 && info[2].IsNumber()
+		? info[2].As<Napi::Number>().Uint32Value() : 0;
+
+	return Napi::Number::New(env,
+		EcatHelper::record_start(path, handles, count, ring_records));
 }
 
-Napi::Value js_sdo_write(const Napi::CallbackInfo& info)
+Napi::Value js_record_stop(const Napi::CallbackInfo& info)
 {
 	Napi::Env env = info.Env();
+	bind_master(info);
 
-	EcatHelper::ecat_pos_al pos = info[0].As<Napi::Number>().Uint32Value();
-	EcatHelper::ecat_index_al index = info[1].As<Napi::Number>().Uint32Value();
-	EcatHelper::ecat_sub_al subindex = info[2].As<Napi::Number>().Uint32Value();
-	size_t size = info[3].As<Napi::Number>().Uint32Value();
-	EcatHelper::ecat_value_al value = {};
+	EcatHelper::record_stop();
 
-	if(EcatHelper::sdo_download(pos, index, subindex, size, value.bytes)){
-		return Napi::Boolean::New(env, false);
+	return env.Undefined();
+}
+
+Napi::Value js_get_record_status(const Napi::CallbackInfo& info)
+{
+	Napi::Env env = info.Env();
+	bind_master(info);
+
+	EcatHelper::ecat_record_report_al report;
+	EcatHelper::record_report(&report);
+
+	Napi::Object result = Napi::Object::New(env);
+	result.Set("active", Napi::Boolean::New(env, report.active));
+	result.Set("pending", Napi::Boolean::New(env, report.pending));
+	result.Set("path", Napi::String::New(env, report.path));
+	result.Set("records", Napi::Number::New(env, report.records));
+	result.Set("dropped", Napi::Number::New(env, report.dropped));
+	result.Set("bytes", Napi::Number::New(env, report.bytes));
+
+	return result;
+}
+
+// not bound to a master, files of any master can be read at any time
+Napi::Value js_read_recording(const Napi::CallbackInfo& info)
+{
+	Napi::Env env = info.Env();
+
+	if(!info[0].IsString()){
+		Napi::TypeError::New(env, "Expected file path").ThrowAsJavaScriptException();
+		return env.Undefined();
 	}
 
-	return Napi::Boolean::New(env, true);
+	Recorder::Reader reader;
+	if(reader.open(info[0].As<Napi::String>().Utf8Value())){
+		Napi::Error::New(env, "Recording can't be read").ThrowAsJavaScriptException();
+		return env.Undefined();
+	}
+
+	const Recorder::file_header_al& header = reader.header();
+	const Recorder::file_entry_al* entries = reader.entries();
+
+	// range of records, clamped to the file
+	uint64_t first = info.Length() > 1 && info[1].IsNumber()
+		? info[1].As<Napi::Number>().Int64Value() : 0;
+	first = std::min(first, reader.count());
+
+	uint64_t count = info.Length() > 2 && info[2].IsNumber()
+		? info[2].As<Napi::Number>().Int64Value() : reader.count();
+	count = std::min(count, reader.count() - first);
+
+	Napi::Object head = Napi::Object::New(env);
+	head.Set("version", Napi::Number::New(env, header.version));
+	head.Set("masterIndex", Napi::Number::New(env, header.master_index));
+	head.Set("periodNs", Napi::Number::New(env, header.period_ns));
+	head.Set("fullImage", Napi::Boolean::New(env, header.full_image));
+	head.Set("startRealtimeNs", Napi::BigInt::New(env, header.start_realtime_ns));
+	head.Set("startMonotonicNs", Napi::BigInt::New(env, header.start_monotonic_ns));
+	head.Set("recordCount", Napi::Number::New(env, (double)reader.count()));
+
+	Napi::Array layout = Napi::Array::New(env, header.entry_count);
+	Napi::Array values = Napi::Array::New(env, header.entry_count);
+
+	for(uint32_t idx = 0; idx < header.entry_count; idx++){
+		const Recorder::file_entry_al& entry = entries[idx];
+
+		Napi::Object elem = Napi::Object::New(env);
+		elem.Set("position", Napi::Number::New(env, entry.position));
+		elem.Set("index", Napi::Number::New(env, entry.index));
+		elem.Set("subindex", Napi::Number::New(env, entry.subindex));
+		elem.Set("size", Napi::Number::New(env, entry.size));
+		elem.Set("domain", Napi::Number::New(env, entry.domain));
+		elem.Set("signed", Napi::Boolean::New(env, entry.flags & RECORDER_FLAG_SIGNED));
+		elem.Set("output", Napi::Boolean::New(env, entry.flags & RECORDER_FLAG_OUTPUT));
+		layout[idx] = elem;
+
+		Napi::Float64Array column = Napi::Float64Array::New(env, count);
+		double* data = column.Data();
+
+		for(uint64_t rec = 0; rec < count; rec++){
+			data[rec] = Recorder::decode(entry, reader.payload(first + rec));
+		}
+
+		values[idx] = column;
+	}
+
+	Napi::BigUint64Array cycles = Napi::BigUint64Array::New(env, count);
+	Napi::BigUint64Array timestamps = Napi::BigUint64Array::New(env, count);
+
+	for(uint64_t rec = 0; rec < count; rec++){
+		cycles[rec] = reader.record(first + rec).cycle;
+		timestamps[rec] = reader.record(first + rec).timestamp_ns;
+	}
+
+	Napi::Object result = Napi::Object::New(env);
+	result.Set("header", head);
+	result.Set("entries", layout);
+	result.Set("first", Napi::Number::New(env, (double)first));
+	result.Set("cycles", cycles);
+	result.Set("timestamps", timestamps);
+	result.Set("values", values);
+
+	return result;
 }
 
 Napi::Value js_al_states(const Napi::CallbackInfo& info)
 {
 	Napi::Env env = info.Env();
+	bind_master(info);
 
 	return Napi::Number::New(env, EcatHelper::application_layer_states());
 }
 
+// every function is bound to given master instance
+static void export_functions(Napi::Env env, Napi::Object target,
+	MasterInstance* instance)
+{
+	target.Set(Napi::String::New(env, "setFrequency"), Napi::Function::New(env, js_set_frequency, "setFrequency", instance));
+	target.Set(Napi::String::New(env, "setOutputRefresh"), Napi::Function::New(env, js_set_output_refresh, "setOutputRefresh", instance));
+	target.Set(Napi::String::New(env, "init"), Napi::Function::New(env, js_init, "init", instance));
+	target.Set(Napi::String::New(env, "setJSON"), Napi::Function::New(env, js_set_json_path, "setJSON", instance));
+	target.Set(Napi::String::New(env, "sdoWrite"), Napi::Function::New(env, js_sdo_write, "sdoWrite", instance));
+	target.Set(Napi::String::New(env, "sdoRead"), Napi::Function::New(env, js_sdo_read, "sdoRead", instance));
+	target.Set(Napi::String::New(env, "sdoReadAsync"), Napi::Function::New(env, js_sdo_read_async, "sdoReadAsync", instance));
+	target.Set(Napi::String::New(env, "sdoWriteAsync"), Napi::Function::New(env, js_sdo_write_async, "sdoWriteAsync", instance));
+	target.Set(Napi::String::New(env, "sdoBulk"), Napi::Function::New(env, js_sdo_bulk, "sdoBulk", instance));
+	target.Set(Napi::String::New(env, "domainWrite"), Napi::Function::New(env, js_domain_write, "domainWrite", instance));
+	target.Set(Napi::String::New(env, "domainRead"), Napi::Function::New(env, js_domain_read, "domainRead", instance));
+	target.Set(Napi::String::New(env, "resolve"), Napi::Function::New(env, js_domain_resolve, "resolve", instance));
+	target.Set(Napi::String::New(env, "domainWriteHandle"), Napi::Function::New(env, js_domain_write_handle, "domainWriteHandle", instance));
+	target.Set(Napi::String::New(env, "domainReadHandle"), Napi::Function::New(env, js_domain_read_handle, "domainReadHandle", instance));
+	target.Set(Napi::String::New(env, "domainWriteMany"), Napi::Function::New(env, js_domain_write_many, "domainWriteMany", instance));
+	target.Set(Napi::String::New(env, "domainReadMany"), Napi::Function::New(env, js_domain_read_many, "domainReadMany", instance));
+	target.Set(Napi::String::New(env, "domainWriteBegin"), Napi::Function::New(env, js_domain_write_begin, "domainWriteBegin", instance));
+	target.Set(Napi::String::New(env, "domainWriteCommit"), Napi::Function::New(env, js_domain_write_commit, "domainWriteCommit", instance));
+	target.Set(Napi::String::New(env, "domainReadBegin"), Napi::Function::New(env, js_domain_read_begin, "domainReadBegin", instance));
+	target.Set(Napi::String::New(env, "domainReadEnd"), Napi::Function::New(env, js_domain_read_end, "domainReadEnd", instance));
+	target.Set(Napi::String::New(env, "start"), Napi::Function::New(env, js_thread_start, "start", instance));
+	target.Set(Napi::String::New(env, "stop"), Napi::Function::New(env, js_thread_stop, "stop", instance));
+	target.Set(Napi::String::New(env, "getMasterState"), Napi::Function::New(env, js_al_states, "getMasterState", instance));
+	target.Set(Napi::String::New(env, "getLayout"), Napi::Function::New(env, js_get_layout, "getLayout", instance));
+	target.Set(Napi::String::New(env, "getDeliveryStats"), Napi::Function::New(env, js_get_delivery_stats, "getDeliveryStats", instance));
+	target.Set(Napi::String::New(env, "getCycleStats"), Napi::Function::New(env, js_get_cycle_stats, "getCycleStats", instance));
+	target.Set(Napi::String::New(env, "setOverrunPolicy"), Napi::Function::New(env, js_set_overrun_policy, "setOverrunPolicy", instance));
+	target.Set(Napi::String::New(env, "setRtConfig"), Napi::Function::New(env, js_set_rt_config, "setRtConfig", instance));
+	target.Set(Napi::String::New(env, "getRtSettings"), Napi::Function::New(env, js_get_rt_settings, "getRtSettings", instance));
+	target.Set(Napi::String::New(env, "setMemoryLock"), Napi::Function::New(env, js_set_memory_lock, "setMemoryLock", instance));
+	target.Set(Napi::String::New(env, "getMemoryReport"), Napi::Function::New(env, js_get_memory_report, "getMemoryReport", instance));
+	target.Set(Napi::String::New(env, "setDcDriftCompensation"), Napi::Function::New(env, js_set_dc_drift_compensation, "setDcDriftCompensation", instance));
+	target.Set(Napi::String::New(env, "getDcStatus"), Napi::Function::New(env, js_get_dc_status, "getDcStatus", instance));
+	target.Set(Napi::String::New(env, "setCovRule"), Napi::Function::New(env, js_set_cov_rule, "setCovRule", instance));
+	target.Set(Napi::String::New(env, "clearCovRules"), Napi::Function::New(env, js_clear_cov_rules, "clearCovRules", instance));
+	target.Set(Napi::String::New(env, "covResync"), Napi::Function::New(env, js_cov_resync, "covResync", instance));
+	target.Set(Napi::String::New(env, "axisAdd"), Napi::Function::New(env, js_axis_add, "axisAdd", instance));
+	target.Set(Napi::String::New(env, "axisEnable"), Napi::Function::New(env, js_axis_enable, "axisEnable", instance));
+	target.Set(Napi::String::New(env, "axisDisable"), Napi::Function::New(env, js_axis_disable, "axisDisable", instance));
+	target.Set(Napi::String::New(env, "axisQuickStop"), Napi::Function::New(env, js_axis_quick_stop, "axisQuickStop", instance));
+	target.Set(Napi::String::New(env, "axisFaultReset"), Napi::Function::New(env, js_axis_fault_reset, "axisFaultReset", instance));
+	target.Set(Napi::String::New(env, "axisPush"), Napi::Function::New(env, js_axis_push, "axisPush", instance));
+	target.Set(Napi::String::New(env, "axisSubmit"), Napi::Function::New(env, js_axis_submit, "axisSubmit", instance));
+	target.Set(Napi::String::New(env, "axisStatus"), Napi::Function::New(env, js_axis_status, "axisStatus", instance));
+	target.Set(Napi::String::New(env, "axisClear"), Napi::Function::New(env, js_axis_clear, "axisClear", instance));
+	target.Set(Napi::String::New(env, "recordStart"), Napi::Function::New(env, js_record_start, "recordStart", instance));
+	target.Set(Napi::String::New(env, "recordStop"), Napi::Function::New(env, js_record_stop, "recordStop", instance));
+	target.Set(Napi::String::New(env, "getRecordStatus"), Napi::Function::New(env, js_get_record_status, "getRecordStatus", instance));
+}
+
+Napi::Value js_open_master(const Napi::CallbackInfo& info)
+{
+	Napi::Env env = info.Env();
+
+	uint32_t index = info[0].As<Napi::Number>().Uint32Value();
+	Napi::Object master = Napi::Object::New(env);
+
+	export_functions(env, master, open_instance(index));
+	master.Set(Napi::String::New(env, "masterIndex"), Napi::Number::New(env, index));
+
+	return master;
+}
+
 Napi::Object InitNodeApi(Napi::Env env, Napi::Object exports)
 {
-	exports.Set(Napi::String::New(env, "setFrequency"), Napi::Function::New(env, js_set_frequency));
-	exports.Set(Napi::String::New(env, "init"), Napi::Function::New(env, js_init));
-	exports.Set(Napi::String::New(env, "setJSON"), Napi::Function::New(env, js_set_json_path));
-	exports.Set(Napi::String::New(env, "sdoWrite"), Napi::Function::New(env, js_sdo_write));
-	exports.Set(Napi::String::New(env, "sdoRead"), Napi::Function::New(env, js_sdo_read));
-	exports.Set(Napi::String::New(env, "domainWrite"), Napi::Function::New(env, js_domain_write));
-	exports.Set(Napi::String::New(env, "domainRead"), Napi::Function::New(env, js_domain_read));
-	exports.Set(Napi::String::New(env, "start"), Napi::Function::New(env, js_thread_start));
-	exports.Set(Napi::String::New(env, "stop"), Napi::Function::New(env, js_thread_stop));
-	exports.Set(Napi::String::New(env, "getMasterState"), Napi::Function::New(env, js_al_states));
+	// module itself is bound to master 0
+	export_functions(env, exports, open_instance(0));
+	exports.Set(Napi::String::New(env, "openMaster"), Napi::Function::New(env, js_open_master));
+	exports.Set(Napi::String::New(env, "readRecording"), Napi::Function::New(env, js_read_recording));
 
 	return exports;
 }
@@ -0,0 +1,117 @@
+#ifndef _FLAT_INDEX_MAP_HPP_
+#define _FLAT_INDEX_MAP_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/**
+ * Open-addressing hash table with linear probing, mapping 64-bit keys to
+ * non-negative 32-bit indexes. Built once, lookups never allocate nor throw.
+ */
+class FlatIndexMap {
+public:
+	/** Remove every element and prepare room for count elements */
+	void reserve(const size_t& count)
+	{
+		size_t capacity = 8;
+
+		// keep load factor at most 50%
+		while (capacity < count * 2) {
+			capacity <<= 1;
+		}
+
+		keys.assign(capacity, EMPTY_KEY);
+		values.assign(capacity, -1);
+		mask = capacity - 1;
+		length = 0;
+	}
+
+	void insert(const uint64_t& key, const int32_t& value)
+	{
+		if ((length + 1) * 2 > keys.size()) {
+			grow();
+		}
+
+		size_t slot = probe(key);
+
+		if (keys[slot] == EMPTY_KEY) {
+			keys[slot] = key;
+			length++;
+		}
+
+		values[slot] = value;
+	}
+
+	/** Returns -1 if key doesn't exist */
+	int32_t find(const uint64_t& key) const
+	{
+		if (!length) {
+			return -1;
+		}
+
+		return values[probe(key)];
+	}
+
+	size_t size() const
+	{
+		return length;
+	}
+
+	void clear()
+	{
+		keys.clear();
+		values.clear();
+		mask = 0;
+		length = 0;
+	}
+
+	template <typename F> void for_each(F fn) const
+	{
+		size_t capacity = keys.size();
+
+		for (size_t slot = 0; slot < capacity; slot++) {
+			if (keys[slot] != EMPTY_KEY) {
+				fn(keys[slot], values[slot]);
+			}
+		}
+	}
+
+private:
+	static constexpr uint64_t EMPTY_KEY = UINT64_MAX;
+
+	std::vector<uint64_t> keys;
+	std::vector<int32_t> values;
+	uint64_t mask = 0;
+	size_t length = 0;
+
+	// slot holding key, or the empty slot where key would be inserted
+	size_t probe(const uint64_t& key) const
+	{
+		size_t slot = (key * 0x9E3779B97F4A7C15ULL) >> 32 & mask;
+
+		while (keys[slot] != EMPTY_KEY && keys[slot] != key) {
+			slot = (slot + 1) & mask;
+		}
+
+		return slot;
+	}
+
+	void grow()
+	{
+		std::vector<uint64_t> old_keys = std::move(keys);
+		std::vector<int32_t> old_values = std::move(values);
+		size_t old_capacity = old_keys.size();
+
+		reserve(length + 1);
+
+		for (size_t slot = 0; slot < old_capacity; slot++) {
+			if (old_keys[slot] != EMPTY_KEY) {
+				insert(old_keys[slot], old_values[slot]);
+			}
+		}
+	}
+};
+
+#endif
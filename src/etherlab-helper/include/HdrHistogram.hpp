@@ -0,0 +1,197 @@
+#ifndef _HDR_HISTOGRAM_HPP_
+#define _HDR_HISTOGRAM_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Log-linear histogram of nanosecond durations, HdrHistogram style.
+ *
+ * Values below 256 ns are counted exactly, above that every power of two is
+ * split into 128 buckets, i.e. relative error is below 1%. Values above ~18
+ * minutes are clamped into the last bucket.
+ *
+ * Single writer, any number of readers. record() is wait-free and never
+ * allocates, readers may see a snapshot a few samples behind.
+ *
+ * Samples go into one of two windows. A reset clears the idle window on the
+ * reader side and asks the writer to switch over to it, so the writer never
+ * touches more than a single flag for it.
+ */
+class HdrHistogram {
+public:
+	static constexpr uint8_t SUB_BITS = 7;
+	static constexpr uint64_t SUB_COUNT = 1 << SUB_BITS;
+	static constexpr uint8_t MAX_MSB = 40;
+	static constexpr size_t BUCKETS = (MAX_MSB - SUB_BITS + 2) * SUB_COUNT;
+
+	/** Writer side */
+	void record(uint64_t value)
+	{
+		uint8_t idx = requested.load(std::memory_order_acquire);
+		if (idx != active.load(std::memory_order_relaxed)) {
+			active.store(idx, std::memory_order_release);
+		}
+
+		struct window_s& window = windows[idx];
+
+		bump(window.counts[index_of(value)]);
+		bump(window.total);
+		window.sum.store(window.sum.load(std::memory_order_relaxed) + value,
+			std::memory_order_relaxed);
+
+		if (value < window.min_value.load(std::memory_order_relaxed)) {
+			window.min_value.store(value, std::memory_order_relaxed);
+		}
+
+		if (value > window.max_value.load(std::memory_order_relaxed)) {
+			window.max_value.store(value, std::memory_order_relaxed);
+		}
+	}
+
+	/**
+	 * Reader side, clears idle window and lets writer switch to it on its
+	 * next record(). Ignored while a previous reset isn't picked up yet.
+	 * Readers must not reset concurrently.
+	 */
+	void request_reset()
+	{
+		uint8_t idx = active.load(std::memory_order_acquire);
+		if (idx != requested.load(std::memory_order_relaxed)) {
+			return;
+		}
+
+		windows[idx ^ 1].clear();
+		requested.store(idx ^ 1, std::memory_order_release);
+	}
+
+	/** Must only be called while writer is idle */
+	void reset()
+	{
+		windows[0].clear();
+		windows[1].clear();
+
+		active.store(0, std::memory_order_relaxed);
+		requested.store(0, std::memory_order_relaxed);
+	}
+
+	uint64_t count() const
+	{
+		return current().total.load(std::memory_order_relaxed);
+	}
+
+	uint64_t min() const
+	{
+		const struct window_s& window = current();
+
+		return window.total.load(std::memory_order_relaxed)
+			? window.min_value.load(std::memory_order_relaxed)
+			: 0;
+	}
+
+	uint64_t max() const
+	{
+		return current().max_value.load(std::memory_order_relaxed);
+	}
+
+	double mean() const
+	{
+		const struct window_s& window = current();
+
+		uint64_t n = window.total.load(std::memory_order_relaxed);
+		return n ? (double)window.sum.load(std::memory_order_relaxed) / n : 0;
+	}
+
+	/**
+	 * Values at given percentiles (0 - 100), sorted ascending.
+	 * Each value is the highest one equivalent to its bucket.
+	 */
+	void percentiles(const double* pct, size_t length, uint64_t* values) const
+	{
+		const struct window_s& window = current();
+
+		uint64_t n = window.total.load(std::memory_order_relaxed);
+		uint64_t seen = 0;
+		size_t pct_idx = 0;
+
+		for (size_t idx = 0; idx < BUCKETS && pct_idx < length; idx++) {
+			seen += window.counts[idx].load(std::memory_order_relaxed);
+
+			while (pct_idx < length && seen && seen >= pct[pct_idx] / 100 * n) {
+				values[pct_idx++] = highest_of(idx);
+			}
+		}
+
+		while (pct_idx < length) {
+			values[pct_idx++] = window.max_value.load(std::memory_order_relaxed);
+		}
+	}
+
+private:
+	struct window_s {
+		std::atomic<uint64_t> counts[BUCKETS] = {};
+		std::atomic<uint64_t> total { 0 };
+		std::atomic<uint64_t> sum { 0 };
+		std::atomic<uint64_t> min_value { UINT64_MAX };
+		std::atomic<uint64_t> max_value { 0 };
+
+		void clear()
+		{
+			for (std::atomic<uint64_t>& count : counts) {
+				count.store(0, std::memory_order_relaxed);
+			}
+
+			total.store(0, std::memory_order_relaxed);
+			sum.store(0, std::memory_order_relaxed);
+			min_value.store(UINT64_MAX, std::memory_order_relaxed);
+			max_value.store(0, std::memory_order_relaxed);
+		}
+	};
+
+	// window readers report on, the one writer switched to last
+	const struct window_s& current() const
+	{
+		return windows[active.load(std::memory_order_acquire)];
+	}
+
+	static size_t index_of(uint64_t value)
+	{
+		if (value < SUB_COUNT * 2) {
+			return value;
+		}
+
+		uint8_t msb = 63 - __builtin_clzll(value);
+		if (msb > MAX_MSB) {
+			return BUCKETS - 1;
+		}
+
+		uint8_t shift = msb - SUB_BITS;
+		return (shift + 1) * SUB_COUNT + ((value >> shift) - SUB_COUNT);
+	}
+
+	static uint64_t highest_of(size_t idx)
+	{
+		if (idx < SUB_COUNT * 2) {
+			return idx;
+		}
+
+		uint8_t shift = idx / SUB_COUNT - 1;
+		return (((idx % SUB_COUNT) + SUB_COUNT) << shift) + (1ULL << shift) - 1;
+	}
+
+	// single writer, no read-modify-write needed
+	static void bump(std::atomic<uint64_t>& counter)
+	{
+		counter.store(counter.load(std::memory_order_relaxed) + 1,
+			std::memory_order_relaxed);
+	}
+
+	struct window_s windows[2];
+
+	// window writer records into, and the one reader asked it to switch to
+	std::atomic<uint8_t> active { 0 };
+	std::atomic<uint8_t> requested { 0 };
+};
+
+#endif
@@ -0,0 +1,94 @@
+#ifndef _SPSC_QUEUE_HPP_
+#define _SPSC_QUEUE_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+/**
+ * Lock-free single-producer/single-consumer bounded FIFO.
+ *
+ * Storage is allocated once by reserve(), push() and pop() never allocate
+ * and never wait, so either side may be a realtime thread.
+ */
+template <typename T> class SpscQueue {
+public:
+	/**
+	 * Allocate room for at least capacity items and drop queued ones.
+	 * Must only be called while nobody is using the queue.
+	 */
+	void reserve(size_t capacity)
+	{
+		size_t size = 1;
+		while (size < capacity + 1) {
+			size <<= 1;
+		}
+
+		slots.assign(size, T {});
+		mask = size - 1;
+
+		head.store(0, std::memory_order_relaxed);
+		tail.store(0, std::memory_order_relaxed);
+	}
+
+	/** Number of items queue can hold */
+	size_t capacity() const
+	{
+		return slots.empty() ? 0 : mask;
+	}
+
+	/** Producer side. Returns false if queue is full */
+	bool push(const T& item)
+	{
+		size_t t = tail.load(std::memory_order_relaxed);
+		size_t next = (t + 1) & mask;
+
+		if (slots.empty() || next == head.load(std::memory_order_acquire)) {
+			return false;
+		}
+
+		slots[t] = item;
+		tail.store(next, std::memory_order_release);
+
+		return true;
+	}
+
+	/** Consumer side. Returns false if queue is empty */
+	bool pop(T* item)
+	{
+		size_t h = head.load(std::memory_order_relaxed);
+
+		if (h == tail.load(std::memory_order_acquire)) {
+			return false;
+		}
+
+		*item = slots[h];
+		head.store((h + 1) & mask, std::memory_order_release);
+
+		return true;
+	}
+
+	/** Number of queued items, may be stale by the time it is returned */
+	size_t size() const
+	{
+		return (tail.load(std::memory_order_acquire)
+				   - head.load(std::memory_order_acquire))
+			& mask;
+	}
+
+	bool empty() const
+	{
+		return head.load(std::memory_order_acquire)
+			== tail.load(std::memory_order_acquire);
+	}
+
+private:
+	std::vector<T> slots;
+	size_t mask = 0;
+
+	// consumer and producer indexes live on separate cache lines
+	alignas(64) std::atomic<size_t> head { 0 };
+	alignas(64) std::atomic<size_t> tail { 0 };
+};
+
+#endif
@@ -0,0 +1,99 @@
+#ifndef _TRIPLE_BUFFER_HPP_
+#define _TRIPLE_BUFFER_HPP_
+
+#include <atomic>
+#include <cstdint>
+
+/**
+ * Lock-free single-producer/single-consumer triple buffer.
+ *
+ * Producer always owns a back slot and never waits for consumer. Consumer
+ * always reads the most recently published slot, any publication it didn't
+ * pick up in time is overwritten by the next one.
+ */
+template <typename T> class TripleBuffer {
+public:
+	/** Slot owned by producer. */
+	T& back()
+	{
+		return slots[back_idx];
+	}
+
+	/**
+	 * Slot published last, producer may keep reading it as long as
+	 * consumer only reads front()
+	 */
+	const T& last() const
+	{
+		return slots[last_idx];
+	}
+
+	/** Index of back slot, lets producer keep state per slot */
+	uint8_t back_index() const
+	{
+		return back_idx;
+	}
+
+	/** Slot owned by consumer, valid after update() */
+	const T& front() const
+	{
+		return slots[front_idx];
+	}
+
+	/** Apply fn to every slot, must only be called while nobody is using it */
+	template <typename F> void for_each(F fn)
+	{
+		for (T& slot : slots) {
+			fn(slot);
+		}
+	}
+
+	/**
+	 * Make back slot the latest one and take over a free slot.
+	 * Returns true if previous publication was never consumed.
+	 */
+	bool publish()
+	{
+		uint8_t prev = middle.exchange(
+			back_idx | FLAG_FRESH, std::memory_order_acq_rel);
+		last_idx = back_idx;
+		back_idx = prev & MASK_INDEX;
+
+		return prev & FLAG_FRESH;
+	}
+
+	/** Returns true if last publication hasn't been taken by consumer */
+	bool pending() const
+	{
+		return middle.load(std::memory_order_acquire) & FLAG_FRESH;
+	}
+
+	/**
+	 * Take the latest published slot as front slot.
+	 * Returns false if nothing was published since last update.
+	 */
+	bool update()
+	{
+		if (!(middle.load(std::memory_order_acquire) & FLAG_FRESH)) {
+			return false;
+		}
+
+		uint8_t prev = middle.exchange(front_idx, std::memory_order_acq_rel);
+		front_idx = prev & MASK_INDEX;
+
+		return true;
+	}
+
+private:
+	static constexpr uint8_t MASK_INDEX = 0x03;
+	static constexpr uint8_t FLAG_FRESH = 0x04;
+
+	T slots[3];
+
+	uint8_t back_idx = 0;
+	uint8_t last_idx = 1;
+	std::atomic<uint8_t> middle { 1 };
+	uint8_t front_idx = 2;
+};
+
+#endif
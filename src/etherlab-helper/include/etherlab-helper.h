@@ -2,11 +2,13 @@
 #define _ETHERLAB_HELPER_H_
 
 #include <cstdint>
-#include <map>
 #include <string>
 #include <thread>
+#include <utility>
 #include <vector>
 
+#include <FlatIndexMap.hpp>
+
 extern "C" {
 #include <ecrt.h>
 }
@@ -56,6 +58,11 @@ typedef union unit_64b_u {
 	double f64;
 } ecat_value_al;
 
+typedef double ecat_image_value_al;
+
+/** raw 8 bytes of ecat_value_al, enough for any PDO entry */
+typedef std::vector<uint64_t> ecat_raw_image_al;
+
 typedef struct ecat_slave_config_s {
 	ec_slave_info_t info;
 	ec_slave_config_state_t state;
@@ -88,27 +95,167 @@ typedef struct ecat_slave_entry_al_s {
 	uint32_t offset = 0;
 	uint32_t bit_position = 0;
 
-	ecat_value_al value;
 	uint8_t direction;
 
 	uint8_t swap_endian = 0;
 	uint8_t is_signed = 0;
 
-	ecat_value_al written_value;
-
 	uint8_t watchog_enabled = 0;
+
+	uint8_t domain = 0; /**< Index of domain the entry is registered in. */
 } ecat_slave_entry_al;
 
+/** Distributed Clocks of one slave */
+typedef struct ecat_dc_config_s {
+	ecat_pos_al position = 0; /**< Slave position. */
+	uint16_t assign_activate = 0; /**< AssignActivate word, e.g. 0x0300. */
+
+	uint32_t sync0_cycle = 0; /**< SYNC0 cycle in ns, 0 means master period. */
+	int32_t sync0_shift = 0; /**< SYNC0 shift in ns. */
+	uint32_t sync1_cycle = 0; /**< SYNC1 cycle in ns, 0 disables SYNC1. */
+	int32_t sync1_shift = 0; /**< SYNC1 shift in ns. */
+
+	bool reference_clock = false; /**< Use this slave as reference clock. */
+} ecat_dc_config_al;
+
+/** Distributed Clocks state of a master */
+typedef struct ecat_dc_report_s {
+	bool enabled = false; /**< Any slave has DC configured. */
+	bool follow_reference = false; /**< Master drift is compensated. */
+	int32_t reference_position = -1; /**< -1 means first DC capable slave. */
+
+	int32_t diff_ns = 0; /**< Last application time - reference clock. */
+	int64_t adjust_ns = 0; /**< Wakeup correction per cycle. */
+} ecat_dc_report_al;
+
+/** Domain exchanged every divisor-th cycle */
+typedef struct ecat_domain_config_s {
+	std::string name;
+	uint16_t divisor = 1;
+} ecat_domain_config_al;
+
 typedef enum sdo_req_type_en {
 	ECAT_SDO_READ = 0,
 	ECAT_SDO_WRITE = 1
 } sdo_req_type_al;
 
+/** SDO transfer serviced by cyclic thread through ecrt_sdo_request */
+typedef struct ecat_sdo_job_s {
+	uint64_t tag = 0; /**< Caller defined, returned with completion. */
+
+	ecat_pos_al position = 0; /**< Slave position. */
+	ecat_index_al index = 0; /**< SDO index. */
+	ecat_sub_al subindex = 0; /**< SDO subindex. */
+	uint8_t size = 0; /**< Transfer size in bytes, 1, 2, 4 or 8. */
+	sdo_req_type_al rtype = ECAT_SDO_READ;
+	uint32_t timeout = 0; /**< Timeout in ms, 0 means no timeout. */
+
+	ecat_value_al value = {}; /**< Written value, or value read back. */
+	int32_t retval = 0; /**< SDO::sdo_req_retval_al, or ecrt error code */
+	uint32_t abort_code = 0; /**< SDO abort code, if known */
+} ecat_sdo_job_al;
+
+/** Memory locking and page faults of cyclic thread */
+typedef struct ecat_memory_report_s {
+	bool locked = false; /**< mlockall() succeeded. */
+	uint64_t locked_bytes = 0; /**< VmLck of the process. */
+
+	uint64_t minor_faults_startup = 0; /**< Until cyclic loop started. */
+	uint64_t major_faults_startup = 0;
+
+	uint64_t minor_faults_loop = 0; /**< Since cyclic loop started. */
+	uint64_t major_faults_loop = 0;
+} ecat_memory_report_al;
+
+typedef enum axis_request_en {
+	ECAT_AXIS_DISABLE = 0,
+	ECAT_AXIS_ENABLE = 1,
+	ECAT_AXIS_QUICK_STOP = 2,
+} axis_request_al;
+
+/** CiA 402 drive driven by cyclic thread */
+typedef struct ecat_axis_config_s {
+	ecat_pos_al position = 0; /**< Slave position. */
+	int8_t mode = 8; /**< Modes of operation, 8 CSP, 9 CSV, -1 untouched. */
+	bool auto_fault_reset = false; /**< Reset faults without a request. */
+
+	double velocity_factor = 1.0; /**< Target velocity units per count/s. */
+	double hold_deceleration = 0; /**< Underrun stop ramp, 0 holds at once. */
+
+	ecat_index_al controlword = 0x6040;
+	ecat_index_al statusword = 0x6041;
+	ecat_index_al mode_of_operation = 0x6060;
+	ecat_index_al target_position = 0x607a;
+	ecat_index_al target_velocity = 0x60ff;
+	ecat_index_al position_actual = 0x6064;
+} ecat_axis_config_al;
+
+/** One cycle worth of axis targets */
+typedef struct ecat_setpoint_s {
+	int32_t position = 0;
+	int32_t velocity = 0;
+} ecat_setpoint_al;
+
+typedef enum segment_type_en {
+	ECAT_SEGMENT_SETPOINT = 0, /**< Position for one cycle, as is. */
+	ECAT_SEGMENT_LINEAR = 1, /**< Constant velocity to position. */
+	ECAT_SEGMENT_PVT = 2, /**< Cubic to position and velocity. */
+	ECAT_SEGMENT_MOVE = 3, /**< Jerk-limited rest-to-rest move. */
+} segment_type_al;
+
+/** Part of an axis trajectory, continues where previous one ended */
+typedef struct ecat_segment_s {
+	segment_type_al type = ECAT_SEGMENT_SETPOINT;
+
+	int32_t position = 0; /**< Position at the end, in counts. */
+	int32_t velocity = 0; /**< Velocity at the end (PVT), in counts/s. */
+	int64_t duration_ns = 0; /**< LINEAR and PVT only. */
+
+	double max_velocity = 0; /**< MOVE only, counts/s. */
+	double max_acceleration = 0; /**< MOVE only, counts/s^2. */
+	double max_jerk = 0; /**< MOVE only, counts/s^3. */
+} ecat_segment_al;
+
+typedef struct ecat_axis_status_s {
+	uint16_t statusword = 0;
+	uint16_t controlword = 0;
+	uint8_t state = 0; /**< CiA402::state_al */
+	int32_t position_actual = 0;
+	ecat_setpoint_al setpoint; /**< Last setpoint written to drive. */
+	size_t queued = 0; /**< Segments waiting in queue. */
+	bool holding = false; /**< Queue ran dry while moving, axis held. */
+	uint64_t underruns = 0; /**< Times queue ran dry while moving. */
+	uint64_t faults = 0; /**< Transitions into fault state. */
+} ecat_axis_status_al;
+
+/** Process data recording of a master */
+typedef struct ecat_record_report_s {
+	bool active = false; /**< Records are being written. */
+	bool pending = false; /**< File is opened when the master starts. */
+	std::string path;
+
+	uint64_t records = 0; /**< Records written to file. */
+	uint64_t dropped = 0; /**< Cycles lost because file fell behind. */
+	uint64_t bytes = 0; /**< File size. */
+} ecat_record_report_al;
+
 typedef std::vector<ecat_slave_entry_al> ecat_entries_al;
-typedef std::map<uint32_t, ecat_size_io_al> ecat_domain_map_al;
+typedef FlatIndexMap ecat_domain_map_al;
 
 /*****************************************************************************/
 
+/**
+ * EtherCAT master instance, i.e. one ecrt master with its own slaves,
+ * domains and cyclic task state. Functions below act on the instance bound
+ * to the calling thread, threads which never bind one use master 0.
+ */
+class Master;
+
+Master* open_master(const uint32_t& index);
+void use_master(Master* instance);
+Master* current_master();
+uint32_t master_index();
+
 int8_t set_json_path(const std::string& filepath);
 
 void set_period_ms(uint32_t milliseconds);
@@ -116,6 +263,14 @@ void set_period_us(uint32_t microseconds);
 void set_period(uint32_t nanoseconds);
 void set_frequency(uint32_t hertz);
 
+void set_output_refresh(uint32_t cycles);
+void set_dc_drift_compensation(bool enable);
+void set_application_time(const uint64_t& ns);
+int64_t dc_wakeup_adjust();
+void dc_report(ecat_dc_report_al* report);
+void set_memory_lock(bool enable);
+void memory_report(ecat_memory_report_al* report);
+
 uint16_t get_frequency();
 uint32_t get_period();
 
@@ -131,22 +286,59 @@ bool operational_status();
 uint8_t application_layer_states();
 
 void attach_process_data(ecat_entries_al** ptr);
+std::string domain_name(const uint8_t& domain);
 void attach_mapped_domain(ecat_domain_map_al** ptr);
 
+void attach_process_image(
+	ecat_image_value_al* image, const ecat_size_io_al& length);
+void detach_process_image();
+
 int8_t domain_write(const ecat_pos_al& s_position, const ecat_index_al& s_index,
 	const ecat_sub_al& s_subindex, const ecat_value_al& value);
 int8_t domain_read(const ecat_pos_al& s_position, const ecat_index_al& s_index,
 	const ecat_sub_al& s_subindex, ecat_value_al* value);
 
-int8_t sdo_request(const ecat_pos_al& s_position, const ecat_index_al& s_index,
-	const ecat_sub_al& s_subindex, const uint8_t& size, void* result,
-	const sdo_req_type_al& rtype, const uint32_t& timeout);
+ecat_size_io_al domain_resolve(const ecat_pos_al& s_position,
+	const ecat_index_al& s_index, const ecat_sub_al& s_subindex);
+int8_t domain_write(const ecat_size_io_al& handle, const ecat_value_al& value);
+int8_t domain_read(const ecat_size_io_al& handle, ecat_value_al* value);
+int8_t domain_write_many(const ecat_size_io_al* handles, const size_t& count,
+	const uint64_t* raw);
+int8_t domain_read_many(
+	const ecat_size_io_al* handles, const size_t& count, uint64_t* raw);
+
+void domain_write_begin();
+int8_t domain_write_commit();
+void domain_read_begin();
+void domain_read_end();
+
+int8_t sdo_request_submit(const ecat_sdo_job_al& job);
+bool sdo_request_poll(ecat_sdo_job_al* job);
+bool sdo_request_completed();
 int32_t sdo_upload(const ecat_pos_al& s_position, const ecat_index_al& s_index,
 	const ecat_sub_al& s_subindex, const size_t& size, size_t* result_size,
-	uint8_t* value);
+	uint8_t* value, uint32_t* abort_code = nullptr);
 int32_t sdo_download(const ecat_pos_al& s_position,
 	const ecat_index_al& s_index, const ecat_sub_al& s_subindex,
-	const size_t& size, uint8_t* value);
+	const size_t& size, uint8_t* value, uint32_t* abort_code = nullptr);
+std::string sdo_error_message(const uint32_t& abort_code);
+
+int32_t axis_add(const ecat_axis_config_al& config);
+int8_t axis_request(const int32_t& axis, const axis_request_al& request);
+int8_t axis_fault_reset(const int32_t& axis);
+int8_t axis_push(const int32_t& axis, const ecat_setpoint_al* setpoints,
+	const size_t& count, size_t* pushed);
+int8_t axis_submit(const int32_t& axis, const ecat_segment_al* segments,
+	const size_t& count, size_t* pushed);
+int8_t axis_status(const int32_t& axis, ecat_axis_status_al* status);
+void axis_clear();
+void axis_freeze();
+uint64_t axis_underruns();
+
+int8_t record_start(const std::string& path, const ecat_size_io_al* handles,
+	const size_t& count, const size_t& ring_records = 0);
+void record_stop();
+void record_report(ecat_record_report_al* report);
 
 namespace Domain {
 
@@ -220,8 +412,9 @@ namespace SDO {
 		ECAT_SDO_REQ_FAILED = -1,
 		ECAT_SDO_REQ_ERR_SLAVE_NOT_FOUND = -2,
 		ECAT_SDO_REQ_ERR_SLAVE_NOT_READY = -3,
-		ECAT_SDO_REQ_ERR_BUSY = -4,
+		ECAT_SDO_REQ_ERR_BUSY = -4, /**< Request queue or pool is full. */
 		ECAT_SDO_REQ_ERR = -5,
+		ECAT_SDO_REQ_ERR_TIMEOUT = -6, /**< Request stayed busy too long. */
 	} sdo_req_retval_al;
 
 	int32_t write_u8(const ecat_pos_al& s_position,
@@ -256,6 +449,46 @@ namespace SDO {
 		const ecat_index_al& s_index, const ecat_sub_al& s_subindex,
 		const uint16_t& size);
 
+	int8_t transfer_many(ecat_sdo_job_al* jobs, const size_t& count,
+		const uint16_t& max_threads = 32);
+
+	/**
+	 * SDO transfers of one bulk request while the cyclic thread is running.
+	 * As in transfer_many(), jobs of a slave run one after another in the
+	 * given order, but only as many are submitted as the request queue of
+	 * the slave takes. complete() submits the next ones.
+	 */
+	class Batch {
+	public:
+		/** jobs must outlive the batch, their tags are up to the caller */
+		void assign(ecat_sdo_job_al* jobs, const size_t& count);
+
+		/**
+		 * Submit jobs until request queues are full. A job which can't be
+		 * submitted while none of the batch is in flight fails with its
+		 * retval. Returns the number of jobs not completed yet.
+		 */
+		size_t submit();
+
+		/** A job of the batch came back from sdo_request_poll() */
+		size_t complete();
+
+		/** Fail jobs not submitted yet, e.g. once the bus is stopped */
+		size_t cancel();
+
+	private:
+		ecat_sdo_job_al* jobs = nullptr;
+
+		// jobs grouped per slave, keeping their order
+		std::vector<size_t> order;
+
+		// next and end index into order for every slave
+		std::vector<std::pair<size_t, size_t>> lanes;
+
+		size_t in_flight = 0;
+		size_t pending = 0;
+	};
+
 }
 
 }
@@ -0,0 +1,1247 @@
+#include <time.h>
+
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <rapidjson/document.h>
+
+extern "C" {
+#include "ecrt.h"
+}
+
+// cycles a configured slave needs from activation to OP, unless set per slave
+#define SIM_STARTUP_CYCLES 10
+
+// CoE abort codes
+#define SIM_ABORT_NO_OBJECT 0x06020000
+#define SIM_ABORT_NO_SLAVE 0x08000020
+
+/****************************************************************************/
+
+struct sim_counter_s {
+	uint16_t index = 0;
+	uint8_t subindex = 0;
+	int64_t step = 1;
+};
+
+// slave on the simulated bus, described by slave JSON
+struct sim_slave_s {
+	ec_slave_info_t info = {};
+
+	// behaviour
+	bool loopback = false;
+	std::vector<struct sim_counter_s> counters;
+	uint64_t latency_ns = 0;
+	uint64_t jitter_ns = 0;
+	uint32_t startup_cycles = SIM_STARTUP_CYCLES;
+	uint32_t sdo_cycles = 1;
+
+	// reference clock time minus application time, if slave is the
+	// reference clock
+	int64_t clock_offset_ns = 0;
+
+	// object dictionary, key is index << 8 | subindex
+	std::map<uint32_t, std::vector<uint8_t>> objects;
+
+	uint8_t al_state = EC_AL_STATE_PREOP;
+	uint32_t startup_left = 0;
+	bool configured = false;
+};
+
+struct sim_bus_s {
+	std::vector<struct sim_slave_s> slaves;
+	bool requested = false;
+
+	std::atomic<uint64_t> frames_sent { 0 };
+	std::atomic<uint64_t> frames_received { 0 };
+	std::atomic<uint64_t> frames_late { 0 };
+	std::atomic<uint64_t> sdo_transfers { 0 };
+};
+
+// buses live until process exits, masters keep a pointer to theirs
+static std::mutex buses_lock;
+static std::map<unsigned int, struct sim_bus_s> buses;
+
+/****************************************************************************/
+
+struct sim_entry_s {
+	uint16_t index = 0;
+	uint8_t subindex = 0;
+	uint8_t bits = 0;
+};
+
+struct sim_sync_s {
+	ec_direction_t direction = EC_DIR_INVALID;
+	std::vector<uint16_t> pdos;
+};
+
+struct ec_slave_config {
+	ec_master_t* master = nullptr;
+	uint16_t alias = 0;
+	uint16_t position = 0;
+	uint32_t vendor_id = 0;
+	uint32_t product_code = 0;
+
+	// nullptr if no matching slave is on the bus
+	struct sim_slave_s* slave = nullptr;
+
+	struct sim_sync_s syncs[EC_MAX_SYNC_MANAGERS];
+	std::map<uint16_t, std::vector<struct sim_entry_s>> mappings;
+
+	// startup SDOs, written into the dictionary on activation
+	std::vector<std::pair<uint32_t, std::vector<uint8_t>>> sdos;
+
+	uint16_t dc_assign_activate = 0;
+};
+
+// process data of one sync manager of one slave within a domain
+struct sim_fmmu_s {
+	ec_slave_config_t* sc = nullptr;
+	uint8_t sync_index = 0;
+	ec_direction_t direction = EC_DIR_INVALID;
+	uint32_t offset = 0;
+	uint32_t size = 0;
+};
+
+// output of a slave copied into its input, source is the sent image
+struct sim_loopback_s {
+	ec_slave_config_t* sc = nullptr;
+	const ec_domain_t* source = nullptr;
+	uint32_t source_bit = 0;
+	uint32_t bit = 0;
+	uint8_t bits = 0;
+};
+
+struct sim_count_s {
+	ec_slave_config_t* sc = nullptr;
+	uint32_t bit = 0;
+	uint8_t bits = 0;
+	int64_t step = 0;
+};
+
+struct ec_domain {
+	ec_master_t* master = nullptr;
+
+	std::vector<uint8_t> data;
+	std::vector<uint8_t> sent;
+	std::vector<struct sim_fmmu_s> fmmus;
+	unsigned int expected_wc = 0;
+
+	// behaviours applied to inputs of this domain
+	std::vector<struct sim_loopback_s> loopbacks;
+	std::vector<struct sim_count_s> counts;
+
+	// queued with the frame in flight, and whether it came back
+	bool queued = false;
+	bool exchanged = false;
+
+	ec_domain_state_t state = {};
+};
+
+struct ec_sdo_request {
+	ec_slave_config_t* sc = nullptr;
+	uint16_t index = 0;
+	uint8_t subindex = 0;
+
+	std::vector<uint8_t> data;
+	size_t data_size = 0;
+
+	ec_request_state_t state = EC_REQUEST_UNUSED;
+	bool write = false;
+	uint32_t cycles_left = 0;
+};
+
+struct ec_master {
+	unsigned int index = 0;
+	struct sim_bus_s* bus = nullptr;
+
+	std::vector<std::unique_ptr<ec_slave_config_t>> configs;
+	std::vector<std::unique_ptr<ec_domain_t>> domains;
+	std::vector<std::unique_ptr<ec_sdo_request_t>> requests;
+
+	bool active = false;
+
+	// frame in flight, due when round trip of the bus has elapsed
+	bool frame_sent = false;
+	uint64_t frame_due_ns = 0;
+	uint64_t latency_ns = 0;
+	uint64_t jitter_ns = 0;
+	std::minstd_rand rng;
+
+	uint64_t app_time = 0;
+	uint64_t prev_app_time = 0;
+
+	// selected, or first slave configured for DC
+	ec_slave_config_t* reference_clock = nullptr;
+
+	// dictionaries are accessed by cyclic thread and by blocking transfers
+	std::mutex objects_lock;
+};
+
+/****************************************************************************/
+
+static uint64_t now_ns()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t)ts.tv_sec * 1'000'000'000 + ts.tv_nsec;
+}
+
+static uint32_t object_key(const uint16_t& index, const uint8_t& subindex)
+{
+	return ((uint32_t)index << 8) | subindex;
+}
+
+static std::vector<uint8_t> le_bytes(uint64_t value, const size_t& size)
+{
+	std::vector<uint8_t> bytes(size);
+	for (size_t idx = 0; idx < size; idx++, value >>= 8) {
+		bytes[idx] = value & 0xff;
+	}
+
+	return bytes;
+}
+
+static uint64_t get_bits(
+	const uint8_t* data, const uint32_t& bit, const uint8_t& bits)
+{
+	uint64_t value = 0;
+
+	if (!(bit % 8) && !(bits % 8)) {
+		for (uint8_t idx = 0; idx < bits / 8; idx++) {
+			value |= (uint64_t)data[bit / 8 + idx] << (idx * 8);
+		}
+
+		return value;
+	}
+
+	for (uint8_t idx = 0; idx < bits; idx++) {
+		uint32_t pos = bit + idx;
+		value |= (uint64_t)((data[pos / 8] >> (pos % 8)) & 1) << idx;
+	}
+
+	return value;
+}
+
+static void set_bits(
+	uint8_t* data, const uint32_t& bit, const uint8_t& bits, uint64_t value)
+{
+	if (!(bit % 8) && !(bits % 8)) {
+		for (uint8_t idx = 0; idx < bits / 8; idx++, value >>= 8) {
+			data[bit / 8 + idx] = value & 0xff;
+		}
+
+		return;
+	}
+
+	for (uint8_t idx = 0; idx < bits; idx++) {
+		uint32_t pos = bit + idx;
+		uint8_t mask = 1 << (pos % 8);
+
+		if ((value >> idx) & 1) {
+			data[pos / 8] |= mask;
+		} else {
+			data[pos / 8] &= ~mask;
+		}
+	}
+}
+
+static bool is_operational(const ec_slave_config_t* sc)
+{
+	return sc->slave && sc->slave->al_state == EC_AL_STATE_OP;
+}
+
+// sync managers without explicit configuration follow the usual layout,
+// SM0/SM2 outputs and SM1/SM3 inputs
+static ec_direction_t sync_direction(
+	const ec_slave_config_t* sc, const uint8_t& sync_index)
+{
+	ec_direction_t direction = sc->syncs[sync_index].direction;
+	if (direction != EC_DIR_INVALID) {
+		return direction;
+	}
+
+	return sync_index % 2 ? EC_DIR_INPUT : EC_DIR_OUTPUT;
+}
+
+static uint32_t sync_bits(const ec_slave_config_t* sc, const uint8_t& sync_index)
+{
+	uint32_t bits = 0;
+
+	for (const uint16_t& pdo : sc->syncs[sync_index].pdos) {
+		auto mapping = sc->mappings.find(pdo);
+		if (mapping == sc->mappings.end()) {
+			continue;
+		}
+
+		for (const struct sim_entry_s& entry : mapping->second) {
+			bits += entry.bits;
+		}
+	}
+
+	return bits;
+}
+
+static struct sim_fmmu_s* find_fmmu(const ec_domain_t* domain,
+	const ec_slave_config_t* sc, const uint8_t& sync_index)
+{
+	for (const struct sim_fmmu_s& fmmu : domain->fmmus) {
+		if (fmmu.sc == sc && fmmu.sync_index == sync_index) {
+			return (struct sim_fmmu_s*)&fmmu;
+		}
+	}
+
+	return nullptr;
+}
+
+// byte offset of sync manager's process data within domain, appended when
+// first used, the same as FMMUs are laid out by the master
+static uint32_t prepare_fmmu(
+	ec_domain_t* domain, ec_slave_config_t* sc, const uint8_t& sync_index)
+{
+	struct sim_fmmu_s* found = find_fmmu(domain, sc, sync_index);
+	if (found) {
+		return found->offset;
+	}
+
+	struct sim_fmmu_s fmmu;
+	fmmu.sc = sc;
+	fmmu.sync_index = sync_index;
+	fmmu.direction = sync_direction(sc, sync_index);
+	fmmu.offset = domain->data.size();
+	fmmu.size = (sync_bits(sc, sync_index) + 7) / 8;
+
+	domain->data.resize(fmmu.offset + fmmu.size, 0);
+	domain->expected_wc += fmmu.direction == EC_DIR_OUTPUT ? 2 : 1;
+	domain->fmmus.push_back(fmmu);
+
+	return fmmu.offset;
+}
+
+// mapped entries of a slave in given direction that are part of a domain,
+// in mapping order, gaps left out
+struct sim_location_s {
+	ec_domain_t* domain = nullptr;
+	uint32_t bit = 0;
+	struct sim_entry_s entry;
+};
+
+static std::vector<struct sim_location_s> locate_entries(
+	ec_master_t* master, ec_slave_config_t* sc, const ec_direction_t& direction)
+{
+	std::vector<struct sim_location_s> locations;
+
+	for (uint8_t sync_index = 0; sync_index < EC_MAX_SYNC_MANAGERS;
+		 sync_index++) {
+		if (sync_direction(sc, sync_index) != direction) {
+			continue;
+		}
+
+		for (std::unique_ptr<ec_domain_t>& domain : master->domains) {
+			struct sim_fmmu_s* fmmu
+				= find_fmmu(domain.get(), sc, sync_index);
+			if (!fmmu) {
+				continue;
+			}
+
+			uint32_t bit = fmmu->offset * 8;
+
+			for (const uint16_t& pdo : sc->syncs[sync_index].pdos) {
+				auto mapping = sc->mappings.find(pdo);
+				if (mapping == sc->mappings.end()) {
+					continue;
+				}
+
+				for (const struct sim_entry_s& entry : mapping->second) {
+					if (entry.index) {
+						locations.push_back({ domain.get(), bit, entry });
+					}
+
+					bit += entry.bits;
+				}
+			}
+		}
+	}
+
+	return locations;
+}
+
+static void build_behaviours(ec_master_t* master)
+{
+	for (std::unique_ptr<ec_domain_t>& domain : master->domains) {
+		domain->loopbacks.clear();
+		domain->counts.clear();
+	}
+
+	for (std::unique_ptr<ec_slave_config_t>& sc : master->configs) {
+		if (!sc->slave) {
+			continue;
+		}
+
+		std::vector<struct sim_location_s> inputs
+			= locate_entries(master, sc.get(), EC_DIR_INPUT);
+
+		// n-th output goes into n-th input
+		if (sc->slave->loopback) {
+			std::vector<struct sim_location_s> outputs
+				= locate_entries(master, sc.get(), EC_DIR_OUTPUT);
+
+			size_t length = std::min(inputs.size(), outputs.size());
+			for (size_t idx = 0; idx < length; idx++) {
+				inputs[idx].domain->loopbacks.push_back({
+					.sc = sc.get(),
+					.source = outputs[idx].domain,
+					.source_bit = outputs[idx].bit,
+					.bit = inputs[idx].bit,
+					.bits = std::min(
+						inputs[idx].entry.bits, outputs[idx].entry.bits),
+				});
+			}
+		}
+
+		for (const struct sim_counter_s& counter : sc->slave->counters) {
+			for (const struct sim_location_s& input : inputs) {
+				if (input.entry.index == counter.index
+					&& input.entry.subindex == counter.subindex) {
+					input.domain->counts.push_back({
+						.sc = sc.get(),
+						.bit = input.bit,
+						.bits = input.entry.bits,
+						.step = counter.step,
+					});
+				}
+			}
+		}
+	}
+}
+
+static void sdo_request_complete(ec_master_t* master, ec_sdo_request_t* req)
+{
+	struct sim_slave_s* slave = req->sc->slave;
+	if (!slave) {
+		req->state = EC_REQUEST_ERROR;
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(master->objects_lock);
+	uint32_t key = object_key(req->index, req->subindex);
+
+	if (req->write) {
+		slave->objects[key].assign(
+			req->data.begin(), req->data.begin() + req->data_size);
+		req->state = EC_REQUEST_SUCCESS;
+	} else {
+		auto object = slave->objects.find(key);
+
+		if (object == slave->objects.end()) {
+			req->state = EC_REQUEST_ERROR;
+		} else {
+			req->data_size = std::min(req->data.size(), object->second.size());
+			memcpy(req->data.data(), object->second.data(), req->data_size);
+			req->state = EC_REQUEST_SUCCESS;
+		}
+	}
+
+	master->bus->sdo_transfers.fetch_add(1, std::memory_order_relaxed);
+}
+
+/****************************************************************************/
+
+static uint64_t json_number(const rapidjson::Value& value)
+{
+	if (value.IsUint64()) {
+		return value.GetUint64();
+	} else if (value.IsInt64()) {
+		return value.GetInt64();
+	} else if (value.IsString()) {
+		return strtoull(value.GetString(), nullptr, 0);
+	} else if (value.IsBool()) {
+		return value.GetBool();
+	}
+
+	return 0;
+}
+
+static uint64_t json_member(const rapidjson::Value& object, const char* name,
+	const uint64_t& fallback = 0)
+{
+	auto member = object.FindMember(name);
+	return member == object.MemberEnd() ? fallback : json_number(member->value);
+}
+
+static void parse_simulation(
+	const rapidjson::Value& sim, struct sim_slave_s* slave)
+{
+	slave->loopback = json_member(sim, "loopback");
+	slave->latency_ns = json_member(sim, "latency_ns");
+	slave->jitter_ns = json_member(sim, "jitter_ns");
+	slave->startup_cycles
+		= json_member(sim, "startup_cycles", SIM_STARTUP_CYCLES);
+	slave->sdo_cycles = std::max<uint64_t>(json_member(sim, "sdo_cycles", 1), 1);
+	slave->clock_offset_ns = (int64_t)json_member(sim, "clock_offset_ns");
+
+	auto counters = sim.FindMember("counters");
+	if (counters != sim.MemberEnd() && counters->value.IsArray()) {
+		for (const rapidjson::Value& counter : counters->value.GetArray()) {
+			slave->counters.push_back({
+				.index = (uint16_t)json_member(counter, "index"),
+				.subindex = (uint8_t)json_member(counter, "subindex"),
+				.step = (int64_t)json_member(counter, "step", 1),
+			});
+		}
+	}
+
+	auto objects = sim.FindMember("objects");
+	if (objects != sim.MemberEnd() && objects->value.IsArray()) {
+		for (const rapidjson::Value& object : objects->value.GetArray()) {
+			uint32_t key = object_key(json_member(object, "index"),
+				json_member(object, "subindex"));
+			size_t size = json_member(object, "size", 32) / 8;
+
+			slave->objects[key]
+				= le_bytes(json_member(object, "value"), size ? size : 1);
+		}
+	}
+}
+
+/****************************************************************************/
+
+extern "C" {
+
+int ecrt_sim_load(unsigned int master_index, const char* json_path)
+{
+	std::ifstream file(json_path);
+	if (!file) {
+		fprintf(stderr, "Simulation: can't open %s\n", json_path);
+		return -ENOENT;
+	}
+
+	std::stringstream content;
+	content << file.rdbuf();
+
+	// same relaxed JSON as the configuration parser accepts
+	rapidjson::Document doc;
+	doc.Parse<rapidjson::kParseTrailingCommasFlag
+		| rapidjson::kParseCommentsFlag | rapidjson::kParseEscapedApostropheFlag
+		| rapidjson::kParseNanAndInfFlag>(content.str().c_str());
+
+	// either an array of slaves, or an object with 'slaves' and 'domains'
+	const rapidjson::Value* list = &doc;
+	if (!doc.HasParseError() && doc.IsObject()) {
+		auto member = doc.FindMember("slaves");
+		list = member == doc.MemberEnd() ? nullptr : &member->value;
+	}
+
+	if (doc.HasParseError() || !list || !list->IsArray()) {
+		fprintf(stderr, "Simulation: %s is not a slave list\n", json_path);
+		return -EINVAL;
+	}
+
+	std::vector<struct sim_slave_s> slaves;
+
+	for (const rapidjson::Value& item : list->GetArray()) {
+		struct sim_slave_s slave;
+		ec_slave_info_t& info = slave.info;
+
+		info.position = json_member(item, "position", slaves.size());
+		info.alias = json_member(item, "alias");
+		info.vendor_id = json_member(item, "vendor_id");
+		info.product_code = json_member(item, "product_code");
+		info.revision_number = json_member(item, "revision");
+		info.serial_number = json_member(item, "serial");
+
+		snprintf(info.name, sizeof(info.name), "Simulated 0x%08x:0x%08x",
+			info.vendor_id, info.product_code);
+
+		auto sim = item.FindMember("simulation");
+		if (sim != item.MemberEnd() && sim->value.IsObject()) {
+			parse_simulation(sim->value, &slave);
+		}
+
+		slaves.push_back(std::move(slave));
+	}
+
+	std::lock_guard<std::mutex> lock(buses_lock);
+
+	struct sim_bus_s& bus = buses[master_index];
+	if (bus.requested) {
+		fprintf(stderr, "Simulation: master %u is in use\n", master_index);
+		return -EBUSY;
+	}
+
+	bus.slaves = std::move(slaves);
+
+	return 0;
+}
+
+int ecrt_sim_stats(unsigned int master_index, ec_sim_stats_t* stats)
+{
+	std::lock_guard<std::mutex> lock(buses_lock);
+
+	auto bus = buses.find(master_index);
+	if (bus == buses.end()) {
+		return -ENOENT;
+	}
+
+	stats->frames_sent = bus->second.frames_sent.load();
+	stats->frames_received = bus->second.frames_received.load();
+	stats->frames_late = bus->second.frames_late.load();
+	stats->sdo_transfers = bus->second.sdo_transfers.load();
+
+	return 0;
+}
+
+/****************************************************************************/
+
+ec_master_t* ecrt_request_master(unsigned int master_index)
+{
+	std::lock_guard<std::mutex> lock(buses_lock);
+
+	struct sim_bus_s& bus = buses[master_index];
+	if (bus.requested) {
+		return nullptr;
+	}
+
+	if (bus.slaves.empty()) {
+		fprintf(stderr, "Simulation: bus of master %u has no slaves\n",
+			master_index);
+	}
+
+	ec_master_t* master = new ec_master_t();
+	master->index = master_index;
+	master->bus = &bus;
+	master->rng.seed(master_index + 1);
+
+	// every slave adds its processing time to the round trip
+	for (struct sim_slave_s& slave : bus.slaves) {
+		master->latency_ns += slave.latency_ns;
+		master->jitter_ns += slave.jitter_ns;
+
+		slave.al_state = EC_AL_STATE_PREOP;
+		slave.configured = false;
+	}
+
+	bus.requested = true;
+
+	return master;
+}
+
+void ecrt_release_master(ec_master_t* master)
+{
+	std::lock_guard<std::mutex> lock(buses_lock);
+
+	for (struct sim_slave_s& slave : master->bus->slaves) {
+		slave.al_state = EC_AL_STATE_PREOP;
+		slave.configured = false;
+	}
+
+	master->bus->requested = false;
+	delete master;
+}
+
+ec_domain_t* ecrt_master_create_domain(ec_master_t* master)
+{
+	if (master->active) {
+		return nullptr;
+	}
+
+	master->domains.emplace_back(new ec_domain_t());
+	master->domains.back()->master = master;
+
+	return master->domains.back().get();
+}
+
+ec_slave_config_t* ecrt_master_slave_config(ec_master_t* master,
+	uint16_t alias, uint16_t position, uint32_t vendor_id,
+	uint32_t product_code)
+{
+	for (std::unique_ptr<ec_slave_config_t>& sc : master->configs) {
+		if (sc->alias == alias && sc->position == position) {
+			if (sc->vendor_id != vendor_id
+				|| sc->product_code != product_code) {
+				return nullptr;
+			}
+
+			return sc.get();
+		}
+	}
+
+	if (master->active) {
+		return nullptr;
+	}
+
+	ec_slave_config_t* sc = new ec_slave_config_t();
+	sc->master = master;
+	sc->alias = alias;
+	sc->position = position;
+	sc->vendor_id = vendor_id;
+	sc->product_code = product_code;
+
+	for (struct sim_slave_s& slave : master->bus->slaves) {
+		if (slave.info.position != position) {
+			continue;
+		}
+
+		if (slave.info.vendor_id == vendor_id
+			&& slave.info.product_code == product_code) {
+			sc->slave = &slave;
+		} else {
+			fprintf(stderr,
+				"Simulation: slave %u is 0x%08x:0x%08x, configured as "
+				"0x%08x:0x%08x\n",
+				position, slave.info.vendor_id, slave.info.product_code,
+				vendor_id, product_code);
+		}
+	}
+
+	master->configs.emplace_back(sc);
+
+	return sc;
+}
+
+int ecrt_master_select_reference_clock(
+	ec_master_t* master, ec_slave_config_t* sc)
+{
+	if (sc && sc->master != master) {
+		return -EINVAL;
+	}
+
+	master->reference_clock = sc;
+
+	return 0;
+}
+
+int ecrt_master_get_slave(ec_master_t* master, uint16_t slave_position,
+	ec_slave_info_t* slave_info)
+{
+	for (const struct sim_slave_s& slave : master->bus->slaves) {
+		if (slave.info.position == slave_position) {
+			*slave_info = slave.info;
+			slave_info->al_state = slave.al_state;
+
+			return 0;
+		}
+	}
+
+	return -ENOENT;
+}
+
+int ecrt_master_sdo_download(ec_master_t* master, uint16_t slave_position,
+	uint16_t index, uint8_t subindex, const uint8_t* data, size_t data_size,
+	uint32_t* abort_code)
+{
+	std::lock_guard<std::mutex> lock(master->objects_lock);
+
+	for (struct sim_slave_s& slave : master->bus->slaves) {
+		if (slave.info.position == slave_position) {
+			slave.objects[object_key(index, subindex)].assign(
+				data, data + data_size);
+			master->bus->sdo_transfers.fetch_add(1, std::memory_order_relaxed);
+
+			return 0;
+		}
+	}
+
+	if (abort_code) {
+		*abort_code = SIM_ABORT_NO_SLAVE;
+	}
+
+	return -EIO;
+}
+
+int ecrt_master_sdo_upload(ec_master_t* master, uint16_t slave_position,
+	uint16_t index, uint8_t subindex, uint8_t* target, size_t target_size,
+	size_t* result_size, uint32_t* abort_code)
+{
+	std::lock_guard<std::mutex> lock(master->objects_lock);
+
+	for (struct sim_slave_s& slave : master->bus->slaves) {
+		if (slave.info.position != slave_position) {
+			continue;
+		}
+
+		auto object = slave.objects.find(object_key(index, subindex));
+		if (object == slave.objects.end()) {
+			if (abort_code) {
+				*abort_code = SIM_ABORT_NO_OBJECT;
+			}
+
+			return -EIO;
+		}
+
+		*result_size = std::min(target_size, object->second.size());
+		memcpy(target, object->second.data(), *result_size);
+		master->bus->sdo_transfers.fetch_add(1, std::memory_order_relaxed);
+
+		return 0;
+	}
+
+	if (abort_code) {
+		*abort_code = SIM_ABORT_NO_SLAVE;
+	}
+
+	return -EIO;
+}
+
+int ecrt_master_activate(ec_master_t* master)
+{
+	if (master->active) {
+		return -EBUSY;
+	}
+
+	for (std::unique_ptr<ec_slave_config_t>& sc : master->configs) {
+		struct sim_slave_s* slave = sc->slave;
+		if (!slave) {
+			continue;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(master->objects_lock);
+			for (auto& [key, value] : sc->sdos) {
+				slave->objects[key] = value;
+			}
+		}
+
+		slave->configured = true;
+		slave->startup_left = slave->startup_cycles;
+		slave->al_state = slave->startup_left ? EC_AL_STATE_PREOP
+											  : EC_AL_STATE_OP;
+	}
+
+	for (std::unique_ptr<ec_domain_t>& domain : master->domains) {
+		std::fill(domain->data.begin(), domain->data.end(), 0);
+		domain->sent.assign(domain->data.size(), 0);
+		domain->state = {};
+	}
+
+	build_behaviours(master);
+
+	master->frame_sent = false;
+	master->active = true;
+
+	return 0;
+}
+
+int ecrt_master_deactivate(ec_master_t* master)
+{
+	master->active = false;
+	master->frame_sent = false;
+
+	for (struct sim_slave_s& slave : master->bus->slaves) {
+		slave.al_state = EC_AL_STATE_PREOP;
+	}
+
+	return 0;
+}
+
+int ecrt_master_send(ec_master_t* master)
+{
+	if (!master->active) {
+		return 0;
+	}
+
+	uint64_t jitter = master->jitter_ns ? master->rng() % master->jitter_ns : 0;
+
+	master->frame_sent = true;
+	master->frame_due_ns = now_ns() + master->latency_ns + jitter;
+	master->bus->frames_sent.fetch_add(1, std::memory_order_relaxed);
+
+	return 0;
+}
+
+int ecrt_master_receive(ec_master_t* master)
+{
+	if (!master->active) {
+		return 0;
+	}
+
+	// a frame not back by now is lost, its domains are not updated
+	bool received = false;
+	if (master->frame_sent) {
+		received = now_ns() >= master->frame_due_ns;
+		master->frame_sent = false;
+
+		(received ? master->bus->frames_received : master->bus->frames_late)
+			.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	// domains not queued this cycle keep the result of their last frame
+	// until they are processed, e.g. with a divisor above 1
+	for (std::unique_ptr<ec_domain_t>& domain : master->domains) {
+		if (domain->queued) {
+			domain->exchanged = received;
+			domain->queued = false;
+		}
+	}
+
+	// slaves reach OP a number of cycles after activation
+	for (struct sim_slave_s& slave : master->bus->slaves) {
+		if (slave.configured && slave.startup_left && !--slave.startup_left) {
+			slave.al_state = EC_AL_STATE_OP;
+		}
+	}
+
+	for (std::unique_ptr<ec_sdo_request_t>& req : master->requests) {
+		if (req->state == EC_REQUEST_BUSY && !--req->cycles_left) {
+			sdo_request_complete(master, req.get());
+		}
+	}
+
+	return 0;
+}
+
+int ecrt_master_state(const ec_master_t* master, ec_master_state_t* state)
+{
+	uint8_t al_states = 0;
+	for (const struct sim_slave_s& slave : master->bus->slaves) {
+		al_states |= slave.al_state;
+	}
+
+	state->slaves_responding = master->bus->slaves.size();
+	state->al_states = al_states;
+	state->link_up = !master->bus->slaves.empty();
+
+	return 0;
+}
+
+int ecrt_master_application_time(ec_master_t* master, uint64_t app_time)
+{
+	master->prev_app_time = master->app_time;
+	master->app_time = app_time;
+
+	return 0;
+}
+
+int ecrt_master_sync_reference_clock(ec_master_t* master)
+{
+	return 0;
+}
+
+int ecrt_master_sync_slave_clocks(ec_master_t* master)
+{
+	return 0;
+}
+
+// reference clock is ideal, it latched the application time of last frame
+int ecrt_master_reference_clock_time(ec_master_t* master, uint32_t* time)
+{
+	const ec_slave_config_t* sc = master->reference_clock;
+	int64_t offset = sc && sc->slave ? sc->slave->clock_offset_ns : 0;
+
+	*time = (uint32_t)(master->prev_app_time + offset);
+
+	return 0;
+}
+
+/****************************************************************************/
+
+int ecrt_slave_config_sync_manager(ec_slave_config_t* sc, uint8_t sync_index,
+	ec_direction_t direction, ec_watchdog_mode_t watchdog_mode)
+{
+	if (sync_index >= EC_MAX_SYNC_MANAGERS) {
+		return -ENOENT;
+	}
+
+	sc->syncs[sync_index].direction = direction;
+
+	return 0;
+}
+
+int ecrt_slave_config_pdo_assign_add(
+	ec_slave_config_t* sc, uint8_t sync_index, uint16_t index)
+{
+	if (sync_index >= EC_MAX_SYNC_MANAGERS) {
+		return -EINVAL;
+	}
+
+	sc->syncs[sync_index].pdos.push_back(index);
+
+	return 0;
+}
+
+void ecrt_slave_config_pdo_assign_clear(
+	ec_slave_config_t* sc, uint8_t sync_index)
+{
+	if (sync_index < EC_MAX_SYNC_MANAGERS) {
+		sc->syncs[sync_index].pdos.clear();
+	}
+}
+
+int ecrt_slave_config_pdo_mapping_add(ec_slave_config_t* sc,
+	uint16_t pdo_index, uint16_t entry_index, uint8_t entry_subindex,
+	uint8_t entry_bit_length)
+{
+	sc->mappings[pdo_index].push_back({
+		.index = entry_index,
+		.subindex = entry_subindex,
+		.bits = entry_bit_length,
+	});
+
+	return 0;
+}
+
+void ecrt_slave_config_pdo_mapping_clear(
+	ec_slave_config_t* sc, uint16_t pdo_index)
+{
+	sc->mappings[pdo_index].clear();
+}
+
+int ecrt_slave_config_sdo8(ec_slave_config_t* sc, uint16_t sdo_index,
+	uint8_t sdo_subindex, uint8_t value)
+{
+	sc->sdos.push_back({ object_key(sdo_index, sdo_subindex), le_bytes(value, 1) });
+
+	return 0;
+}
+
+int ecrt_slave_config_sdo16(ec_slave_config_t* sc, uint16_t sdo_index,
+	uint8_t sdo_subindex, uint16_t value)
+{
+	sc->sdos.push_back({ object_key(sdo_index, sdo_subindex), le_bytes(value, 2) });
+
+	return 0;
+}
+
+int ecrt_slave_config_sdo32(ec_slave_config_t* sc, uint16_t sdo_index,
+	uint8_t sdo_subindex, uint32_t value)
+{
+	sc->sdos.push_back({ object_key(sdo_index, sdo_subindex), le_bytes(value, 4) });
+
+	return 0;
+}
+
+int ecrt_slave_config_dc(ec_slave_config_t* sc, uint16_t assign_activate,
+	uint32_t sync0_cycle, int32_t sync0_shift, uint32_t sync1_cycle,
+	int32_t sync1_shift)
+{
+	sc->dc_assign_activate = assign_activate;
+
+	if (!sc->master->reference_clock) {
+		sc->master->reference_clock = sc;
+	}
+
+	return 0;
+}
+
+ec_sdo_request_t* ecrt_slave_config_create_sdo_request(
+	ec_slave_config_t* sc, uint16_t index, uint8_t subindex, size_t size)
+{
+	ec_sdo_request_t* req = new ec_sdo_request_t();
+	req->sc = sc;
+	req->index = index;
+	req->subindex = subindex;
+	req->data.assign(size, 0);
+	req->data_size = size;
+
+	sc->master->requests.emplace_back(req);
+
+	return req;
+}
+
+int ecrt_slave_config_state(
+	const ec_slave_config_t* sc, ec_slave_config_state_t* state)
+{
+	state->online = sc->slave != nullptr;
+	state->operational = is_operational(sc);
+	state->al_state = sc->slave ? sc->slave->al_state : 0;
+
+	return 0;
+}
+
+/****************************************************************************/
+
+int ecrt_domain_reg_pdo_entry_list(
+	ec_domain_t* domain, const ec_pdo_entry_reg_t* pdo_entry_regs)
+{
+	for (const ec_pdo_entry_reg_t* reg = pdo_entry_regs; reg->index; reg++) {
+		ec_slave_config_t* sc = ecrt_master_slave_config(domain->master,
+			reg->alias, reg->position, reg->vendor_id, reg->product_code);
+		if (!sc) {
+			return -ENOENT;
+		}
+
+		bool found = false;
+
+		for (uint8_t sync_index = 0;
+			 sync_index < EC_MAX_SYNC_MANAGERS && !found; sync_index++) {
+			uint32_t bit = 0;
+
+			for (const uint16_t& pdo : sc->syncs[sync_index].pdos) {
+				auto mapping = sc->mappings.find(pdo);
+				if (mapping == sc->mappings.end()) {
+					continue;
+				}
+
+				for (const struct sim_entry_s& entry : mapping->second) {
+					if (entry.index == reg->index
+						&& entry.subindex == reg->subindex) {
+						found = true;
+						break;
+					}
+
+					bit += entry.bits;
+				}
+
+				if (found) {
+					break;
+				}
+			}
+
+			if (!found) {
+				continue;
+			}
+
+			uint32_t offset = prepare_fmmu(domain, sc, sync_index);
+
+			if (!reg->bit_position && bit % 8) {
+				fprintf(stderr,
+					"Simulation: 0x%04x:%02x of slave %u is not byte "
+					"aligned\n",
+					reg->index, reg->subindex, reg->position);
+				return -EFAULT;
+			}
+
+			*reg->offset = offset + bit / 8;
+			if (reg->bit_position) {
+				*reg->bit_position = bit % 8;
+			}
+		}
+
+		if (!found) {
+			fprintf(stderr, "Simulation: 0x%04x:%02x is not mapped by slave %u\n",
+				reg->index, reg->subindex, reg->position);
+			return -ENOENT;
+		}
+	}
+
+	return 0;
+}
+
+size_t ecrt_domain_size(const ec_domain_t* domain)
+{
+	return domain->data.size();
+}
+
+uint8_t* ecrt_domain_data(ec_domain_t* domain)
+{
+	return domain->data.data();
+}
+
+int ecrt_domain_process(ec_domain_t* domain)
+{
+	if (!domain->exchanged) {
+		domain->state.working_counter = 0;
+		domain->state.wc_state = EC_WC_ZERO;
+		return 0;
+	}
+
+	domain->exchanged = false;
+
+	uint8_t* data = domain->data.data();
+
+	for (const struct sim_loopback_s& loopback : domain->loopbacks) {
+		if (is_operational(loopback.sc)) {
+			set_bits(data, loopback.bit, loopback.bits,
+				get_bits(loopback.source->sent.data(), loopback.source_bit,
+					loopback.bits));
+		}
+	}
+
+	for (const struct sim_count_s& count : domain->counts) {
+		if (is_operational(count.sc)) {
+			uint64_t mask = count.bits < 64 ? (1ULL << count.bits) - 1 : ~0ULL;
+			uint64_t value = get_bits(data, count.bit, count.bits) + count.step;
+
+			set_bits(data, count.bit, count.bits, value & mask);
+		}
+	}
+
+	// slaves not in OP don't exchange process data
+	unsigned int wc = 0;
+	for (const struct sim_fmmu_s& fmmu : domain->fmmus) {
+		if (is_operational(fmmu.sc)) {
+			wc += fmmu.direction == EC_DIR_OUTPUT ? 2 : 1;
+		}
+	}
+
+	domain->state.working_counter = wc;
+	domain->state.wc_state = !wc ? EC_WC_ZERO
+		: wc == domain->expected_wc ? EC_WC_COMPLETE
+									: EC_WC_INCOMPLETE;
+
+	return 0;
+}
+
+int ecrt_domain_queue(ec_domain_t* domain)
+{
+	// outputs leave with the frame, changes after this are not seen
+	memcpy(domain->sent.data(), domain->data.data(), domain->data.size());
+	domain->queued = true;
+
+	return 0;
+}
+
+int ecrt_domain_state(const ec_domain_t* domain, ec_domain_state_t* state)
+{
+	*state = domain->state;
+
+	return 0;
+}
+
+/****************************************************************************/
+
+void ecrt_sdo_request_index(
+	ec_sdo_request_t* req, uint16_t index, uint8_t subindex)
+{
+	req->index = index;
+	req->subindex = subindex;
+}
+
+void ecrt_sdo_request_timeout(ec_sdo_request_t* req, uint32_t timeout)
+{
+	// transfers always finish after sdo_cycles of the slave
+}
+
+uint8_t* ecrt_sdo_request_data(ec_sdo_request_t* req)
+{
+	return req->data.data();
+}
+
+size_t ecrt_sdo_request_data_size(const ec_sdo_request_t* req)
+{
+	return req->data_size;
+}
+
+ec_request_state_t ecrt_sdo_request_state(ec_sdo_request_t* req)
+{
+	return req->state;
+}
+
+void ecrt_sdo_request_write(ec_sdo_request_t* req)
+{
+	req->write = true;
+	req->data_size = req->data.size();
+	req->state = EC_REQUEST_BUSY;
+	req->cycles_left = req->sc->slave ? req->sc->slave->sdo_cycles : 1;
+}
+
+void ecrt_sdo_request_read(ec_sdo_request_t* req)
+{
+	req->write = false;
+	req->state = EC_REQUEST_BUSY;
+	req->cycles_left = req->sc->slave ? req->sc->slave->sdo_cycles : 1;
+}
+
+}
@@ -0,0 +1,269 @@
+/*****************************************************************************
+ *
+ * Simulated EtherCAT master, source compatible with the subset of IgH
+ * EtherCAT master's ecrt.h used by etherlab-helper. Built instead of
+ * libethercat when ECAT_SIMULATION is set, so the helper runs without a
+ * master module or NIC.
+ *
+ * Slaves on the simulated bus are taken from the slave JSON, see
+ * ecrt_sim_load(). Types and functions keep the names and semantics of
+ * ecrt.h, only members the helper reads are present.
+ *
+ ****************************************************************************/
+
+#ifndef _ECAT_SIM_ECRT_H_
+#define _ECAT_SIM_ECRT_H_
+
+#include <endian.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define EC_MAX_STRING_LENGTH 64
+#define EC_MAX_SYNC_MANAGERS 16
+
+/*****************************************************************************/
+
+typedef struct ec_master ec_master_t;
+typedef struct ec_slave_config ec_slave_config_t;
+typedef struct ec_domain ec_domain_t;
+typedef struct ec_sdo_request ec_sdo_request_t;
+
+typedef enum {
+	EC_DIR_INVALID,
+	EC_DIR_OUTPUT,
+	EC_DIR_INPUT,
+	EC_DIR_COUNT
+} ec_direction_t;
+
+typedef enum {
+	EC_WD_DEFAULT,
+	EC_WD_ENABLE,
+	EC_WD_DISABLE,
+} ec_watchdog_mode_t;
+
+typedef enum {
+	EC_WC_ZERO = 0,
+	EC_WC_INCOMPLETE,
+	EC_WC_COMPLETE
+} ec_wc_state_t;
+
+typedef enum {
+	EC_REQUEST_UNUSED,
+	EC_REQUEST_BUSY,
+	EC_REQUEST_SUCCESS,
+	EC_REQUEST_ERROR,
+} ec_request_state_t;
+
+typedef enum {
+	EC_AL_STATE_INIT = 1,
+	EC_AL_STATE_PREOP = 2,
+	EC_AL_STATE_SAFEOP = 4,
+	EC_AL_STATE_OP = 8,
+} ec_al_state_t;
+
+typedef struct {
+	unsigned int slaves_responding;
+	unsigned int al_states : 4;
+	unsigned int link_up : 1;
+} ec_master_state_t;
+
+typedef struct {
+	unsigned int online : 1;
+	unsigned int operational : 1;
+	unsigned int al_state : 4;
+} ec_slave_config_state_t;
+
+typedef struct {
+	unsigned int working_counter;
+	ec_wc_state_t wc_state;
+	unsigned int redundancy_active;
+} ec_domain_state_t;
+
+typedef struct {
+	uint16_t position;
+	uint32_t vendor_id;
+	uint32_t product_code;
+	uint32_t revision_number;
+	uint32_t serial_number;
+	uint16_t alias;
+	int16_t current_on_ebus;
+	uint8_t al_state;
+	uint8_t error_flag;
+	uint8_t sync_count;
+	uint16_t sdo_count;
+	char name[EC_MAX_STRING_LENGTH];
+} ec_slave_info_t;
+
+typedef struct {
+	uint16_t alias;
+	uint16_t position;
+	uint32_t vendor_id;
+	uint32_t product_code;
+	uint16_t index;
+	uint8_t subindex;
+	unsigned int* offset;
+	unsigned int* bit_position;
+} ec_pdo_entry_reg_t;
+
+/** Counters of a simulated master, not part of ecrt.h */
+typedef struct {
+	uint64_t frames_sent;
+	uint64_t frames_received;
+	uint64_t frames_late; /**< Not back by the next receive. */
+	uint64_t sdo_transfers;
+} ec_sim_stats_t;
+
+/*****************************************************************************
+ * Simulation
+ ****************************************************************************/
+
+/**
+ * Describes the bus of master_index by a slave JSON file. Every slave in it
+ * is present on the bus, an optional "simulation" object per slave sets its
+ * behaviour. Must be called before ecrt_request_master().
+ */
+int ecrt_sim_load(unsigned int master_index, const char* json_path);
+
+int ecrt_sim_stats(unsigned int master_index, ec_sim_stats_t* stats);
+
+/*****************************************************************************
+ * Master
+ ****************************************************************************/
+
+ec_master_t* ecrt_request_master(unsigned int master_index);
+void ecrt_release_master(ec_master_t* master);
+
+ec_domain_t* ecrt_master_create_domain(ec_master_t* master);
+ec_slave_config_t* ecrt_master_slave_config(ec_master_t* master,
+	uint16_t alias, uint16_t position, uint32_t vendor_id,
+	uint32_t product_code);
+int ecrt_master_select_reference_clock(
+	ec_master_t* master, ec_slave_config_t* sc);
+int ecrt_master_get_slave(ec_master_t* master, uint16_t slave_position,
+	ec_slave_info_t* slave_info);
+
+int ecrt_master_sdo_download(ec_master_t* master, uint16_t slave_position,
+	uint16_t index, uint8_t subindex, const uint8_t* data, size_t data_size,
+	uint32_t* abort_code);
+int ecrt_master_sdo_upload(ec_master_t* master, uint16_t slave_position,
+	uint16_t index, uint8_t subindex, uint8_t* target, size_t target_size,
+	size_t* result_size, uint32_t* abort_code);
+
+int ecrt_master_activate(ec_master_t* master);
+int ecrt_master_deactivate(ec_master_t* master);
+
+int ecrt_master_send(ec_master_t* master);
+int ecrt_master_receive(ec_master_t* master);
+int ecrt_master_state(const ec_master_t* master, ec_master_state_t* state);
+
+int ecrt_master_application_time(ec_master_t* master, uint64_t app_time);
+int ecrt_master_sync_reference_clock(ec_master_t* master);
+int ecrt_master_sync_slave_clocks(ec_master_t* master);
+int ecrt_master_reference_clock_time(ec_master_t* master, uint32_t* time);
+
+/*****************************************************************************
+ * Slave configuration
+ ****************************************************************************/
+
+int ecrt_slave_config_sync_manager(ec_slave_config_t* sc, uint8_t sync_index,
+	ec_direction_t direction, ec_watchdog_mode_t watchdog_mode);
+int ecrt_slave_config_pdo_assign_add(
+	ec_slave_config_t* sc, uint8_t sync_index, uint16_t index);
+void ecrt_slave_config_pdo_assign_clear(
+	ec_slave_config_t* sc, uint8_t sync_index);
+int ecrt_slave_config_pdo_mapping_add(ec_slave_config_t* sc,
+	uint16_t pdo_index, uint16_t entry_index, uint8_t entry_subindex,
+	uint8_t entry_bit_length);
+void ecrt_slave_config_pdo_mapping_clear(
+	ec_slave_config_t* sc, uint16_t pdo_index);
+
+int ecrt_slave_config_sdo8(ec_slave_config_t* sc, uint16_t sdo_index,
+	uint8_t sdo_subindex, uint8_t value);
+int ecrt_slave_config_sdo16(ec_slave_config_t* sc, uint16_t sdo_index,
+	uint8_t sdo_subindex, uint16_t value);
+int ecrt_slave_config_sdo32(ec_slave_config_t* sc, uint16_t sdo_index,
+	uint8_t sdo_subindex, uint32_t value);
+
+int ecrt_slave_config_dc(ec_slave_config_t* sc, uint16_t assign_activate,
+	uint32_t sync0_cycle, int32_t sync0_shift, uint32_t sync1_cycle,
+	int32_t sync1_shift);
+
+ec_sdo_request_t* ecrt_slave_config_create_sdo_request(
+	ec_slave_config_t* sc, uint16_t index, uint8_t subindex, size_t size);
+
+int ecrt_slave_config_state(
+	const ec_slave_config_t* sc, ec_slave_config_state_t* state);
+
+/*****************************************************************************
+ * Domain
+ ****************************************************************************/
+
+int ecrt_domain_reg_pdo_entry_list(
+	ec_domain_t* domain, const ec_pdo_entry_reg_t* pdo_entry_regs);
+size_t ecrt_domain_size(const ec_domain_t* domain);
+uint8_t* ecrt_domain_data(ec_domain_t* domain);
+int ecrt_domain_process(ec_domain_t* domain);
+int ecrt_domain_queue(ec_domain_t* domain);
+int ecrt_domain_state(const ec_domain_t* domain, ec_domain_state_t* state);
+
+/*****************************************************************************
+ * SDO request
+ ****************************************************************************/
+
+void ecrt_sdo_request_index(
+	ec_sdo_request_t* req, uint16_t index, uint8_t subindex);
+void ecrt_sdo_request_timeout(ec_sdo_request_t* req, uint32_t timeout);
+uint8_t* ecrt_sdo_request_data(ec_sdo_request_t* req);
+size_t ecrt_sdo_request_data_size(const ec_sdo_request_t* req);
+ec_request_state_t ecrt_sdo_request_state(ec_sdo_request_t* req);
+void ecrt_sdo_request_write(ec_sdo_request_t* req);
+void ecrt_sdo_request_read(ec_sdo_request_t* req);
+
+/*****************************************************************************
+ * Process data access, the same as ecrt.h
+ ****************************************************************************/
+
+#define EC_READ_BIT(DATA, POS) ((*((uint8_t*)(DATA)) >> (POS)) & 0x01)
+
+#define EC_WRITE_BIT(DATA, POS, VAL)                                           \
+	do {                                                                       \
+		if (VAL)                                                               \
+			*((uint8_t*)(DATA)) |= (1 << (POS));                               \
+		else                                                                   \
+			*((uint8_t*)(DATA)) &= ~(1 << (POS));                              \
+	} while (0)
+
+#define EC_READ_U8(DATA) ((uint8_t) * ((uint8_t*)(DATA)))
+#define EC_READ_S8(DATA) ((int8_t) * ((uint8_t*)(DATA)))
+#define EC_READ_U16(DATA) ((uint16_t)le16toh(*((uint16_t*)(DATA))))
+#define EC_READ_S16(DATA) ((int16_t)le16toh(*((uint16_t*)(DATA))))
+#define EC_READ_U32(DATA) ((uint32_t)le32toh(*((uint32_t*)(DATA))))
+#define EC_READ_S32(DATA) ((int32_t)le32toh(*((uint32_t*)(DATA))))
+#define EC_READ_U64(DATA) ((uint64_t)le64toh(*((uint64_t*)(DATA))))
+#define EC_READ_S64(DATA) ((int64_t)le64toh(*((uint64_t*)(DATA))))
+
+#define EC_WRITE_U8(DATA, VAL)                                                 \
+	do {                                                                       \
+		*((uint8_t*)(DATA)) = ((uint8_t)(VAL));                                \
+	} while (0)
+#define EC_WRITE_S8(DATA, VAL) EC_WRITE_U8(DATA, VAL)
+
+#define EC_WRITE_U16(DATA, VAL)                                                \
+	do {                                                                       \
+		*((uint16_t*)(DATA)) = htole16((uint16_t)(VAL));                       \
+	} while (0)
+#define EC_WRITE_S16(DATA, VAL) EC_WRITE_U16(DATA, VAL)
+
+#define EC_WRITE_U32(DATA, VAL)                                                \
+	do {                                                                       \
+		*((uint32_t*)(DATA)) = htole32((uint32_t)(VAL));                       \
+	} while (0)
+#define EC_WRITE_S32(DATA, VAL) EC_WRITE_U32(DATA, VAL)
+
+#define EC_WRITE_U64(DATA, VAL)                                                \
+	do {                                                                       \
+		*((uint64_t*)(DATA)) = htole64((uint64_t)(VAL));                       \
+	} while (0)
+#define EC_WRITE_S64(DATA, VAL) EC_WRITE_U64(DATA, VAL)
+
+#endif
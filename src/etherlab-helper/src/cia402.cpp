@@ -0,0 +1,131 @@
+#include "cia402.h"
+
+namespace CiA402 {
+
+state_al decode_state(const uint16_t& statusword)
+{
+	// bit 0-3 ready to switch on, switched on, operation enabled, fault,
+	// bit 5 quick stop, bit 6 switch on disabled
+	switch (statusword & 0x4f) {
+	case 0x00: {
+		return NOT_READY_TO_SWITCH_ON;
+	} break;
+
+	case 0x40: {
+		return SWITCH_ON_DISABLED;
+	} break;
+
+	case 0x0f: {
+		return FAULT_REACTION_ACTIVE;
+	} break;
+
+	case 0x08: {
+		return FAULT;
+	} break;
+	}
+
+	switch (statusword & 0x6f) {
+	case 0x21: {
+		return READY_TO_SWITCH_ON;
+	} break;
+
+	case 0x23: {
+		return SWITCHED_ON;
+	} break;
+
+	case 0x27: {
+		return OPERATION_ENABLED;
+	} break;
+
+	case 0x07: {
+		return QUICK_STOP_ACTIVE;
+	} break;
+	}
+
+	// undefined combination, handled like a drive not ready yet
+	return NOT_READY_TO_SWITCH_ON;
+}
+
+uint16_t next_controlword(const state_al& state,
+	const EcatHelper::axis_request_al& request, const bool& fault_reset,
+	const uint16_t& previous)
+{
+	switch (state) {
+	case FAULT: {
+		if (fault_reset && !(previous & CW_FAULT_RESET)) {
+			return CW_FAULT_RESET;
+		}
+
+		return CW_DISABLE_VOLTAGE;
+	} break;
+
+	case NOT_READY_TO_SWITCH_ON:
+	case FAULT_REACTION_ACTIVE: {
+		// drive changes state by itself
+		return CW_DISABLE_VOLTAGE;
+	} break;
+
+	default:
+		break;
+	}
+
+	switch (request) {
+	case EcatHelper::ECAT_AXIS_ENABLE: {
+		switch (state) {
+		case SWITCH_ON_DISABLED: {
+			return CW_SHUTDOWN;
+		} break;
+
+		case READY_TO_SWITCH_ON: {
+			return CW_SWITCH_ON;
+		} break;
+
+		case QUICK_STOP_ACTIVE: {
+			// quick stop is left through switch on disabled
+			return CW_DISABLE_VOLTAGE;
+		} break;
+
+		default: {
+			return CW_ENABLE_OPERATION;
+		} break;
+		}
+	} break;
+
+	case EcatHelper::ECAT_AXIS_QUICK_STOP: {
+		if (state == OPERATION_ENABLED || state == QUICK_STOP_ACTIVE) {
+			return CW_QUICK_STOP;
+		}
+
+		return CW_DISABLE_VOLTAGE;
+	} break;
+
+	default: {
+		// disabled drive waits in ready to switch on, power stage off
+		switch (state) {
+		case OPERATION_ENABLED: {
+			return CW_SWITCH_ON;
+		} break;
+
+		case QUICK_STOP_ACTIVE: {
+			return CW_DISABLE_VOLTAGE;
+		} break;
+
+		default: {
+			return CW_SHUTDOWN;
+		} break;
+		}
+	} break;
+	}
+}
+
+const char* state_name(const state_al& state)
+{
+	static const char* names[] = { "not ready to switch on",
+		"switch on disabled", "ready to switch on", "switched on",
+		"operation enabled", "quick stop active", "fault reaction active",
+		"fault" };
+
+	return names[state];
+}
+
+}
@@ -0,0 +1,44 @@
+#ifndef _ECAT_HELPER_CIA402_H_
+#define _ECAT_HELPER_CIA402_H_
+
+#include <etherlab-helper.h>
+
+namespace CiA402 {
+
+/** Drive states decoded from statusword (0x6041) */
+typedef enum state_en {
+	NOT_READY_TO_SWITCH_ON = 0,
+	SWITCH_ON_DISABLED = 1,
+	READY_TO_SWITCH_ON = 2,
+	SWITCHED_ON = 3,
+	OPERATION_ENABLED = 4,
+	QUICK_STOP_ACTIVE = 5,
+	FAULT_REACTION_ACTIVE = 6,
+	FAULT = 7,
+} state_al;
+
+/** Controlword (0x6040) commands */
+enum controlword_en : uint16_t {
+	CW_DISABLE_VOLTAGE = 0x0000,
+	CW_QUICK_STOP = 0x0002,
+	CW_SHUTDOWN = 0x0006,
+	CW_SWITCH_ON = 0x0007,
+	CW_ENABLE_OPERATION = 0x000f,
+	CW_FAULT_RESET = 0x0080,
+};
+
+state_al decode_state(const uint16_t& statusword);
+
+/**
+ * Controlword moving drive one transition towards requested state.
+ * Fault reset is a rising edge, so it alternates with previous controlword.
+ */
+uint16_t next_controlword(const state_al& state,
+	const EcatHelper::axis_request_al& request, const bool& fault_reset,
+	const uint16_t& previous);
+
+const char* state_name(const state_al& state);
+
+}
+
+#endif
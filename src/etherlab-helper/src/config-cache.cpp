@@ -0,0 +1,325 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+
+#include "config-cache.h"
+
+namespace ConfigCache {
+
+namespace fs = std::filesystem;
+
+#define FNV_OFFSET_BASIS 0xcbf29ce484222325ULL
+#define FNV_PRIME 0x100000001b3ULL
+
+// FNV-1a constants over 8 byte words, each word followed by an xorshift
+// so its high bits reach the low ones, i.e. not plain FNV-1a. Tail bytes
+// are plain FNV-1a. Hashing a multi-MB JSON must stay well below the time
+// it takes to parse it
+uint64_t hash(const std::string& contents)
+{
+	uint64_t value = FNV_OFFSET_BASIS;
+	size_t length = contents.size();
+	size_t idx = 0;
+
+	for (; idx + 8 <= length; idx += 8) {
+		uint64_t word;
+		memcpy(&word, contents.data() + idx, sizeof(word));
+		value = (value ^ word) * FNV_PRIME;
+		value ^= value >> 29;
+	}
+
+	for (; idx < length; idx++) {
+		value = (value ^ (uint8_t)contents[idx]) * FNV_PRIME;
+	}
+
+	return value;
+}
+
+std::string path_of(const uint64_t& json_hash)
+{
+	fs::path dir;
+
+	const char* env = getenv(CONFIG_CACHE_ENV);
+	if (env && !strcmp(env, "off")) {
+		return "";
+	}
+
+	if (env && *env) {
+		dir = env;
+	} else if (getenv("XDG_CACHE_HOME") && *getenv("XDG_CACHE_HOME")) {
+		dir = fs::path(getenv("XDG_CACHE_HOME")) / "etherlab-nodejs";
+	} else if (getenv("HOME") && *getenv("HOME")) {
+		dir = fs::path(getenv("HOME")) / ".cache" / "etherlab-nodejs";
+	} else {
+		return "";
+	}
+
+	char name[32];
+	snprintf(name, sizeof(name), "%016" PRIx64 ".ecatcfg", json_hash);
+
+	return dir / name;
+}
+
+// section of count items of type T at offset, must lie within the file
+template <typename T>
+static bool section_valid(const cache_header_al& hdr, const uint32_t& offset,
+	const uint32_t& count, const size_t& file_size)
+{
+	return offset % alignof(T) == 0 && offset >= hdr.header_size
+		&& offset + (uint64_t)count * sizeof(T) <= file_size;
+}
+
+int8_t load(const std::string& path, const uint64_t& json_hash,
+	const uint64_t& json_size,
+	std::vector<EcatHelper::ecat_slave_entry_al>* slave_entries,
+	EcatHelper::ecat_size_slave_al* slave_length,
+	std::vector<EcatHelper::ecat_startup_config_al>* slave_parameters,
+	EcatHelper::ecat_size_param_al* parameters_length,
+	std::vector<EcatHelper::ecat_domain_config_al>* domains,
+	std::vector<EcatHelper::ecat_dc_config_al>* dc_configs)
+{
+	if (path.empty()) {
+		return -1;
+	}
+
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0) {
+		return -1;
+	}
+
+	// cache is trusted like code, so only if nobody else could have
+	// written it
+	struct stat st;
+	if (fstat(fd, &st) == -1 || !S_ISREG(st.st_mode)
+		|| st.st_uid != geteuid() || (st.st_mode & (S_IWGRP | S_IWOTH))
+		|| (size_t)st.st_size < sizeof(cache_header_al)) {
+
+		::close(fd);
+		return -1;
+	}
+
+	size_t map_size = st.st_size;
+	void* ptr = mmap(nullptr, map_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+
+	if (ptr == MAP_FAILED) {
+		return -1;
+	}
+
+	const uint8_t* map = (const uint8_t*)ptr;
+	const cache_header_al& hdr = *(const cache_header_al*)map;
+
+	// anything else is a stale or foreign cache, JSON is parsed instead
+	bool valid = !memcmp(hdr.magic, CONFIG_CACHE_MAGIC, sizeof(hdr.magic))
+		&& hdr.version == CONFIG_CACHE_VERSION
+		&& hdr.header_size == sizeof(cache_header_al)
+		&& hdr.json_hash == json_hash && hdr.json_size == json_size
+		&& hdr.file_size == map_size
+		&& hdr.entry_size == sizeof(EcatHelper::ecat_slave_entry_al)
+		&& hdr.parameter_size == sizeof(EcatHelper::ecat_startup_config_al)
+		&& hdr.dc_size == sizeof(EcatHelper::ecat_dc_config_al)
+		&& hdr.domain_size == sizeof(cache_domain_al)
+		&& section_valid<EcatHelper::ecat_slave_entry_al>(
+			hdr, hdr.entries_offset, hdr.entry_count, map_size)
+		&& section_valid<EcatHelper::ecat_startup_config_al>(
+			hdr, hdr.parameters_offset, hdr.parameter_count, map_size)
+		&& section_valid<EcatHelper::ecat_dc_config_al>(
+			hdr, hdr.dc_offset, hdr.dc_count, map_size)
+		&& section_valid<cache_domain_al>(
+			hdr, hdr.domains_offset, hdr.domain_count, map_size);
+
+	if (valid) {
+		auto entries
+			= (const EcatHelper::ecat_slave_entry_al*)(map + hdr.entries_offset);
+		auto parameters = (const EcatHelper::ecat_startup_config_al*)(map
+			+ hdr.parameters_offset);
+		auto dcs = (const EcatHelper::ecat_dc_config_al*)(map + hdr.dc_offset);
+		auto dmns = (const cache_domain_al*)(map + hdr.domains_offset);
+
+		// parser appends, so does the cache
+		slave_entries->insert(
+			slave_entries->end(), entries, entries + hdr.entry_count);
+		slave_parameters->insert(slave_parameters->end(), parameters,
+			parameters + hdr.parameter_count);
+		dc_configs->assign(dcs, dcs + hdr.dc_count);
+
+		domains->clear();
+		for (uint32_t idx = 0; idx < hdr.domain_count; idx++) {
+			domains->push_back({
+				.name = std::string(
+					dmns[idx].name, strnlen(dmns[idx].name, sizeof(dmns[idx].name))),
+				.divisor = dmns[idx].divisor,
+			});
+		}
+
+		*slave_length = hdr.slave_length;
+		*parameters_length = hdr.parameters_length;
+	}
+
+	munmap(ptr, map_size);
+
+	return valid ? 0 : -1;
+}
+
+// member by member into zeroed memory, so padding never carries stack or
+// heap garbage into the file and equal configurations give equal files
+static void pack(const EcatHelper::ecat_slave_entry_al& in,
+	EcatHelper::ecat_slave_entry_al* out)
+{
+	out->alias = in.alias;
+	out->position = in.position;
+	out->vendor_id = in.vendor_id;
+	out->product_code = in.product_code;
+	out->sync_index = in.sync_index;
+	out->pdo_index = in.pdo_index;
+	out->index = in.index;
+	out->subindex = in.subindex;
+	out->size = in.size;
+	out->add_to_domain = in.add_to_domain;
+	out->offset = in.offset;
+	out->bit_position = in.bit_position;
+	out->direction = in.direction;
+	out->swap_endian = in.swap_endian;
+	out->is_signed = in.is_signed;
+	out->watchog_enabled = in.watchog_enabled;
+	out->domain = in.domain;
+}
+
+static void pack(const EcatHelper::ecat_startup_config_al& in,
+	EcatHelper::ecat_startup_config_al* out)
+{
+	out->size = in.size;
+	out->slavePosition = in.slavePosition;
+	out->index = in.index;
+	out->subindex = in.subindex;
+
+	// startup parameters are at most 32 bit, rest of value is never set
+	out->value.u32 = in.value.u32;
+}
+
+static void pack(const EcatHelper::ecat_dc_config_al& in,
+	EcatHelper::ecat_dc_config_al* out)
+{
+	out->position = in.position;
+	out->assign_activate = in.assign_activate;
+	out->sync0_cycle = in.sync0_cycle;
+	out->sync0_shift = in.sync0_shift;
+	out->sync1_cycle = in.sync1_cycle;
+	out->sync1_shift = in.sync1_shift;
+	out->reference_clock = in.reference_clock;
+}
+
+int8_t store(const std::string& path, const uint64_t& json_hash,
+	const uint64_t& json_size,
+	const std::vector<EcatHelper::ecat_slave_entry_al>& slave_entries,
+	const EcatHelper::ecat_size_slave_al& slave_length,
+	const std::vector<EcatHelper::ecat_startup_config_al>& slave_parameters,
+	const EcatHelper::ecat_size_param_al& parameters_length,
+	const std::vector<EcatHelper::ecat_domain_config_al>& domains,
+	const std::vector<EcatHelper::ecat_dc_config_al>& dc_configs)
+{
+	if (path.empty()) {
+		return -1;
+	}
+
+	std::vector<cache_domain_al> dmns;
+	for (const EcatHelper::ecat_domain_config_al& domain : domains) {
+		cache_domain_al dmn = { .divisor = domain.divisor };
+
+		// a name that doesn't fit can't be cached
+		if (domain.name.size() >= sizeof(dmn.name)) {
+			return -1;
+		}
+
+		memcpy(dmn.name, domain.name.c_str(), domain.name.size() + 1);
+		dmns.push_back(dmn);
+	}
+
+	cache_header_al hdr = {};
+	memcpy(hdr.magic, CONFIG_CACHE_MAGIC, sizeof(hdr.magic));
+	hdr.version = CONFIG_CACHE_VERSION;
+	hdr.header_size = sizeof(cache_header_al);
+	hdr.json_hash = json_hash;
+	hdr.json_size = json_size;
+
+	hdr.entry_size = sizeof(EcatHelper::ecat_slave_entry_al);
+	hdr.parameter_size = sizeof(EcatHelper::ecat_startup_config_al);
+	hdr.dc_size = sizeof(EcatHelper::ecat_dc_config_al);
+	hdr.domain_size = sizeof(cache_domain_al);
+
+	hdr.entry_count = slave_entries.size();
+	hdr.parameter_count = slave_parameters.size();
+	hdr.dc_count = dc_configs.size();
+	hdr.domain_count = dmns.size();
+
+	hdr.slave_length = slave_length;
+	hdr.parameters_length = parameters_length;
+
+	// sections one after another, each aligned to 8 bytes
+	std::vector<uint8_t> image(sizeof(hdr));
+
+	auto reserve = [&image](const size_t& size) {
+		image.resize((image.size() + 7) & ~(size_t)7, 0);
+		uint32_t offset = image.size();
+
+		image.resize(offset + size, 0);
+
+		return offset;
+	};
+
+	auto append = [&image, &reserve](const auto& items) {
+		typedef typename std::decay_t<decltype(items)>::value_type item_t;
+		uint32_t offset = reserve(items.size() * sizeof(item_t));
+
+		item_t* out = (item_t*)(image.data() + offset);
+		for (const item_t& item : items) {
+			pack(item, out++);
+		}
+
+		return offset;
+	};
+
+	hdr.entries_offset = append(slave_entries);
+	hdr.parameters_offset = append(slave_parameters);
+	hdr.dc_offset = append(dc_configs);
+
+	// names are NUL padded already, domains have no padding
+	hdr.domains_offset = reserve(dmns.size() * sizeof(cache_domain_al));
+	if (!dmns.empty()) {
+		memcpy(image.data() + hdr.domains_offset, dmns.data(),
+			dmns.size() * sizeof(cache_domain_al));
+	}
+
+	hdr.file_size = image.size();
+	memcpy(image.data(), &hdr, sizeof(hdr));
+
+	std::error_code ec;
+	fs::create_directories(fs::path(path).parent_path(), ec);
+
+	// readers only ever see a complete file
+	std::string tmp_path = path + "." + std::to_string(getpid()) + ".tmp";
+
+	int fd = ::open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0) {
+		return -1;
+	}
+
+	bool written = write(fd, image.data(), image.size()) == (ssize_t)image.size();
+	::close(fd);
+
+	if (!written || rename(tmp_path.c_str(), path.c_str())) {
+		unlink(tmp_path.c_str());
+		return -1;
+	}
+
+	return 0;
+}
+
+}
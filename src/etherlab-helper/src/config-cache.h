@@ -0,0 +1,96 @@
+#ifndef _ECAT_HELPER_CONFIG_CACHE_H_
+#define _ECAT_HELPER_CONFIG_CACHE_H_
+
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <etherlab-helper.h>
+
+namespace ConfigCache {
+
+#define CONFIG_CACHE_MAGIC "ECATCFG"
+
+// bump whenever parser output for the same JSON changes
+#define CONFIG_CACHE_VERSION 1
+
+// directory of cache files, "off" disables the cache
+#define CONFIG_CACHE_ENV "ECAT_CONFIG_CACHE"
+
+/**
+ * File layout, native endianness and struct layout of the build:
+ *   cache_header_al, then entry_count * ecat_slave_entry_al,
+ *   parameter_count * ecat_startup_config_al, dc_count * ecat_dc_config_al
+ *   and domain_count * cache_domain_al, each at its offset.
+ *
+ * A cache is only used if it was written for the very same JSON contents
+ * by a build with the same version and struct sizes.
+ */
+typedef struct cache_header_s {
+	char magic[8];
+	uint32_t version;
+	uint32_t header_size;
+
+	uint64_t json_hash; /**< hash() of JSON contents. */
+	uint64_t json_size;
+	uint64_t file_size;
+
+	uint16_t entry_size; /**< sizeof() of each struct, as built. */
+	uint16_t parameter_size;
+	uint16_t dc_size;
+	uint16_t domain_size;
+
+	uint32_t entry_count;
+	uint32_t parameter_count;
+	uint32_t dc_count;
+	uint32_t domain_count;
+
+	uint32_t entries_offset;
+	uint32_t parameters_offset;
+	uint32_t dc_offset;
+	uint32_t domains_offset;
+
+	uint32_t slave_length; /**< Values returned by parser. */
+	uint32_t parameters_length;
+	uint8_t reserved[8];
+} cache_header_al;
+
+typedef struct cache_domain_s {
+	char name[62]; /**< NUL terminated. */
+	uint16_t divisor;
+} cache_domain_al;
+
+static_assert(sizeof(cache_header_al) == 96, "cache header layout");
+static_assert(std::is_trivially_copyable_v<EcatHelper::ecat_slave_entry_al>
+		&& std::is_trivially_copyable_v<EcatHelper::ecat_startup_config_al>
+		&& std::is_trivially_copyable_v<EcatHelper::ecat_dc_config_al>,
+	"cached structs are copied as they are");
+
+uint64_t hash(const std::string& contents);
+
+/** Cache file of given JSON hash, empty if cache is disabled */
+std::string path_of(const uint64_t& json_hash);
+
+/** Fills the same outputs as ConfigParser::parse(), 0 on cache hit */
+int8_t load(const std::string& path, const uint64_t& json_hash,
+	const uint64_t& json_size,
+	std::vector<EcatHelper::ecat_slave_entry_al>* slave_entries,
+	EcatHelper::ecat_size_slave_al* slave_length,
+	std::vector<EcatHelper::ecat_startup_config_al>* slave_parameters,
+	EcatHelper::ecat_size_param_al* parameters_length,
+	std::vector<EcatHelper::ecat_domain_config_al>* domains,
+	std::vector<EcatHelper::ecat_dc_config_al>* dc_configs);
+
+/** Writes the cache atomically, a failure only means no cache next time */
+int8_t store(const std::string& path, const uint64_t& json_hash,
+	const uint64_t& json_size,
+	const std::vector<EcatHelper::ecat_slave_entry_al>& slave_entries,
+	const EcatHelper::ecat_size_slave_al& slave_length,
+	const std::vector<EcatHelper::ecat_startup_config_al>& slave_parameters,
+	const EcatHelper::ecat_size_param_al& parameters_length,
+	const std::vector<EcatHelper::ecat_domain_config_al>& domains,
+	const std::vector<EcatHelper::ecat_dc_config_al>& dc_configs);
+
+}
+
+#endif
@@ -1,16 +1,29 @@
 #include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
 #include <fstream>
+#include <stdexcept>
 #include <string>
+#include <string_view>
 
-#include <rapidjson/document.h>
+#include <rapidjson/allocators.h>
+#include <rapidjson/error/en.h>
+#include <rapidjson/reader.h>
 
 #include "config-parser.h"
 
 namespace ConfigParser {
 
-std::string normalize_hex_string(const std::string& str);
-uint32_t to_uint32(const rapidjson::Value&);
-uint8_t member_is_valid_array(const rapidjson::Value&, const char*);
+// least size of further arena blocks, e.g. for copies of domain names
+#define ARENA_BLOCK_MIN (64 * 1024)
+
+// buffer of rapidjson's stack, holds nesting and the string being read
+#define READER_STACK_SIZE (16 * 1024)
+
+// entry takes domain of its sync manager
+#define DOMAIN_INHERIT UINT16_MAX
 
 static const uint8_t SyncMEthercatDirection[] = {
 	EC_DIR_OUTPUT, // SM0 EC_DIR_OUTPUT
@@ -19,313 +32,1237 @@ static const uint8_t SyncMEthercatDirection[] = {
 	EC_DIR_INPUT // SM3 EC_DIR_INPUT
 };
 
-std::string normalize_hex_string(const std::string& str)
-{
-	std::string output;
+/**
+ * Bump allocator over a few large blocks, released all at once. Blocks are
+ * chained through their first bytes, so the arena itself never allocates
+ * anything but its blocks.
+ */
+class Arena {
+public:
+	explicit Arena(const size_t& capacity)
+	{
+		add_block(capacity);
+	}
+
+	~Arena()
+	{
+		while (block) {
+			uint8_t* prev = *(uint8_t**)block;
+			free(block);
+			block = prev;
+		}
+	}
+
+	template <typename T> T* alloc(const size_t& count)
+	{
+		size_t size = count * sizeof(T);
+		size_t offset = (used + alignof(T) - 1) & ~(alignof(T) - 1);
+
+		if (offset + size > capacity) {
+			add_block(std::max<size_t>(size + alignof(T), ARENA_BLOCK_MIN));
+			offset = (used + alignof(T) - 1) & ~(alignof(T) - 1);
+		}
 
-	// avoids buffer reallocations in the loop
-	output.reserve(str.size());
+		used = offset + size;
 
-	size_t length = str.size();
-	for (size_t i = 0; i < length; i++) {
-		if (isxdigit(str[i])) {
-			output += str[i];
+		return (T*)(block + offset);
+	}
+
+private:
+	void add_block(const size_t& size)
+	{
+		uint8_t* next = (uint8_t*)malloc(sizeof(uint8_t*) + size);
+		if (!next) {
+			throw std::bad_alloc();
 		}
+
+		*(uint8_t**)next = block;
+		block = next;
+		capacity = sizeof(uint8_t*) + size;
+		used = sizeof(uint8_t*);
+	}
+
+	uint8_t* block = nullptr;
+	size_t capacity = 0;
+	size_t used = 0;
+};
+
+/** Array of arena memory, grows into a new arena allocation if needed */
+template <typename T> struct arena_array_s {
+	T* data = nullptr;
+	size_t length = 0;
+	size_t capacity = 0;
+
+	void init(Arena* arena, const size_t& count)
+	{
+		capacity = std::max<size_t>(count, 1);
+		data = arena->alloc<T>(capacity);
 	}
 
-	return output;
+	T& push(Arena* arena)
+	{
+		if (length == capacity) {
+			T* grown = arena->alloc<T>(capacity * 2);
+			memcpy((void*)grown, data, length * sizeof(T));
+
+			data = grown;
+			capacity *= 2;
+		}
+
+		return data[length++];
+	}
+};
+
+/**
+ * Number of '{' in the raw text. Every entry, placeholder, parameter, DC
+ * config and domain comes from an object of its own, so this bounds each of
+ * them, comments and strings only make it looser.
+ */
+static size_t count_objects(const char* json_string)
+{
+	size_t count = 0;
+	const char* ptr = json_string;
+
+	while ((ptr = strchr(ptr, '{'))) {
+		ptr++;
+		count++;
+	}
+
+	return count;
 }
 
-uint32_t to_uint32(const rapidjson::Value& val)
+/****************************************************************************/
+
+typedef enum context_en {
+	CTX_ROOT,
+	CTX_TOP, /**< Root object with 'slaves' and 'domains'. */
+	CTX_DOMAINS,
+	CTX_DOMAIN,
+	CTX_SLAVES,
+	CTX_SLAVE,
+	CTX_DC,
+	CTX_DC_SYNC0,
+	CTX_DC_SYNC1,
+	CTX_SYNCS,
+	CTX_SYNC,
+	CTX_PDOS,
+	CTX_PDO,
+	CTX_ENTRIES,
+	CTX_ENTRY,
+	CTX_PARAMETERS,
+	CTX_PARAMETER,
+	CTX_LENGTH,
+} context_al;
+
+typedef enum key_en {
+	KEY_OTHER,
+	KEY_ADD_TO_DOMAIN,
+	KEY_ALIAS,
+	KEY_ASSIGN_ACTIVATE,
+	KEY_CYCLE,
+	KEY_DC,
+	KEY_DIRECTION,
+	KEY_DIVISOR,
+	KEY_DOMAIN,
+	KEY_DOMAINS,
+	KEY_ENTRIES,
+	KEY_INDEX,
+	KEY_NAME,
+	KEY_PARAMETERS,
+	KEY_PDOS,
+	KEY_POSITION,
+	KEY_PRODUCT_CODE,
+	KEY_REFERENCE_CLOCK,
+	KEY_SHIFT,
+	KEY_SIGNED,
+	KEY_SIZE,
+	KEY_SLAVES,
+	KEY_SUBINDEX,
+	KEY_SWAP_ENDIAN,
+	KEY_SYNC0,
+	KEY_SYNC1,
+	KEY_SYNCS,
+	KEY_VALUE,
+	KEY_VENDOR_ID,
+	KEY_WATCHDOG_ENABLED,
+} key_al;
+
+/** Key of a member name, comparisons are by length first */
+static key_al key_of(const std::string_view& name)
 {
-	if (val.IsString()) {
-		return std::stoi(normalize_hex_string(val.GetString()), 0, 16);
-	} else {
-		return val.GetUint();
+	switch (name.size()) {
+	case 2: {
+		if (name == "dc") {
+			return KEY_DC;
+		}
+	} break;
+	case 4: {
+		if (name == "size") {
+			return KEY_SIZE;
+		}
+
+		if (name == "pdos") {
+			return KEY_PDOS;
+		}
+
+		if (name == "name") {
+			return KEY_NAME;
+		}
+	} break;
+	case 5: {
+		if (name == "index") {
+			return KEY_INDEX;
+		}
+
+		if (name == "alias") {
+			return KEY_ALIAS;
+		}
+
+		if (name == "syncs") {
+			return KEY_SYNCS;
+		}
+
+		if (name == "value") {
+			return KEY_VALUE;
+		}
+
+		if (name == "sync0") {
+			return KEY_SYNC0;
+		}
+
+		if (name == "sync1") {
+			return KEY_SYNC1;
+		}
+
+		if (name == "cycle") {
+			return KEY_CYCLE;
+		}
+
+		if (name == "shift") {
+			return KEY_SHIFT;
+		}
+	} break;
+	case 6: {
+		if (name == "signed") {
+			return KEY_SIGNED;
+		}
+
+		if (name == "domain") {
+			return KEY_DOMAIN;
+		}
+
+		if (name == "slaves") {
+			return KEY_SLAVES;
+		}
+	} break;
+	case 7: {
+		if (name == "entries") {
+			return KEY_ENTRIES;
+		}
+
+		if (name == "domains") {
+			return KEY_DOMAINS;
+		}
+
+		if (name == "divisor") {
+			return KEY_DIVISOR;
+		}
+	} break;
+	case 8: {
+		if (name == "subindex") {
+			return KEY_SUBINDEX;
+		}
+
+		if (name == "position") {
+			return KEY_POSITION;
+		}
+	} break;
+	case 9: {
+		if (name == "vendor_id") {
+			return KEY_VENDOR_ID;
+		}
+
+		if (name == "direction") {
+			return KEY_DIRECTION;
+		}
+	} break;
+	case 10: {
+		if (name == "parameters") {
+			return KEY_PARAMETERS;
+		}
+	} break;
+	case 11: {
+		if (name == "swap_endian") {
+			return KEY_SWAP_ENDIAN;
+		}
+	} break;
+	case 12: {
+		if (name == "product_code") {
+			return KEY_PRODUCT_CODE;
+		}
+	} break;
+	case 13: {
+		if (name == "add_to_domain") {
+			return KEY_ADD_TO_DOMAIN;
+		}
+	} break;
+	case 15: {
+		if (name == "assign_activate") {
+			return KEY_ASSIGN_ACTIVATE;
+		}
+
+		if (name == "reference_clock") {
+			return KEY_REFERENCE_CLOCK;
+		}
+	} break;
+	case 16: {
+		if (name == "watchdog_enabled") {
+			return KEY_WATCHDOG_ENABLED;
+		}
+	} break;
 	}
+
+	return KEY_OTHER;
 }
 
-uint8_t member_is_valid_array(const rapidjson::Value& doc, const char* name)
+typedef enum scalar_type_en {
+	SCALAR_NULL,
+	SCALAR_BOOL,
+	SCALAR_NUMBER,
+	SCALAR_STRING,
+} scalar_type_al;
+
+typedef struct scalar_s {
+	scalar_type_al type = SCALAR_NULL;
+	bool boolean = false;
+	int64_t number = 0;
+	const char* str = nullptr;
+	size_t length = 0;
+} scalar_al;
+
+/** Hex digits of str, anything else in between is skipped, e.g. "0x1a00" */
+static uint32_t parse_hex(const char* str, const size_t& length)
 {
-	if (!doc.HasMember(name)) {
-		return 0;
+	uint32_t value = 0;
+	bool digits = false;
+
+	for (size_t idx = 0; idx < length; idx++) {
+		char chr = str[idx];
+		uint8_t nibble;
+
+		if (chr >= '0' && chr <= '9') {
+			nibble = chr - '0';
+		} else if (chr >= 'a' && chr <= 'f') {
+			nibble = chr - 'a' + 10;
+		} else if (chr >= 'A' && chr <= 'F') {
+			nibble = chr - 'A' + 10;
+		} else {
+			continue;
+		}
+
+		value = (value << 4) | nibble;
+		digits = true;
 	}
 
-	if (!doc[name].IsArray()) {
-		return 0;
+	if (!digits) {
+		throw std::invalid_argument(
+			"\"" + std::string(str, length) + "\" is not a hex number");
 	}
 
-	return doc[name].Size() > 0;
+	return value;
 }
 
-int8_t get_file_contents(const std::string& filename, std::string* contents)
+static uint32_t to_uint32(const scalar_al& val)
 {
-	std::FILE* fp = std::fopen(&filename[0], "rb");
+	if (val.type == SCALAR_STRING) {
+		return parse_hex(val.str, val.length);
+	}
 
-	if (!fp) {
-		perror("Error: Can't open file");
-		return -1;
+	assert(val.type == SCALAR_NUMBER);
+	return val.number;
+}
+
+static int32_t to_int32(const scalar_al& val)
+{
+	return to_uint32(val);
+}
+
+static bool to_bool(const scalar_al& val)
+{
+	assert(val.type == SCALAR_BOOL);
+	return val.boolean;
+}
+
+/****************************************************************************/
+
+// what is known of an entry only by the end of the object holding it
+typedef struct entry_meta_s {
+	uint16_t domain_ref = 0; /**< Name id + 1, 0 is 'default'. */
+	bool real = false; /**< Not a placeholder of an empty PDO or slave. */
+} entry_meta_al;
+
+typedef struct slave_record_s {
+	EcatHelper::ecat_pos_al position;
+	uint32_t order;
+
+	size_t entry_begin;
+	size_t entry_count;
+	size_t parameter_begin;
+	size_t parameter_count;
+	int32_t dc; /**< Index in dcs, -1 if none. */
+} slave_record_al;
+
+typedef struct name_s {
+	const char* str; /**< Not NUL terminated, points into the arena. */
+	size_t length;
+} name_al;
+
+typedef struct domain_s {
+	name_al name = {};
+	uint16_t divisor = 1; /**< Also when "divisor" is missing. */
+} domain_al;
+
+/**
+ * Single pass over the JSON with rapidjson's Reader. Members may come in any
+ * order, so values of an object are applied to the items it produced once
+ * the object ends. Everything is kept in the arena until output() copies it
+ * to the vectors, in order of slave position.
+ */
+class Handler
+	: public rapidjson::BaseReaderHandler<rapidjson::UTF8<>, Handler> {
+public:
+	Handler(Arena* arena, const size_t& objects)
+		: arena(arena)
+	{
+		entries.init(arena, objects);
+		metas.init(arena, objects);
+		parameters.init(arena, objects);
+		dcs.init(arena, objects);
+		slaves.init(arena, objects);
+		domains.init(arena, objects + 1);
+		domain_names.init(arena, objects);
+
+		// entries without 'domain' are exchanged every cycle
+		domains.push(arena) = { .name = { "default", 7 }, .divisor = 1 };
 	}
 
-	std::fseek(fp, 0, SEEK_END);
-	contents->resize(std::ftell(fp));
-	std::rewind(fp);
-	size_t read = std::fread(&(*contents)[0], 1, contents->size(), fp);
-	int8_t retval = 0;
+	/** Bytes of arena taken by the constructor, alignment of each included */
+	static size_t arena_size(const size_t& objects)
+	{
+		return (objects + 1)
+			* (sizeof(EcatHelper::ecat_slave_entry_al) + sizeof(entry_meta_al)
+				+ sizeof(EcatHelper::ecat_startup_config_al)
+				+ sizeof(EcatHelper::ecat_dc_config_al) + sizeof(slave_record_al)
+				+ sizeof(domain_al) + sizeof(name_al))
+			+ 7 * alignof(std::max_align_t);
+	}
 
-	if (read != contents->size()) {
-		if (feof(fp)) {
-			fprintf(stderr, "Error reading '%s': unexpected EoF\n",
-				filename.c_str());
-			retval = -3;
-		} else if (ferror(fp)) {
-			fprintf(stderr, "Error reading '%s'", filename.c_str());
-			retval = -2;
+	bool Null()
+	{
+		return scalar({});
+	}
+
+	bool Bool(bool value)
+	{
+		return scalar({ .type = SCALAR_BOOL, .boolean = value });
+	}
+
+	bool Int(int value)
+	{
+		return scalar({ .type = SCALAR_NUMBER, .number = value });
+	}
+
+	bool Uint(unsigned value)
+	{
+		return scalar({ .type = SCALAR_NUMBER, .number = value });
+	}
+
+	bool Int64(int64_t value)
+	{
+		return scalar({ .type = SCALAR_NUMBER, .number = value });
+	}
+
+	bool Uint64(uint64_t value)
+	{
+		return scalar({ .type = SCALAR_NUMBER, .number = (int64_t)value });
+	}
+
+	bool Double(double value)
+	{
+		return scalar({ .type = SCALAR_NUMBER, .number = (int64_t)value });
+	}
+
+	bool String(const char* str, rapidjson::SizeType length, bool)
+	{
+		return scalar({ .type = SCALAR_STRING, .str = str, .length = length });
+	}
+
+	bool Key(const char* str, rapidjson::SizeType length, bool)
+	{
+		key = key_of(std::string_view(str, length));
+
+		return true;
+	}
+
+	bool StartObject()
+	{
+		if (skip_depth) {
+			skip_depth++;
+			return true;
 		}
+
+		switch (context()) {
+		case CTX_ROOT: {
+			push(CTX_TOP);
+		} break;
+		case CTX_DOMAINS: {
+			domain = {};
+			has_name = false;
+			push(CTX_DOMAIN);
+		} break;
+		case CTX_SLAVES: {
+			begin_slave();
+			push(CTX_SLAVE);
+		} break;
+		case CTX_SLAVE: {
+			if (key != KEY_DC) {
+				return skip();
+			}
+
+			dc = {};
+			has_dc = true;
+			has_assign_activate = false;
+			push(CTX_DC);
+		} break;
+		case CTX_DC: {
+			if (key != KEY_SYNC0 && key != KEY_SYNC1) {
+				return skip();
+			}
+
+			push(key == KEY_SYNC0 ? CTX_DC_SYNC0 : CTX_DC_SYNC1);
+		} break;
+		case CTX_SYNCS: {
+			begin_sync();
+			push(CTX_SYNC);
+		} break;
+		case CTX_PDOS: {
+			begin_pdo();
+			push(CTX_PDO);
+		} break;
+		case CTX_ENTRIES: {
+			entry = {};
+			entry_domain = DOMAIN_INHERIT;
+			entry_members = 0;
+			pdo_has_entries = true;
+			push(CTX_ENTRY);
+		} break;
+		case CTX_PARAMETERS: {
+			parameter = {};
+			parameter_members = 0;
+			push(CTX_PARAMETER);
+		} break;
+		default: {
+			return skip();
+		}
+		}
+
+		return true;
 	}
 
-	std::fclose(fp);
+	bool EndObject(rapidjson::SizeType)
+	{
+		if (skip_depth) {
+			skip_depth--;
+			return true;
+		}
 
-	return retval;
-}
+		switch (pop()) {
+		case CTX_TOP: {
+			assert(has_slaves);
+		} break;
+		case CTX_DOMAIN: {
+			end_domain();
+		} break;
+		case CTX_SLAVE: {
+			end_slave();
+		} break;
+		case CTX_DC: {
+			assert(has_assign_activate);
+		} break;
+		case CTX_SYNC: {
+			end_sync();
+		} break;
+		case CTX_PDO: {
+			end_pdo();
+		} break;
+		case CTX_ENTRY: {
+			end_entry();
+		} break;
+		case CTX_PARAMETER: {
+			assert(parameter_members == 0x0f);
+
+			parameters.push(arena) = parameter;
+		} break;
+		default: {
+		} break;
+		}
 
-int8_t parse(const char* json_string,
-	std::vector<EcatHelper::ecat_slave_entry_al>* slave_entries,
-	EcatHelper::ecat_size_slave_al* slave_length,
-	std::vector<EcatHelper::ecat_startup_config_al>* slave_parameters,
-	EcatHelper::ecat_size_param_al* parameters_length)
-{
+		return true;
+	}
 
-	rapidjson::Document document;
+	bool StartArray()
+	{
+		if (skip_depth) {
+			skip_depth++;
+			return true;
+		}
 
-	// relaxed JSON config, i.e. comment and trailing comma are allowed
-	document.Parse<rapidjson::kParseTrailingCommasFlag
-		| rapidjson::kParseCommentsFlag | rapidjson::kParseEscapedApostropheFlag
-		| rapidjson::kParseNanAndInfFlag>(json_string);
+		context_al next = CTX_LENGTH;
+
+		switch (context()) {
+		case CTX_ROOT: {
+			next = CTX_SLAVES;
+			has_slaves = true;
+		} break;
+		case CTX_TOP: {
+			if (key == KEY_SLAVES) {
+				next = CTX_SLAVES;
+				has_slaves = true;
+			} else if (key == KEY_DOMAINS) {
+				next = CTX_DOMAINS;
+			}
+		} break;
+		case CTX_SLAVE: {
+			if (key == KEY_SYNCS) {
+				next = CTX_SYNCS;
+			} else if (key == KEY_PARAMETERS) {
+				next = CTX_PARAMETERS;
+			}
+		} break;
+		case CTX_SYNC: {
+			if (key == KEY_PDOS) {
+				next = CTX_PDOS;
+				sync_has_pdos = true;
+			}
+		} break;
+		case CTX_PDO: {
+			if (key == KEY_ENTRIES) {
+				next = CTX_ENTRIES;
+			}
+		} break;
+		default: {
+		} break;
+		}
 
-	assert(document.IsArray());
+		if (next == CTX_LENGTH) {
+			return skip();
+		}
 
-	// re-initialize length with 0
-	*slave_length = 0;
-	*parameters_length = 0;
+		push(next);
 
-	// Slave entries must be ordered by position ascendingly
-#if RAPIDJSON_HAS_CXX11_RVALUE_REFS
-	struct SortSlavesAsc {
-		bool operator()(
-			const rapidjson::Value& lhs, const rapidjson::Value& rhs) const
-		{
-			return lhs["position"].GetUint() < rhs["position"].GetUint();
+		return true;
+	}
+
+	bool EndArray(rapidjson::SizeType)
+	{
+		if (skip_depth) {
+			skip_depth--;
+			return true;
 		}
-	};
 
-	std::sort(document.Begin(), document.End(), SortSlavesAsc());
-#endif
+		pop();
+
+		return true;
+	}
 
-	size_t total_slaves = document.Size();
-	EcatHelper::ecat_size_slave_al i_slaves = 0;
+	/** Domain of every entry by now is known, turn references into indexes */
+	void resolve_domains()
+	{
+		uint8_t indexes[UINT8_MAX + 1] = {};
 
-	for (i_slaves = 0; i_slaves < total_slaves; i_slaves++) {
-		rapidjson::Value::Object m_slaves = document[i_slaves].GetObject();
+		assert(domain_names.length <= UINT8_MAX);
 
-		assert(m_slaves.HasMember("alias"));
-		assert(m_slaves.HasMember("position"));
-		assert(m_slaves.HasMember("vendor_id"));
-		assert(m_slaves.HasMember("product_code"));
+		for (size_t id = 0; id < domain_names.length; id++) {
+			const name_al& name = domain_names.data[id];
 
-		uint16_t alias = to_uint32(m_slaves["alias"]);
-		EcatHelper::ecat_pos_al position = to_uint32(m_slaves["position"]);
-		uint32_t vendor_id = to_uint32(m_slaves["vendor_id"]);
-		uint32_t product_code = to_uint32(m_slaves["product_code"]);
+			size_t idx = 0;
+			while (idx < domains.length && !equals(domains.data[idx].name, name)) {
+				idx++;
+			}
+
+			if (idx == domains.length) {
+				throw std::invalid_argument("\"" + std::string(name.str, name.length)
+					+ "\" is not defined in 'domains'");
+			}
+
+			indexes[id] = idx;
+		}
 
-		// add new slave entry if slave doesnt have syncs
-		if (!member_is_valid_array(m_slaves, "syncs")) {
-			(*slave_length)++;
+		for (size_t idx = 0; idx < entries.length; idx++) {
+			uint16_t ref = metas.data[idx].domain_ref;
+			entries.data[idx].domain = ref ? indexes[ref - 1] : 0;
+		}
+	}
 
-			(*slave_entries)
-				.push_back({
-					.alias = alias,
-					.position = position,
-					.vendor_id = vendor_id,
-					.product_code = product_code,
+	/** Appends slave entries and parameters, replaces DC configs and domains */
+	void output(std::vector<EcatHelper::ecat_slave_entry_al>* slave_entries,
+		std::vector<EcatHelper::ecat_startup_config_al>* slave_parameters,
+		std::vector<EcatHelper::ecat_domain_config_al>* domain_configs,
+		std::vector<EcatHelper::ecat_dc_config_al>* dc_configs)
+	{
+		// Slave entries must be ordered by position ascendingly
+		if (!sorted) {
+			std::sort(slaves.data, slaves.data + slaves.length,
+				[](const slave_record_al& lhs, const slave_record_al& rhs) {
+					return lhs.position < rhs.position
+						|| (lhs.position == rhs.position && lhs.order < rhs.order);
 				});
+		}
 
-			continue;
+		slave_entries->reserve(slave_entries->size() + entries.length);
+		slave_parameters->reserve(slave_parameters->size() + parameters.length);
+		dc_configs->reserve(dcs.length);
+		domain_configs->reserve(domains.length);
+
+		for (size_t idx = 0; idx < slaves.length; idx++) {
+			const slave_record_al& record = slaves.data[idx];
+
+			slave_entries->insert(slave_entries->end(),
+				entries.data + record.entry_begin,
+				entries.data + record.entry_begin + record.entry_count);
+			slave_parameters->insert(slave_parameters->end(),
+				parameters.data + record.parameter_begin,
+				parameters.data + record.parameter_begin + record.parameter_count);
+
+			if (record.dc >= 0) {
+				dc_configs->push_back(dcs.data[record.dc]);
+			}
 		}
 
-		assert(m_slaves["syncs"].IsArray());
+		for (size_t idx = 0; idx < domains.length; idx++) {
+			const domain_al& domain = domains.data[idx];
 
-		for (uint8_t i_syncs = 0; i_syncs < m_slaves["syncs"].Size();
-			 i_syncs++) {
+			domain_configs->push_back({
+				.name = std::string(domain.name.str, domain.name.length),
+				.divisor = domain.divisor,
+			});
+		}
+	}
 
-			rapidjson::Value::Object m_syncs
-				= m_slaves["syncs"][i_syncs].GetObject();
+	size_t entry_count() const
+	{
+		return entries.length;
+	}
+
+	size_t parameter_count() const
+	{
+		return parameters.length;
+	}
+
+private:
+	context_al context() const
+	{
+		return depth ? stack[depth - 1] : CTX_ROOT;
+	}
 
-			assert(m_syncs.HasMember("index"));
-			assert(m_syncs.HasMember("pdos"));
-			assert(m_syncs["pdos"].IsArray());
+	void push(const context_al& ctx)
+	{
+		assert(depth < sizeof(stack) / sizeof(stack[0]));
+		stack[depth++] = ctx;
+	}
 
-			uint8_t sync_index = to_uint32(m_syncs["index"]);
-			uint8_t watchdog_enabled = 0;
-			uint8_t direction = SyncMEthercatDirection[sync_index];
+	context_al pop()
+	{
+		return stack[--depth];
+	}
 
-			if (m_syncs.HasMember("watchdog_enabled")) {
-				assert(m_syncs["watchdog_enabled"].IsBool());
-				watchdog_enabled = static_cast<uint8_t>(
-					m_syncs["watchdog_enabled"].GetBool());
+	// value of a member that isn't part of the configuration
+	bool skip()
+	{
+		skip_depth = 1;
+		return true;
+	}
+
+	static bool equals(const name_al& lhs, const name_al& rhs)
+	{
+		return lhs.length == rhs.length && !memcmp(lhs.str, rhs.str, lhs.length);
+	}
+
+	// strings of the reader are only valid during the callback
+	name_al copy_name(const scalar_al& val)
+	{
+		assert(val.type == SCALAR_STRING);
+
+		char* str = arena->alloc<char>(val.length);
+		memcpy(str, val.str, val.length);
+
+		return { .str = str, .length = val.length };
+	}
+
+	uint16_t domain_ref(const scalar_al& val)
+	{
+		assert(val.type == SCALAR_STRING);
+
+		name_al name = { .str = val.str, .length = val.length };
+
+		for (size_t id = 0; id < domain_names.length; id++) {
+			if (equals(domain_names.data[id], name)) {
+				return id + 1;
 			}
+		}
 
-			// override default 'direction' value if it's defined
-			if (m_syncs.HasMember("direction")) {
-				assert(m_syncs["direction"].IsString());
+		domain_names.push(arena) = copy_name(val);
 
-				std::string sync_direction = m_syncs["direction"].GetString();
+		return domain_names.length;
+	}
 
-				if (sync_direction == "input") {
-					direction = EC_DIR_INPUT;
-				} else if (sync_direction == "output") {
-					direction = EC_DIR_OUTPUT;
+	void push_entry(const EcatHelper::ecat_slave_entry_al& item,
+		const entry_meta_al& meta)
+	{
+		entries.push(arena) = item;
+		metas.push(arena) = meta;
+	}
+
+	bool scalar(const scalar_al& val)
+	{
+		if (skip_depth) {
+			return true;
+		}
+
+		switch (context()) {
+		case CTX_DOMAIN: {
+			if (key == KEY_NAME) {
+				domain.name = copy_name(val);
+				has_name = true;
+			} else if (key == KEY_DIVISOR) {
+				domain.divisor = std::clamp<uint32_t>(to_uint32(val), 1, UINT16_MAX);
+			}
+		} break;
+
+		case CTX_SLAVE: {
+			switch (key) {
+			case KEY_ALIAS: {
+				slave.alias = to_uint32(val);
+				slave_members |= 0x01;
+			} break;
+			case KEY_POSITION: {
+				slave.position = to_uint32(val);
+				slave_members |= 0x02;
+			} break;
+			case KEY_VENDOR_ID: {
+				slave.vendor_id = to_uint32(val);
+				slave_members |= 0x04;
+			} break;
+			case KEY_PRODUCT_CODE: {
+				slave.product_code = to_uint32(val);
+				slave_members |= 0x08;
+			} break;
+			default: {
+			} break;
+			}
+		} break;
+
+		case CTX_DC: {
+			if (key == KEY_ASSIGN_ACTIVATE) {
+				dc.assign_activate = to_uint32(val);
+				has_assign_activate = true;
+			} else if (key == KEY_REFERENCE_CLOCK) {
+				dc.reference_clock = to_bool(val);
+			}
+		} break;
+
+		case CTX_DC_SYNC0:
+		case CTX_DC_SYNC1: {
+			bool sync0 = context() == CTX_DC_SYNC0;
+
+			if (key == KEY_CYCLE) {
+				(sync0 ? dc.sync0_cycle : dc.sync1_cycle) = to_uint32(val);
+			} else if (key == KEY_SHIFT) {
+				(sync0 ? dc.sync0_shift : dc.sync1_shift) = to_int32(val);
+			}
+		} break;
+
+		case CTX_SYNC: {
+			switch (key) {
+			case KEY_INDEX: {
+				sync_index = to_uint32(val);
+				sync_has_index = true;
+			} break;
+			case KEY_WATCHDOG_ENABLED: {
+				sync_watchdog = to_bool(val);
+			} break;
+			case KEY_DOMAIN: {
+				sync_domain = domain_ref(val);
+			} break;
+			case KEY_DIRECTION: {
+				assert(val.type == SCALAR_STRING);
+
+				std::string_view direction(val.str, val.length);
+
+				if (direction == "input") {
+					sync_direction = EC_DIR_INPUT;
+				} else if (direction == "output") {
+					sync_direction = EC_DIR_OUTPUT;
 				} else {
-					throw std::invalid_argument("\"" + sync_direction
+					throw std::invalid_argument("\"" + std::string(direction)
 						+ "\" is invalid value. "
 						+ "'direction' value must be \"input\" or \"output\"");
 				}
+			} break;
+			default: {
+			} break;
 			}
+		} break;
 
-			rapidjson::Value::Array arr_pdos = m_syncs["pdos"].GetArray();
-			EcatHelper::ecat_size_io_al size_arr_pdos = arr_pdos.Size();
-			EcatHelper::ecat_size_io_al i_pdos = 0;
-			for (i_pdos = 0; i_pdos < size_arr_pdos; i_pdos++) {
-
-				rapidjson::Value::Object m_pdos = arr_pdos[i_pdos].GetObject();
-				assert(m_pdos.HasMember("index"));
-
-				EcatHelper::ecat_index_al pdo_index
-					= to_uint32(m_pdos["index"]);
-
-				// add new slave entry if sync doesnt have pdo entries
-				if (!member_is_valid_array(m_pdos, "entries")) {
-					(*slave_length)++;
-
-					(*slave_entries)
-						.push_back({
-							.alias = alias,
-							.position = position,
-							.vendor_id = vendor_id,
-							.product_code = product_code,
-							.sync_index = sync_index,
-							.pdo_index = pdo_index,
-							.direction = direction,
-						});
-
-					continue;
-				}
-
-				rapidjson::Value::Array arr_entries
-					= m_pdos["entries"].GetArray();
-				int32_t size_arr_entries = arr_entries.Size();
-				EcatHelper::ecat_size_io_al i_entries = 0;
-				for (i_entries = 0; i_entries < size_arr_entries; i_entries++) {
-
-					rapidjson::Value::Object m_entries
-						= arr_entries[i_entries].GetObject();
-
-					assert(m_entries.HasMember("index"));
-					assert(m_entries.HasMember("subindex"));
-					assert(m_entries.HasMember("size"));
-
-					EcatHelper::ecat_index_al entry_index;
-					EcatHelper::ecat_sub_al entry_subindex;
-					EcatHelper::ecat_size_al entry_size;
-
-					entry_index = to_uint32(m_entries["index"]);
-					entry_subindex = to_uint32(m_entries["subindex"]);
-					entry_size = to_uint32(m_entries["size"]);
-
-					uint8_t entry_add_to_domain = 0;
-					uint8_t entry_swap_endian = 0;
-					uint8_t entry_signed = 0;
-
-					if (m_entries.HasMember("swap_endian")) {
-						assert(m_entries["swap_endian"].IsBool());
-						entry_swap_endian = static_cast<uint8_t>(
-							m_entries["swap_endian"].GetBool());
-					}
-
-					if (m_entries.HasMember("add_to_domain")) {
-						assert(m_entries["add_to_domain"].IsBool());
-						entry_add_to_domain = static_cast<uint8_t>(
-							m_entries["add_to_domain"].GetBool());
-					}
-
-					if (m_entries.HasMember("signed")) {
-						assert(m_entries["signed"].IsBool());
-						entry_signed = static_cast<uint8_t>(
-							m_entries["signed"].GetBool());
-					}
-
-					// add new slave entry
-					(*slave_length)++;
-
-					(*slave_entries)
-						.push_back({
-							.alias = alias,
-							.position = position,
-							.vendor_id = vendor_id,
-							.product_code = product_code,
-							.sync_index = sync_index,
-							.pdo_index = pdo_index,
-							.index = entry_index,
-							.subindex = entry_subindex,
-							.size = entry_size,
-							.add_to_domain = entry_add_to_domain,
-							.direction = direction,
-							.swap_endian = entry_swap_endian,
-							.is_signed = entry_signed,
-							.watchog_enabled = watchdog_enabled,
-						});
-				}
+		case CTX_PDO: {
+			if (key == KEY_INDEX) {
+				pdo_index = to_uint32(val);
+				pdo_has_index = true;
+			}
+		} break;
+
+		case CTX_ENTRY: {
+			switch (key) {
+			case KEY_INDEX: {
+				entry.index = to_uint32(val);
+				entry_members |= 0x01;
+			} break;
+			case KEY_SUBINDEX: {
+				entry.subindex = to_uint32(val);
+				entry_members |= 0x02;
+			} break;
+			case KEY_SIZE: {
+				entry.size = to_uint32(val);
+				entry_members |= 0x04;
+			} break;
+			case KEY_SWAP_ENDIAN: {
+				entry.swap_endian = to_bool(val);
+			} break;
+			case KEY_ADD_TO_DOMAIN: {
+				entry.add_to_domain = to_bool(val);
+			} break;
+			case KEY_SIGNED: {
+				entry.is_signed = to_bool(val);
+			} break;
+			case KEY_DOMAIN: {
+				entry_domain = domain_ref(val);
+			} break;
+			default: {
+			} break;
+			}
+		} break;
+
+		case CTX_PARAMETER: {
+			switch (key) {
+			case KEY_INDEX: {
+				parameter.index = to_uint32(val);
+				parameter_members |= 0x01;
+			} break;
+			case KEY_SUBINDEX: {
+				parameter.subindex = to_uint32(val);
+				parameter_members |= 0x02;
+			} break;
+			case KEY_SIZE: {
+				parameter.size = to_uint32(val);
+				parameter_members |= 0x04;
+			} break;
+			case KEY_VALUE: {
+				parameter.value.u32 = to_uint32(val);
+				parameter_members |= 0x08;
+			} break;
+			default: {
+			} break;
 			}
+		} break;
+
+		default: {
+		} break;
+		}
+
+		return true;
+	}
+
+	void end_domain()
+	{
+		assert(has_name);
+
+		// 'default' may be redefined, e.g. to change its divisor
+		if (equals(domain.name, domains.data[0].name)) {
+			domains.data[0] = domain;
+		} else {
+			domains.push(arena) = domain;
+		}
+
+		assert(domains.length <= UINT8_MAX);
+	}
+
+	void begin_slave()
+	{
+		slave = {};
+		slave_members = 0;
+		slave_has_syncs = false;
+		has_dc = false;
+
+		slave_entry_begin = entries.length;
+		slave_parameter_begin = parameters.length;
+	}
+
+	void end_slave()
+	{
+		assert(slave_members == 0x0f);
+
+		// add new slave entry if slave doesnt have syncs, its parameters
+		// are left out as well
+		if (!slave_has_syncs) {
+			push_entry({}, {});
+			parameters.length = slave_parameter_begin;
+		}
+
+		for (size_t idx = slave_entry_begin; idx < entries.length; idx++) {
+			EcatHelper::ecat_slave_entry_al& item = entries.data[idx];
+
+			item.alias = slave.alias;
+			item.position = slave.position;
+			item.vendor_id = slave.vendor_id;
+			item.product_code = slave.product_code;
+		}
+
+		for (size_t idx = slave_parameter_begin; idx < parameters.length;
+			 idx++) {
+			parameters.data[idx].slavePosition = slave.position;
+		}
+
+		int32_t dc_index = -1;
+		if (has_dc) {
+			dc.position = slave.position;
+			dc_index = dcs.length;
+			dcs.push(arena) = dc;
+		}
+
+		if (slaves.length
+			&& slave.position < slaves.data[slaves.length - 1].position) {
+			sorted = false;
 		}
 
-		// start adding startup parameters if there is one
-		if (member_is_valid_array(m_slaves, "parameters")) {
-			assert(m_slaves["parameters"].IsArray());
-
-			EcatHelper::ecat_size_io_al pr_size = m_slaves["parameters"].Size();
-			EcatHelper::ecat_size_io_al i_parameters = 0;
-			for (i_parameters = 0; i_parameters < pr_size; i_parameters++) {
-				rapidjson::Value::Object m_parameters
-					= m_slaves["parameters"][i_parameters].GetObject();
-
-				assert(m_parameters.HasMember("index"));
-				assert(m_parameters.HasMember("subindex"));
-				assert(m_parameters.HasMember("size"));
-				assert(m_parameters.HasMember("value"));
-
-				EcatHelper::ecat_index_al p_index
-					= to_uint32(m_parameters["index"]);
-				EcatHelper::ecat_sub_al p_subindex
-					= to_uint32(m_parameters["subindex"]);
-				EcatHelper::ecat_size_al p_size
-					= to_uint32(m_parameters["size"]);
-				uint32_t pr_value = to_uint32(m_parameters["value"]);
-
-				(*slave_parameters)
-					.push_back({
-						.size = p_size,
-						.slavePosition
-						= static_cast<EcatHelper::ecat_pos_al>(position),
-						.index = p_index,
-						.subindex = p_subindex,
-						.value = { .u32 = pr_value },
-					});
-
-				(*parameters_length)++;
+		slaves.push(arena) = {
+			.position = slave.position,
+			.order = (uint32_t)slaves.length,
+			.entry_begin = slave_entry_begin,
+			.entry_count = entries.length - slave_entry_begin,
+			.parameter_begin = slave_parameter_begin,
+			.parameter_count = parameters.length - slave_parameter_begin,
+			.dc = dc_index,
+		};
+	}
+
+	void begin_sync()
+	{
+		slave_has_syncs = true;
+
+		sync_index = 0;
+		sync_has_index = false;
+		sync_has_pdos = false;
+		sync_watchdog = false;
+		sync_direction = -1;
+		sync_domain = 0;
+		sync_entry_begin = entries.length;
+	}
+
+	void end_sync()
+	{
+		assert(sync_has_index && sync_has_pdos);
+
+		uint8_t direction = sync_direction >= 0 ? sync_direction
+			: sync_index < sizeof(SyncMEthercatDirection)
+			? SyncMEthercatDirection[sync_index]
+			: (uint8_t)(sync_index % 2 ? EC_DIR_INPUT : EC_DIR_OUTPUT);
+
+		for (size_t idx = sync_entry_begin; idx < entries.length; idx++) {
+			EcatHelper::ecat_slave_entry_al& item = entries.data[idx];
+			entry_meta_al& meta = metas.data[idx];
+
+			item.sync_index = sync_index;
+			item.direction = direction;
+
+			if (!meta.real) {
+				continue;
 			}
+
+			item.watchog_enabled = sync_watchdog;
+
+			if (meta.domain_ref == DOMAIN_INHERIT) {
+				meta.domain_ref = sync_domain;
+			}
+		}
+	}
+
+	void begin_pdo()
+	{
+		pdo_index = 0;
+		pdo_has_index = false;
+		pdo_has_entries = false;
+		pdo_entry_begin = entries.length;
+	}
+
+	void end_pdo()
+	{
+		assert(pdo_has_index);
+
+		// add new slave entry if pdo doesnt have entries
+		if (!pdo_has_entries) {
+			push_entry({}, {});
+		}
+
+		for (size_t idx = pdo_entry_begin; idx < entries.length; idx++) {
+			entries.data[idx].pdo_index = pdo_index;
+		}
+	}
+
+	void end_entry()
+	{
+		assert(entry_members == 0x07);
+
+		push_entry(entry, { .domain_ref = entry_domain, .real = true });
+	}
+
+	Arena* arena;
+
+	struct arena_array_s<EcatHelper::ecat_slave_entry_al> entries;
+	struct arena_array_s<entry_meta_al> metas;
+	struct arena_array_s<EcatHelper::ecat_startup_config_al> parameters;
+	struct arena_array_s<EcatHelper::ecat_dc_config_al> dcs;
+	struct arena_array_s<slave_record_al> slaves;
+	struct arena_array_s<domain_al> domains;
+	struct arena_array_s<name_al> domain_names; /**< Referenced by entries. */
+	bool sorted = true;
+
+	context_al stack[16];
+	size_t depth = 0;
+	size_t skip_depth = 0;
+	key_al key = KEY_OTHER;
+	bool has_slaves = false;
+
+	domain_al domain;
+	bool has_name = false;
+
+	struct {
+		uint16_t alias;
+		EcatHelper::ecat_pos_al position;
+		uint32_t vendor_id;
+		uint32_t product_code;
+	} slave = {};
+	uint8_t slave_members = 0;
+	bool slave_has_syncs = false;
+	size_t slave_entry_begin = 0;
+	size_t slave_parameter_begin = 0;
+
+	EcatHelper::ecat_dc_config_al dc;
+	bool has_dc = false;
+	bool has_assign_activate = false;
+
+	uint8_t sync_index = 0;
+	bool sync_has_index = false;
+	bool sync_has_pdos = false;
+	bool sync_watchdog = false;
+	int16_t sync_direction = -1;
+	uint16_t sync_domain = 0;
+	size_t sync_entry_begin = 0;
+
+	EcatHelper::ecat_index_al pdo_index = 0;
+	bool pdo_has_index = false;
+	bool pdo_has_entries = false;
+	size_t pdo_entry_begin = 0;
+
+	EcatHelper::ecat_slave_entry_al entry;
+	uint16_t entry_domain = DOMAIN_INHERIT;
+	uint8_t entry_members = 0;
+
+	EcatHelper::ecat_startup_config_al parameter;
+	uint8_t parameter_members = 0;
+};
+
+/****************************************************************************/
+
+int8_t get_file_contents(const std::string& filename, std::string* contents)
+{
+	std::FILE* fp = std::fopen(&filename[0], "rb");
+
+	if (!fp) {
+		perror("Error: Can't open file");
+		return -1;
+	}
+
+	std::fseek(fp, 0, SEEK_END);
+	contents->resize(std::ftell(fp));
+	std::rewind(fp);
+	size_t read = std::fread(&(*contents)[0], 1, contents->size(), fp);
+	int8_t retval = 0;
+
+	if (read != contents->size()) {
+		if (feof(fp)) {
+			fprintf(stderr, "Error reading '%s': unexpected EoF\n",
+				filename.c_str());
+			retval = -3;
+		} else if (ferror(fp)) {
+			fprintf(stderr, "Error reading '%s'", filename.c_str());
+			retval = -2;
 		}
 	}
 
+	std::fclose(fp);
+
+	return retval;
+}
+
+int8_t parse(const char* json_string,
+	std::vector<EcatHelper::ecat_slave_entry_al>* slave_entries,
+	EcatHelper::ecat_size_slave_al* slave_length,
+	std::vector<EcatHelper::ecat_startup_config_al>* slave_parameters,
+	EcatHelper::ecat_size_param_al* parameters_length,
+	std::vector<EcatHelper::ecat_domain_config_al>* domains,
+	std::vector<EcatHelper::ecat_dc_config_al>* dc_configs)
+{
+	size_t objects = count_objects(json_string);
+
+	// one block holds reader's stack and everything kept while parsing,
+	// pages past what the JSON actually needs are never touched
+	Arena arena(READER_STACK_SIZE + Handler::arena_size(objects));
+
+	rapidjson::MemoryPoolAllocator<> stack_allocator(
+		arena.alloc<uint8_t>(READER_STACK_SIZE), READER_STACK_SIZE);
+	rapidjson::GenericReader<rapidjson::UTF8<>, rapidjson::UTF8<>,
+		rapidjson::MemoryPoolAllocator<>>
+		reader(&stack_allocator, READER_STACK_SIZE / 2);
+
+	// re-initialize length with 0
+	*slave_length = 0;
+	*parameters_length = 0;
+
+	dc_configs->clear();
+	domains->clear();
+
+	Handler handler(&arena, objects);
+
+	// relaxed JSON config, i.e. comment and trailing comma are allowed
+	rapidjson::StringStream stream(json_string);
+	rapidjson::ParseResult result
+		= reader.Parse<rapidjson::kParseTrailingCommasFlag
+			| rapidjson::kParseCommentsFlag
+			| rapidjson::kParseEscapedApostropheFlag
+			| rapidjson::kParseNanAndInfFlag>(stream, handler);
+
+	if (!result) {
+		fprintf(stderr, "Error: JSON parse error at offset %zu: %s\n",
+			result.Offset(), rapidjson::GetParseError_En(result.Code()));
+		return -1;
+	}
+
+	handler.resolve_domains();
+	handler.output(slave_entries, slave_parameters, domains, dc_configs);
+
+	*slave_length = handler.entry_count();
+	*parameters_length = handler.parameter_count();
+
 #if VERBOSE > 0
 	printf("slave_length = %d\n", *slave_length);
 #endif
@@ -11,7 +11,9 @@ int8_t parse(const char* json_string,
 	std::vector<EcatHelper::ecat_slave_entry_al>* slave_entries,
 	EcatHelper::ecat_size_slave_al* slave_length,
 	std::vector<EcatHelper::ecat_startup_config_al>* slave_parameters,
-	EcatHelper::ecat_size_param_al* parameters_length);
+	EcatHelper::ecat_size_param_al* parameters_length,
+	std::vector<EcatHelper::ecat_domain_config_al>* domains,
+	std::vector<EcatHelper::ecat_dc_config_al>* dc_configs);
 
 }
 
@@ -1,11 +1,16 @@
 #include <sched.h> /* sched_setscheduler() */
+#include <sys/mman.h> /* mlockall() */
 #include <sys/resource.h>
 #include <sys/time.h>
 #include <sys/types.h>
 #include <unistd.h>
 
 #include <cerrno>
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <cinttypes>
+#include <cmath>
 #include <csignal>
 #include <cstdint>
 #include <cstdio>
@@ -13,15 +18,26 @@
 #include <cstring>
 #include <ctime> /* clock_gettime() */
 #include <filesystem>
+#include <fstream>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <stdexcept>
 #include <thread>
 #include <vector>
 
+#include <FlatIndexMap.hpp>
+#include <SpscQueue.hpp>
 #include <TimespecHelper.hpp>
+#include <TripleBuffer.hpp>
 
+#include "cia402.h"
+#include "config-cache.h"
 #include "config-parser.h"
 #include "etherlab-helper.h"
+#include "interpolator.h"
+#include "io-plan.h"
+#include "recorder.h"
 
 /****************************************************************************/
 /* The maximum stack size which is
@@ -29,6 +45,21 @@
   faulting */
 #define MAX_SAFE_STACK (8 * 1024)
 
+/* SDO requests queued per slave, on top of the one in flight */
+#define SDO_REQUEST_QUEUE_DEPTH 16
+
+/* SDO requests submitted but not yet polled back by the caller */
+#define SDO_REQUEST_MAX_UNSETTLED 1024
+
+/* Cycles averaged before master clock drift correction is updated */
+#define DC_FILTER_CNT 1024
+
+/* Largest drift correction per cycle in ns */
+#define DC_MAX_ADJUST 1000
+
+// trajectory segments one axis can buffer ahead of the cyclic thread
+#define AXIS_SEGMENT_QUEUE_DEPTH 1024
+
 /** Task period in ns. **/
 #ifndef NSEC_PER_SEC
 #define NSEC_PER_SEC 1000000000
@@ -47,53 +78,397 @@ struct op_status_s {
 
 /****************************************************************************/
 
-// EtherCAT
-static ec_master_state_t master_state = {};
-static ec_master_t* master = nullptr;
+// process data domains, index matches ecat_slave_entry_al::domain
+struct domain_s {
+	std::string name;
+	uint16_t divisor = 1;
+
+	ec_domain_t* domain = nullptr;
+	ec_domain_state_t state = {};
+	ec_pdo_entry_reg_t* regs = nullptr;
+	ecat_size_io_al length = 0;
+
+	// process data
+	uint8_t* pd = nullptr;
+	size_t size = 0;
+
+	// IOs of this domain grouped by size, direction and endianness,
+	// built once after registration
+	IOPlan::io_plan_al io_plan;
+
+	// outputs written since the domain was last exchanged, encoded on its
+	// next exchange, only touched by cyclic thread
+	std::vector<uint64_t> dirty;
+	bool dirty_pending = false;
+	bool refresh_pending = false;
+};
+
+// values to be written into domain, produced by JS thread, consumed by
+// cyclic thread. Writes are staged and published as a whole image, so a batch
+// of writes is always applied within the same cycle
+struct output_image_s {
+	ecat_raw_image_al values;
+
+	// 1 bit per domain index, set if value is written since last publication
+	std::vector<uint64_t> dirty;
+};
+
+// SDO requests, one ecrt_sdo_request per transfer size per slave, created
+// before activation and reused for every transfer
+static constexpr uint8_t sdo_request_sizes[] = { 1, 2, 4, 8 };
+
+struct sdo_slot_s {
+	ec_sdo_request_t* requests[sizeof(sdo_request_sizes)] = {};
+
+	// request in flight and the job it serves
+	ec_sdo_request_t* active = nullptr;
+	ecat_sdo_job_al job;
 
-static ec_domain_t* DomainN = nullptr;
-static ec_domain_state_t DomainN_state = {};
-static ec_pdo_entry_reg_t* DomainN_regs = nullptr;
-static ecat_size_io_al DomainN_length;
+	// cycles left before an unfinished request is given up
+	uint32_t cycles_left = 0;
 
-// process data
-static uint8_t* DomainN_pd = nullptr;
+	// job already reported, request is waited for before reuse
+	bool abandoned = false;
+
+	// submitted by JS thread, consumed by cyclic thread
+	SpscQueue<ecat_sdo_job_al> queue;
+};
+
+// CiA 402 drive, added by caller, driven by cyclic thread
+struct axis_s {
+	ecat_axis_config_al config;
+
+	// domain indexes of drive objects, -1 if not mapped
+	ecat_size_io_al controlword = -1;
+	ecat_size_io_al statusword = -1;
+	ecat_size_io_al mode_of_operation = -1;
+	ecat_size_io_al target_position = -1;
+	ecat_size_io_al target_velocity = -1;
+	ecat_size_io_al position_actual = -1;
+
+	// requested by caller
+	std::atomic<uint8_t> request { ECAT_AXIS_DISABLE };
+	std::atomic<bool> fault_reset { false };
+
+	// produced by caller, interpolated while operation is enabled
+	SpscQueue<ecat_segment_al> segments;
+
+	// cyclic thread only
+	Interpolator::interpolator_al interpolator;
+	ecat_setpoint_al setpoint;
+	uint16_t controlword_value = 0;
+	CiA402::state_al state = CiA402::NOT_READY_TO_SWITCH_ON;
+
+	// published by cyclic thread for axis_status()
+	std::atomic<uint16_t> statusword_report { 0 };
+	std::atomic<uint16_t> controlword_report { 0 };
+	std::atomic<uint8_t> state_report { 0 };
+	std::atomic<int32_t> position_report { 0 };
+	std::atomic<int32_t> setpoint_position_report { 0 };
+	std::atomic<int32_t> setpoint_velocity_report { 0 };
+	std::atomic<bool> holding_report { false };
+	std::atomic<uint64_t> underruns { 0 };
+	std::atomic<uint64_t> faults { 0 };
+};
 
-static uint32_t counter = 0;
-static bool is_master_ready = false;
-static struct op_status_s is_operational = { false, false };
+/**
+ * One EtherCAT master and everything configured on it. Public functions of
+ * this namespace forward to the instance bound to the calling thread.
+ */
+class Master {
+public:
+	explicit Master(const uint32_t& index)
+		: index(index)
+	{
+	}
 
-// slave configurations
-static std::vector<ecat_slave_config_al> slaves;
-static ecat_size_slave_al slaves_length = 0;
+	// index passed to ecrt_request_master()
+	const uint32_t index;
+
+	int8_t set_json_path(const std::string& filepath);
+
+	void set_period_ms(uint32_t milliseconds);
+	void set_period_us(uint32_t microseconds);
+	void set_period(uint32_t nanoseconds);
+	void set_frequency(uint32_t hertz);
+
+	void set_output_refresh(uint32_t cycles);
+	void set_dc_drift_compensation(bool enable);
+	void set_application_time(const uint64_t& ns);
+	int64_t dc_wakeup_adjust();
+	void dc_report(ecat_dc_report_al* report);
+	void set_memory_lock(bool enable);
+	void memory_report(ecat_memory_report_al* report);
+
+	uint16_t get_frequency();
+	uint32_t get_period();
+
+	void prerun_routine();
+	void main_routine();
+	void postrun_routine();
+
+	void init();
+
+	bool operational_status();
+	uint8_t application_layer_states();
+
+	void attach_process_data(ecat_entries_al** ptr);
+	std::string domain_name(const uint8_t& domain);
+	void attach_mapped_domain(ecat_domain_map_al** ptr);
+
+	void attach_process_image(
+		ecat_image_value_al* image, const ecat_size_io_al& length);
+	void detach_process_image();
+
+	int8_t domain_write(const ecat_pos_al& s_position,
+		const ecat_index_al& s_index, const ecat_sub_al& s_subindex,
+		const ecat_value_al& value);
+	int8_t domain_read(const ecat_pos_al& s_position,
+		const ecat_index_al& s_index, const ecat_sub_al& s_subindex,
+		ecat_value_al* value);
+
+	ecat_size_io_al domain_resolve(const ecat_pos_al& s_position,
+		const ecat_index_al& s_index, const ecat_sub_al& s_subindex);
+	int8_t domain_write(
+		const ecat_size_io_al& handle, const ecat_value_al& value);
+	int8_t domain_read(const ecat_size_io_al& handle, ecat_value_al* value);
+	int8_t domain_write_many(const ecat_size_io_al* handles,
+		const size_t& count, const uint64_t* raw);
+	int8_t domain_read_many(
+		const ecat_size_io_al* handles, const size_t& count, uint64_t* raw);
+
+	void domain_write_begin();
+	int8_t domain_write_commit();
+	void domain_read_begin();
+	void domain_read_end();
+
+	int8_t sdo_request_submit(const ecat_sdo_job_al& job);
+	bool sdo_request_poll(ecat_sdo_job_al* job);
+	bool sdo_request_completed();
+	int32_t sdo_upload(const ecat_pos_al& s_position,
+		const ecat_index_al& s_index, const ecat_sub_al& s_subindex,
+		const size_t& size, size_t* result_size, uint8_t* value,
+		uint32_t* abort_code);
+	int32_t sdo_download(const ecat_pos_al& s_position,
+		const ecat_index_al& s_index, const ecat_sub_al& s_subindex,
+		const size_t& size, uint8_t* value, uint32_t* abort_code);
+
+	int32_t axis_add(const ecat_axis_config_al& config);
+	int8_t axis_request(const int32_t& axis, const axis_request_al& request);
+	int8_t axis_fault_reset(const int32_t& axis);
+	int8_t axis_push(const int32_t& axis, const ecat_setpoint_al* setpoints,
+		const size_t& count, size_t* pushed);
+	int8_t axis_submit(const int32_t& axis, const ecat_segment_al* segments,
+		const size_t& count, size_t* pushed);
+	int8_t axis_status(const int32_t& axis, ecat_axis_status_al* status);
+	void axis_clear();
+	void axis_freeze();
+	uint64_t axis_underruns();
+
+	int8_t record_start(const std::string& path,
+		const ecat_size_io_al* handles, const size_t& count,
+		const size_t& ring_records);
+	void record_stop();
+	void record_report(ecat_record_report_al* report);
+
+private:
+	void check_domain_state(struct domain_s* dmn);
+	void check_master_state(ec_master_t* master);
+	void check_slave_config_states();
+
+	void domain_startup_config(ecat_size_io_al* dmn_size);
+	void syncmanager_startup_config();
+	void slave_startup_config(ec_master_t* master);
+	void startup_parameters_config();
+	void dc_startup_config();
+	void reset_global_vars();
+
+	int8_t init_slaves();
+	void init_master_and_domain();
+	void activate_master();
+
+	void sample_page_faults();
+
+	void dc_sync();
+	void dc_update_master_clock();
+
+	// mapped domain
+	ecat_size_io_al get_domain_index(ecat_size_io_al* dmn_idx,
+		const ecat_pos_al& s_position, const ecat_index_al& s_index,
+		const ecat_sub_al& s_subindex);
+	void assign_domain_identifier();
+
+	void sdo_request_pool_config();
+	void sdo_request_complete(ecat_sdo_job_al& job, const int32_t& retval);
+	void sdo_request_routine();
+	void sdo_request_cancel();
+
+	void axis_resolve();
+	void axis_routine();
+
+	int8_t record_open();
+	void record_close();
+	void record_routine();
+
+	// EtherCAT
+	ec_master_state_t master_state = {};
+	ec_master_t* master = nullptr;
+
+	std::vector<ecat_domain_config_al> domain_configs;
+	std::vector<struct domain_s> domains;
+	ecat_size_io_al DomainN_length = 0;
+
+	uint32_t counter = 0;
+
+	// cycles since activation, domains are exchanged when divisible by divisor
+	uint32_t cycle_counter = 0;
+	bool is_master_ready = false;
+	struct op_status_s is_operational = { false, false };
+
+	// slave configurations
+	std::vector<ecat_slave_config_al> slaves;
+	ecat_size_slave_al slaves_length = 0;
+
+	ecat_entries_al slave_entries;
+	ecat_size_slave_al slave_entries_length = 0;
+
+	std::vector<ecat_startup_config_al> startup_parameters;
+	ecat_size_param_al startup_parameters_length = 0;
+
+	ecat_entries_al IOs;
+
+	// values read from domain, produced by cyclic thread, consumed by JS
+	// thread
+	TripleBuffer<ecat_raw_image_al> input_image;
+	bool is_reading = false;
+
+	TripleBuffer<struct output_image_s> output_image;
+	struct output_image_s output_staging;
+	std::vector<uint64_t> output_unconsumed_dirty;
+	bool is_writing = false;
+
+	// per slot of output_image, values written since that slot was last
+	// the back slot. Only those are copied on commit
+	std::vector<uint64_t> output_stale[3];
+
+	// every n-th cycle all outputs are written regardless of dirty bits,
+	// set from JS thread while cyclic thread counts down
+	std::atomic<uint32_t> output_refresh_cycles { 0 };
+	std::atomic<uint32_t> output_refresh_counter { 0 };
+
+	// decoded IOs values, published each cycle into a buffer owned by the
+	// caller
+	ecat_image_value_al* process_image = nullptr;
+	ecat_size_io_al process_image_length = 0;
+
+	// last published input image was decoded in OP, domains not exchanged
+	// are carried over from it and from the image of that cycle, which the
+	// caller must not change until the next cycle
+	bool inputs_carry = false;
+	ecat_image_value_al* carry_image = nullptr;
+
+	std::unique_ptr<struct sdo_slot_s[]> sdo_slots;
+	ecat_size_slave_al sdo_slots_length = 0;
+	std::atomic<bool> sdo_pool_ready { false };
+
+	// finished jobs, produced by cyclic thread, consumed by caller
+	SpscQueue<ecat_sdo_job_al> sdo_completions;
+	std::atomic<uint32_t> sdo_unsettled { 0 };
+
+	// set from prerun to postrun routine
+	std::atomic<bool> cyclic_running { false };
+
+	// CiA 402 axes, kept across restarts, only changed while stopped
+	std::vector<std::unique_ptr<struct axis_s>> axes;
+
+	// set before cyclic thread is spawned until postrun routine, axes are
+	// resolved by cyclic thread before it sets cyclic_running
+	std::atomic<bool> axes_frozen { false };
+
+	// underruns of all axes, published for cheap polling
+	std::atomic<uint64_t> axes_underruns { 0 };
+
+	// Distributed Clocks, parsed from JSON with the slaves
+	std::vector<ecat_dc_config_al> dc_configs;
+	int32_t dc_reference_position = -1;
+
+	// master clock follows reference clock instead of the other way round
+	bool dc_follow_reference = false;
+
+	// application time of this and previous cycle, in ns
+	uint64_t dc_app_time = 0;
+	uint64_t dc_prev_app_time = 0;
+
+	// offset of application time to caller's clock. Every correction delays
+	// the wakeup and is taken off here, so application time keeps its
+	// period while the master cycle follows the reference clock
+	int64_t dc_time_base = 0;
+	int64_t dc_cycle_adjust = 0;
+
+	int32_t dc_diff_ns = 0;
+	int32_t dc_prev_diff_ns = 0;
+	int64_t dc_diff_total_ns = 0;
+	int64_t dc_delta_total_ns = 0;
+	uint32_t dc_filter_idx = 0;
+	int64_t dc_adjust_ns = 0;
+	bool dc_started = false;
+
+	// published by cyclic thread for dc_report()
+	std::atomic<int32_t> dc_diff_report { 0 };
+	std::atomic<int64_t> dc_adjust_report { 0 };
+
+	// process data recording, requested by caller, opened at once or when
+	// the master starts. Selected entries are packed, none means every
+	// domain is recorded as it is
+	std::mutex record_lock;
+	std::string record_path;
+	std::vector<ecat_size_io_al> record_handles;
+	std::vector<uint8_t> record_widths;
+	size_t record_ring = 0;
+	std::unique_ptr<Recorder::Recording> recording;
+
+	// taken by cyclic thread, busy while a record is being written
+	std::atomic<Recorder::Recording*> recording_active { nullptr };
+	std::atomic<bool> recording_busy { false };
+
+	// memory locking before cyclic loop, page faults sampled by cyclic thread
+	bool lock_memory = false;
+	bool memory_locked = false;
+	struct rusage rusage_startup = {};
+
+	// locking and startup faults as published by cyclic thread
+	std::mutex memory_report_lock;
+	ecat_memory_report_al memory_startup;
+
+	std::atomic<uint64_t> minor_faults_loop { 0 };
+	std::atomic<uint64_t> major_faults_loop { 0 };
+
+	ecat_domain_map_al mapped_domains;
+
+	// Periodic task timing
+	uint16_t frequency = 1000;
+	uint32_t period_ns = NSEC_PER_SEC / frequency;
+
+	// configuration
+	std::string json_path;
+};
 
-static ecat_entries_al slave_entries;
-static ecat_size_slave_al slave_entries_length = 0;
+// instances live until process exits, ecrt masters are released on stop
+static std::map<uint32_t, std::unique_ptr<Master>> masters;
+static std::mutex masters_lock;
 
-static std::vector<ecat_startup_config_al> startup_parameters;
-static ecat_size_param_al startup_parameters_length = 0;
+// instance used by calls from this thread
+static thread_local Master* bound_master = nullptr;
 
-static ecat_entries_al IOs;
+// mlockall() is process wide, memory is unlocked when last master stops
+static uint32_t memory_lock_count = 0;
 
 // SM startup config
 inline static uint32_t convert_index_sub_size(const ecat_index_al& index,
 	const ecat_sub_al& subindex, const ecat_size_al& size);
 
-// mapped domain
-static ecat_domain_map_al mapped_domains;
-inline static uint32_t convert_pos_index_sub(const ecat_pos_al& s_position,
+inline static uint64_t convert_pos_index_sub(const ecat_pos_al& s_position,
 	const ecat_index_al& s_index, const ecat_sub_al& s_subindex);
-static ecat_size_io_al get_domain_index(ecat_size_io_al* dmn_idx,
-	const ecat_pos_al& s_position, const ecat_index_al& s_index,
-	const ecat_sub_al& s_subindex);
-static void assign_domain_identifier();
-
-// Periodic task timing
-static uint16_t frequency = 1000;
-static uint32_t period_ns = NSEC_PER_SEC / frequency;
-
-// configuration
-static std::string json_path;
 
 // SDO error message
 static std::map<uint32_t, std::string> sdo_abort_message = {
@@ -155,39 +530,47 @@ void delay_ns(uint64_t ns)
 	clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &timer, NULL);
 }
 
-int8_t set_json_path(const std::string& filepath)
+int8_t Master::set_json_path(const std::string& filepath)
 {
 	if (!fs::exists(filepath)) {
 		return -1;
 	}
 
 	json_path = filepath;
+
+#ifdef ECAT_SIMULATION
+	// simulated bus consists of the slaves the configuration describes
+	if (ecrt_sim_load(index, filepath.c_str())) {
+		return -1;
+	}
+#endif
+
 	return 0;
 }
 
-void check_domain_state()
+void Master::check_domain_state(struct domain_s* dmn)
 {
 	ec_domain_state_t ds;
-	ecrt_domain_state(DomainN, &ds);
+	ecrt_domain_state(dmn->domain, &ds);
 
 #if VERBOSE > 1
-	if (ds.working_counter != DomainN_state.working_counter) {
+	if (ds.working_counter != dmn->state.working_counter) {
 		timespec_get(&epoch, TIME_UTC);
-		printf("%ld.%09ld | Domain1: WC %u.\n", epoch.tv_sec, epoch.tv_nsec,
-			ds.working_counter);
+		printf("%ld.%09ld | Domain %s: WC %u.\n", epoch.tv_sec, epoch.tv_nsec,
+			dmn->name.c_str(), ds.working_counter);
 	}
 
-	if (ds.wc_state != DomainN_state.wc_state) {
+	if (ds.wc_state != dmn->state.wc_state) {
 		timespec_get(&epoch, TIME_UTC);
-		printf("%ld.%09ld | Domain1: State %u.\n", epoch.tv_sec, epoch.tv_nsec,
-			ds.wc_state);
+		printf("%ld.%09ld | Domain %s: State %u.\n", epoch.tv_sec,
+			epoch.tv_nsec, dmn->name.c_str(), ds.wc_state);
 	}
 #endif
 
-	DomainN_state = ds;
+	dmn->state = ds;
 }
 
-void check_master_state(ec_master_t* master)
+void Master::check_master_state(ec_master_t* master)
 {
 	ec_master_state_t ms;
 	ecrt_master_state(master, &ms);
@@ -216,7 +599,7 @@ void check_master_state(ec_master_t* master)
 	is_operational.master = (master_state.al_states & EC_AL_STATE_OP) != 0;
 }
 
-void check_slave_config_states()
+void Master::check_slave_config_states()
 {
 	uint8_t sop_state = 1;
 	for (ecat_size_slave_al slave_idx = 0; slave_idx < slaves_length;
@@ -252,53 +635,24 @@ void check_slave_config_states()
 	is_operational.slaves = sop_state;
 }
 
-int8_t write_output_value(
-	const ecat_size_io_al& dmn_idx, const ecat_value_al& value)
+void Master::main_routine()
 {
-	// selected index is not output, return immediately
-	if (IOs[dmn_idx].direction != EC_DIR_OUTPUT) {
-		return -1;
-	}
-
-	switch (IOs[dmn_idx].size) {
-	case 1: {
-		EC_WRITE_BIT(DomainN_pd + IOs[dmn_idx].offset,
-			IOs[dmn_idx].bit_position, value.u8 & 0x1);
-		return 1;
-	} break;
-
-	case 8: {
-		EC_WRITE_U8(DomainN_pd + IOs[dmn_idx].offset, value.u8);
-	} break;
-
-	case 16: {
-		EC_WRITE_U16(DomainN_pd + IOs[dmn_idx].offset, value.u16);
-	} break;
+	// receive process data, a domain is only exchanged on its own cycles
+	ecrt_master_receive(master);
 
-	case 32: {
-		EC_WRITE_U32(DomainN_pd + IOs[dmn_idx].offset, value.u32);
-	} break;
+	for (struct domain_s& dmn : domains) {
+		if (cycle_counter % dmn.divisor) {
+			continue;
+		}
 
-	case 64: {
-		EC_WRITE_U64(DomainN_pd + IOs[dmn_idx].offset, value.u64);
-	} break;
+		ecrt_domain_process(dmn.domain);
 
-	default: {
-		return 0;
-	} break;
+		// check process data state
+		check_domain_state(&dmn);
 	}
 
-	return 1;
-}
-
-void main_routine()
-{
-	// receive process data
-	ecrt_master_receive(master);
-	ecrt_domain_process(DomainN);
-
-	// check process data state
-	check_domain_state();
+	// SDO requests are serviced in any state
+	sdo_request_routine();
 
 	// update states every 1s
 	if (!counter--) {
@@ -310,69 +664,248 @@ void main_routine()
 
 		// update slave configuration state(s)
 		check_slave_config_states();
+
+		sample_page_faults();
 	}
 
 	// do nothing if master is not ready
 	if (master_state.al_states & EC_AL_STATE_OP) {
 
-		for (ecat_size_io_al dmn_idx = 0; dmn_idx < DomainN_length; dmn_idx++) {
-			if (IOs[dmn_idx].direction == EC_DIR_OUTPUT) {
-				write_output_value(dmn_idx, IOs[dmn_idx].written_value);
+		// take latest committed writes, if any
+		bool has_new_outputs = output_image.update();
+		const struct output_image_s& outputs = output_image.front();
+
+		uint32_t counter
+			= output_refresh_counter.load(std::memory_order_relaxed);
+		bool refresh = !counter;
+
+		// only changed outputs are encoded, except on periodic refresh
+		uint32_t next;
+		if (refresh) {
+			uint32_t cycles
+				= output_refresh_cycles.load(std::memory_order_relaxed);
+			next = cycles ? cycles : UINT32_MAX;
+		} else {
+			next = counter - 1;
+		}
+
+		// a counter set by JS thread meanwhile wins over the countdown
+		output_refresh_counter.compare_exchange_strong(
+			counter, next, std::memory_order_relaxed);
+
+		ecat_image_value_al* image
+			= process_image_length == DomainN_length ? process_image : nullptr;
+
+		uint64_t* raw = input_image.back().data();
+		size_t words = outputs.dirty.size();
+
+		// without an image of previous cycle, skipped domains are decoded
+		bool carry = inputs_carry && (!image || carry_image);
+
+		// domains are only encoded and decoded on their exchange cycles
+		for (struct domain_s& dmn : domains) {
+			if (cycle_counter % dmn.divisor) {
+				dmn.refresh_pending |= refresh;
+				if (has_new_outputs) {
+					IOPlan::merge_dirty(
+						dmn.dirty.data(), outputs.dirty.data(), words);
+					dmn.dirty_pending = true;
+				}
+
+				if (carry) {
+					IOPlan::carry(dmn.io_plan, input_image.last().data(), raw,
+						carry_image, image);
+				} else {
+					IOPlan::decode(dmn.io_plan, dmn.pd, raw, image);
+				}
+
+				continue;
+			}
+
+			if (refresh || dmn.refresh_pending) {
+				IOPlan::encode(dmn.io_plan, dmn.pd, outputs.values.data());
+			} else if (dmn.dirty_pending) {
+				if (has_new_outputs) {
+					IOPlan::merge_dirty(
+						dmn.dirty.data(), outputs.dirty.data(), words);
+				}
+				IOPlan::encode_dirty(dmn.io_plan, dmn.pd,
+					outputs.values.data(), dmn.dirty.data());
+			} else if (has_new_outputs) {
+				IOPlan::encode_dirty(dmn.io_plan, dmn.pd,
+					outputs.values.data(), outputs.dirty.data());
 			}
 
-			switch (IOs[dmn_idx].size) {
-
-			// No endian difference for 1 bit variable
-			case 1: {
-				IOs[dmn_idx].value.u8
-					= EC_READ_BIT(DomainN_pd + IOs[dmn_idx].offset,
-						  IOs[dmn_idx].bit_position)
-					& 0x1;
-			} break;
-
-			// No endian difference for 1 byte variable
-			case 8: {
-				IOs[dmn_idx].value.u8
-					= EC_READ_U8(DomainN_pd + IOs[dmn_idx].offset);
-			} break;
-
-			case 16: {
-				uint16_t tmp16 = EC_READ_U16(DomainN_pd + IOs[dmn_idx].offset);
-				IOs[dmn_idx].value.u16
-					= IOs[dmn_idx].swap_endian ? swap_endian16(tmp16) : tmp16;
-			} break;
-
-			case 32: {
-				uint32_t tmp32 = EC_READ_U32(DomainN_pd + IOs[dmn_idx].offset);
-				IOs[dmn_idx].value.u32
-					= IOs[dmn_idx].swap_endian ? swap_endian32(tmp32) : tmp32;
-			} break;
-
-			default: {
-				uint64_t tmp64 = EC_READ_U64(DomainN_pd + IOs[dmn_idx].offset);
-				IOs[dmn_idx].value.u64
-					= IOs[dmn_idx].swap_endian ? swap_endian32(tmp64) : tmp64;
-			} break;
+			if (dmn.dirty_pending) {
+				std::fill(dmn.dirty.begin(), dmn.dirty.end(), 0);
+				dmn.dirty_pending = false;
 			}
+			dmn.refresh_pending = false;
+
+			// outputs are read back as well, the same as inputs
+			IOPlan::decode(dmn.io_plan, dmn.pd, raw, image);
+		}
+
+		inputs_carry = true;
+		carry_image = image;
+
+		// drive objects of axes take precedence over caller's writes
+		if (!axes.empty()) {
+			axis_routine();
+		}
+
+		// image as sent, outputs of this cycle included
+		record_routine();
 
 #if VERBOSE > 2
-			printf("Index %2d pos %d 0x%04x:%02x offset %d = %8x\n", dmn_idx,
+		for (ecat_size_io_al dmn_idx = 0; dmn_idx < DomainN_length; dmn_idx++) {
+			printf("Index %2d pos %d 0x%04x:%02x offset %d = %8lx\n", dmn_idx,
 				IOs[dmn_idx].position, IOs[dmn_idx].index,
-				IOs[dmn_idx].subindex, IOs[dmn_idx].offset, IOs[dmn_idx].value);
+				IOs[dmn_idx].subindex, IOs[dmn_idx].offset,
+				input_image.back()[dmn_idx]);
+		}
 #endif
-		};
+
+		input_image.publish();
 
 #if VERBOSE > 2
 		printf("=====================\n");
 #endif
+	} else {
+		inputs_carry = false;
+	}
+
+	// clocks are synchronized with the same frame as process data
+	if (!dc_configs.empty()) {
+		dc_sync();
+	}
+
+	for (struct domain_s& dmn : domains) {
+		if (cycle_counter % dmn.divisor == 0) {
+			ecrt_domain_queue(dmn.domain);
+		}
 	}
 
-	ecrt_domain_queue(DomainN);
 	ecrt_master_send(master);
+
+	if (dc_follow_reference && !dc_configs.empty()) {
+		dc_update_master_clock();
+	}
+
+	cycle_counter++;
+}
+
+void Master::dc_sync()
+{
+	ecrt_master_application_time(master, dc_app_time);
+
+	if (dc_follow_reference) {
+		// reference clock time is latched by previous frame
+		uint32_t ref_time = 0;
+		ecrt_master_reference_clock_time(master, &ref_time);
+		dc_diff_ns = (uint32_t)dc_prev_app_time - ref_time;
+	} else {
+		ecrt_master_sync_reference_clock(master);
+	}
+
+	ecrt_master_sync_slave_clocks(master);
+}
+
+void Master::dc_update_master_clock()
+{
+	int32_t delta = dc_diff_ns - dc_prev_diff_ns;
+	dc_prev_diff_ns = dc_diff_ns;
+
+	// difference within [-period/2, period/2), % keeps the sign of a
+	// negative difference, so it is floored by hand
+	int32_t cycle = period_ns;
+	int32_t diff = (dc_diff_ns + cycle / 2) % cycle;
+	if (diff < 0) {
+		diff += cycle;
+	}
+	diff -= cycle / 2;
+
+	dc_cycle_adjust = 0;
+
+	if (!dc_started) {
+		// first sample, jump onto the reference clock at once
+		dc_started = diff != 0;
+		dc_cycle_adjust = diff;
+	} else {
+		dc_diff_total_ns += diff;
+		dc_delta_total_ns += delta;
+
+		if (++dc_filter_idx >= DC_FILTER_CNT) {
+			// average drift rounded half away from zero, plus a nudge
+			// towards zero offset
+			int64_t half = dc_delta_total_ns < 0 ? -DC_FILTER_CNT / 2
+												 : DC_FILTER_CNT / 2;
+			dc_adjust_ns += (dc_delta_total_ns + half) / DC_FILTER_CNT;
+			dc_adjust_ns += (dc_diff_total_ns > 0) - (dc_diff_total_ns < 0);
+			dc_adjust_ns = std::clamp<int64_t>(
+				dc_adjust_ns, -DC_MAX_ADJUST, DC_MAX_ADJUST);
+
+			dc_diff_total_ns = 0;
+			dc_delta_total_ns = 0;
+			dc_filter_idx = 0;
+		}
+
+		dc_cycle_adjust = dc_adjust_ns + (diff > 0) - (diff < 0);
+	}
+
+	dc_time_base -= dc_cycle_adjust;
+
+	dc_diff_report.store(diff, std::memory_order_relaxed);
+	dc_adjust_report.store(dc_adjust_ns, std::memory_order_relaxed);
+}
+
+void Master::dc_startup_config()
+{
+	if (dc_configs.empty()) {
+		return;
+	}
+
+#if VERBOSE > 0
+	fprintf(stdout, "\nConfiguring Distributed Clocks...\n");
+#endif
+
+	for (const ecat_dc_config_al& dc : dc_configs) {
+		if (dc.position >= slaves_length) {
+			fprintf(stderr, "DC: Slave %d is not configured!\n", dc.position);
+			exit(EXIT_FAILURE);
+		}
+
+		ec_slave_config_t* sc = slaves.at(dc.position).sc;
+		uint32_t sync0_cycle = dc.sync0_cycle ? dc.sync0_cycle : period_ns;
+
+		if (ecrt_slave_config_dc(sc, dc.assign_activate, sync0_cycle,
+				dc.sync0_shift, dc.sync1_cycle, dc.sync1_shift)) {
+
+			fprintf(stderr, "Failed to configure DC. Slave %2d\n",
+				dc.position);
+			exit(EXIT_FAILURE);
+		}
+
+		if (dc.reference_clock) {
+			if (ecrt_master_select_reference_clock(master, sc)) {
+				fprintf(stderr, "Failed to select reference clock. Slave %2d\n",
+					dc.position);
+				exit(EXIT_FAILURE);
+			}
+
+			dc_reference_position = dc.position;
+		}
+
+#if VERBOSE > 0
+		printf("Slave %2d: AssignActivate 0x%04x SYNC0 %u/%d SYNC1 %u/%d%s\n",
+			dc.position, dc.assign_activate, sync0_cycle, dc.sync0_shift,
+			dc.sync1_cycle, dc.sync1_shift,
+			dc.reference_clock ? " (reference clock)" : "");
+#endif
+	}
 }
 
-void domain_startup_config(
-	ec_pdo_entry_reg_t** DomainN_regs, ecat_size_io_al* dmn_size)
+void Master::domain_startup_config(ecat_size_io_al* dmn_size)
 {
 #if VERBOSE > 0
 	fprintf(stdout, "\nConfiguring Domains...\n");
@@ -396,40 +929,77 @@ void domain_startup_config(
 		}
 	}
 
-	// new size to be allocated into DomainN_regs
-	ecat_size_io_al alloc_size = ((*dmn_size) + 1) * sizeof(ec_pdo_entry_reg_t);
-
-	// allocate domain_regs
-	*DomainN_regs = (ec_pdo_entry_reg_t*)malloc(alloc_size);
-
 	// reserve vector memory allocation,
 	// in order to avoid pointer address change everytime we push_back new value
 	IOs.reserve(length);
 
-	// add every valid slave process data into domain
-	for (entry_idx = 0, dmn_idx = 0; entry_idx < length; entry_idx++) {
+	// create IOs domain to access domain value
+	for (entry_idx = 0; entry_idx < length; entry_idx++) {
 		if (slave_entries[entry_idx].add_to_domain) {
-			// create IOs domain to access domain value
 			IOs.push_back(slave_entries[entry_idx]);
-
-			// register domain with IOs
-			(*DomainN_regs)[dmn_idx] = {
-				.alias = IOs[dmn_idx].alias,
-				.position = IOs[dmn_idx].position,
-				.vendor_id = IOs[dmn_idx].vendor_id,
-				.product_code = IOs[dmn_idx].product_code,
-				.index = IOs[dmn_idx].index,
-				.subindex = IOs[dmn_idx].subindex,
-				.offset = &IOs[dmn_idx].offset,
-				.bit_position = &IOs[dmn_idx].bit_position,
-			};
-
-			dmn_idx++;
+			domains[IOs.back().domain].length++;
 		}
 	}
 
-	// terminate with an empty structure
-	(*DomainN_regs)[(*dmn_size)] = {};
+	// register IOs into their own domain
+	for (struct domain_s& dmn : domains) {
+		// new size to be allocated into regs
+		size_t alloc_size = (dmn.length + 1) * sizeof(ec_pdo_entry_reg_t);
+		dmn.regs = (ec_pdo_entry_reg_t*)malloc(alloc_size);
+
+		// terminate with an empty structure
+		dmn.regs[dmn.length] = {};
+		dmn.length = 0;
+	}
+
+	for (dmn_idx = 0; dmn_idx < *dmn_size; dmn_idx++) {
+		struct domain_s& dmn = domains[IOs[dmn_idx].domain];
+
+		dmn.regs[dmn.length++] = {
+			.alias = IOs[dmn_idx].alias,
+			.position = IOs[dmn_idx].position,
+			.vendor_id = IOs[dmn_idx].vendor_id,
+			.product_code = IOs[dmn_idx].product_code,
+			.index = IOs[dmn_idx].index,
+			.subindex = IOs[dmn_idx].subindex,
+			.offset = &IOs[dmn_idx].offset,
+			.bit_position = &IOs[dmn_idx].bit_position,
+		};
+	}
+
+	// allocate process images once, they are never resized while running
+	ecat_size_io_al image_size = *dmn_size;
+	size_t dirty_size = IOPlan::dirty_words(image_size);
+
+	auto clear_outputs = [image_size, dirty_size](struct output_image_s& image) {
+		image.values.assign(image_size, 0);
+		image.dirty.assign(dirty_size, 0);
+	};
+
+	input_image.for_each([image_size](ecat_raw_image_al& image) {
+		image.assign(image_size, 0);
+	});
+
+	for (struct domain_s& dmn : domains) {
+		dmn.dirty.assign(dirty_size, 0);
+		dmn.dirty_pending = false;
+		dmn.refresh_pending = false;
+	}
+	inputs_carry = false;
+
+	output_image.for_each(clear_outputs);
+	clear_outputs(output_staging);
+	output_unconsumed_dirty.assign(dirty_size, 0);
+
+	for (std::vector<uint64_t>& stale : output_stale) {
+		stale.assign(dirty_size, 0);
+	}
+
+	// every output is written on first cycle
+	output_refresh_counter.store(0, std::memory_order_relaxed);
+
+	is_reading = false;
+	is_writing = false;
 }
 
 uint32_t convert_index_sub_size(const ecat_index_al& index,
@@ -438,7 +1008,7 @@ uint32_t convert_index_sub_size(const ecat_index_al& index,
 	return ((index & 0xffff) << 16) | ((subindex & 0xff) << 8) | (size & 0xff);
 }
 
-void syncmanager_startup_config()
+void Master::syncmanager_startup_config()
 {
 #if VERBOSE > 0
 	fprintf(stdout, "\nConfiguring SyncManager and Mapping PDOs...\n");
@@ -588,7 +1158,7 @@ uint8_t skip_current_slave_position(
 	return 0;
 }
 
-void slave_startup_config(ec_master_t* master)
+void Master::slave_startup_config(ec_master_t* master)
 {
 #if VERBOSE > 0
 	fprintf(stdout, "\nConfiguring Slaves...\n");
@@ -639,13 +1209,13 @@ void slave_startup_config(ec_master_t* master)
 	}
 }
 
-void startup_parameters_config()
+void Master::startup_parameters_config()
 {
 #if VERBOSE > 0
 	fprintf(stdout, "\nConfiguring Startup Parameters...\n");
 #endif
 
-	static ecat_size_param_al length = startup_parameters_length;
+	ecat_size_param_al length = startup_parameters_length;
 	for (ecat_size_param_al par_idx = 0; par_idx < length; par_idx++) {
 		switch (startup_parameters[par_idx].size) {
 		case 8: {
@@ -684,10 +1254,15 @@ void startup_parameters_config()
 	}
 }
 
-void reset_global_vars()
+void Master::reset_global_vars()
 {
 	IOs.clear();
+	domains.clear();
 	DomainN_length = 0;
+	cycle_counter = 0;
+
+	dc_configs.clear();
+	dc_reference_position = -1;
 
 	slaves.clear();
 	slaves_length = 0;
@@ -705,46 +1280,77 @@ void stack_prefault()
 {
 	unsigned char dummy[MAX_SAFE_STACK];
 	memset(dummy, 0, MAX_SAFE_STACK);
+
+	// keep the stores, dummy is never read
+	asm volatile("" : : "r"(dummy) : "memory");
+}
+
+static uint64_t read_locked_bytes()
+{
+	std::ifstream status("/proc/self/status");
+	std::string line;
+
+	while (std::getline(status, line)) {
+		if (line.rfind("VmLck:", 0) == 0) {
+			return std::stoull(line.substr(6)) * 1024;
+		}
+	}
+
+	return 0;
+}
+
+void Master::sample_page_faults()
+{
+	struct rusage usage;
+
+	if (getrusage(RUSAGE_THREAD, &usage)) {
+		return;
+	}
+
+	minor_faults_loop.store(usage.ru_minflt - rusage_startup.ru_minflt,
+		std::memory_order_relaxed);
+	major_faults_loop.store(usage.ru_majflt - rusage_startup.ru_majflt,
+		std::memory_order_relaxed);
 }
 
-void assign_domain_identifier()
+void Master::assign_domain_identifier()
 {
 #if VERBOSE > 0
 	printf("\nAssigning Domain identifier...\n");
 #endif
 
+	mapped_domains.reserve(DomainN_length);
+
 	for (ecat_size_io_al dmn_idx = 0; dmn_idx < DomainN_length; dmn_idx++) {
-		uint32_t identifier = convert_pos_index_sub(
+		uint64_t identifier = convert_pos_index_sub(
 			IOs[dmn_idx].position, IOs[dmn_idx].index, IOs[dmn_idx].subindex);
 
-		mapped_domains[identifier] = dmn_idx;
+		mapped_domains.insert(identifier, dmn_idx);
 	}
 }
 
-uint32_t convert_pos_index_sub(const ecat_pos_al& s_position,
+uint64_t convert_pos_index_sub(const ecat_pos_al& s_position,
 	const ecat_index_al& s_index, const ecat_sub_al& s_subindex)
 {
-	return (s_position << 24) | (s_index << 8) | (s_subindex << 0);
+	return (static_cast<uint64_t>(s_position) << 24) | (s_index << 8)
+		| (s_subindex << 0);
 }
 
-ecat_size_io_al get_domain_index(ecat_size_io_al* dmn_idx,
+ecat_size_io_al Master::get_domain_index(ecat_size_io_al* dmn_idx,
 	const ecat_pos_al& s_position, const ecat_index_al& s_index,
 	const ecat_sub_al& s_subindex)
 {
-	uint32_t key = convert_pos_index_sub(s_position, s_index, s_subindex);
-
-	try {
-		*dmn_idx = mapped_domains.at(key);
-		return 0;
-	} catch (const std::out_of_range& err) {
-		fprintf(stderr, "Error %s: Index not found for pos %2d 0x%04x:%02x\n",
-			err.what(), s_position, s_index, s_subindex);
+	uint64_t key = convert_pos_index_sub(s_position, s_index, s_subindex);
 
+	// a miss is reported by the caller, resolve() only returns -1
+	if ((*dmn_idx = mapped_domains.find(key)) < 0) {
 		return -1;
 	}
+
+	return 0;
 }
 
-int8_t init_slaves()
+int8_t Master::init_slaves()
 {
 #if VERBOSE > 0
 	fprintf(stderr, "\nInitialize slaves from JSON '%s' %d\n",
@@ -758,11 +1364,37 @@ int8_t init_slaves()
 		return retval;
 	}
 
-	return ConfigParser::parse(&contents[0], &slave_entries,
-		&slave_entries_length, &startup_parameters, &startup_parameters_length);
+	// unchanged JSON is taken from the parser's output of a previous start
+	uint64_t json_hash = ConfigCache::hash(contents);
+	std::string cache_path = ConfigCache::path_of(json_hash);
+
+	if (!ConfigCache::load(cache_path, json_hash, contents.size(),
+			&slave_entries, &slave_entries_length, &startup_parameters,
+			&startup_parameters_length, &domain_configs, &dc_configs)) {
+#if VERBOSE > 0
+		fprintf(stderr, "Slaves loaded from cache '%s'\n", cache_path.c_str());
+#endif
+		return 0;
+	}
+
+	if ((retval = ConfigParser::parse(&contents[0], &slave_entries,
+			 &slave_entries_length, &startup_parameters,
+			 &startup_parameters_length, &domain_configs, &dc_configs))) {
+		return retval;
+	}
+
+	if (ConfigCache::store(cache_path, json_hash, contents.size(),
+			slave_entries, slave_entries_length, startup_parameters,
+			startup_parameters_length, domain_configs, dc_configs)) {
+#if VERBOSE > 0
+		fprintf(stderr, "Slaves not cached to '%s'\n", cache_path.c_str());
+#endif
+	}
+
+	return 0;
 }
 
-void init_master_and_domain()
+void Master::init_master_and_domain()
 {
 	if (is_master_ready) {
 #if VERBOSE > 0
@@ -775,8 +1407,8 @@ void init_master_and_domain()
 	fprintf(stdout, "\nInitializing Master and Domains\n");
 #endif
 
-	DomainN_regs = nullptr;
 	master = nullptr;
+	domains.clear();
 	DomainN_length = 0;
 
 	if (slave_entries_length == 0) {
@@ -790,9 +1422,9 @@ void init_master_and_domain()
 	fprintf(stdout, "\nRequesting ethercat master\n");
 #endif
 	// request ethercat master
-	master = ecrt_request_master(0);
+	master = ecrt_request_master(index);
 	if (!master) {
-		fprintf(stderr, "Failed at requesting master!\n");
+		fprintf(stderr, "Failed at requesting master %d!\n", index);
 		exit(EXIT_FAILURE);
 	}
 
@@ -805,33 +1437,77 @@ void init_master_and_domain()
 	// Startup parameters
 	startup_parameters_config();
 
-	// Configuring Domain
-	domain_startup_config(&DomainN_regs, &DomainN_length);
+	// SYNC0/SYNC1 and reference clock, period must be known by now
+	dc_startup_config();
 
-	// Create a new process data domain
-	if (!(DomainN = ecrt_master_create_domain(master))) {
-		fprintf(stderr, "Domain Creation failed!\n");
-		exit(EXIT_FAILURE);
+	// SDO requests must be created before activation
+	sdo_request_pool_config();
+
+	// Configuring Domains
+	if (domain_configs.empty()) {
+		domain_configs.push_back({ .name = "default", .divisor = 1 });
 	}
 
-	if (ecrt_domain_reg_pdo_entry_list(DomainN, DomainN_regs)) {
-		fprintf(stderr, "PDO entry registration failed!\n");
-		exit(EXIT_FAILURE);
+	for (const ecat_domain_config_al& config : domain_configs) {
+		domains.push_back({ .name = config.name, .divisor = config.divisor });
+	}
+
+	domain_startup_config(&DomainN_length);
+
+	// empty domains are not created, they would only add empty datagrams.
+	// IOs refer to domains by index, remap them to the remaining ones
+	std::vector<struct domain_s> used;
+	std::vector<uint8_t> remapped(domains.size(), 0);
+
+	for (uint8_t idx = 0; idx < domains.size(); idx++) {
+		if (!domains[idx].length) {
+			free(domains[idx].regs);
+			continue;
+		}
+
+		remapped[idx] = used.size();
+		used.push_back(domains[idx]);
+	}
+
+	domains.swap(used);
+
+	for (ecat_slave_entry_al& io : IOs) {
+		io.domain = remapped[io.domain];
+	}
+
+	// Create a new process data domain for each configured one
+	for (struct domain_s& dmn : domains) {
+		if (!(dmn.domain = ecrt_master_create_domain(master))) {
+			fprintf(stderr, "Domain '%s' Creation failed!\n", dmn.name.c_str());
+			exit(EXIT_FAILURE);
+		}
+
+		if (ecrt_domain_reg_pdo_entry_list(dmn.domain, dmn.regs)) {
+			fprintf(stderr, "PDO entry registration failed!\n");
+			exit(EXIT_FAILURE);
+		}
 	}
 
 #if VERBOSE > 0
 	for (ecat_size_io_al dmn_idx = 0; dmn_idx < DomainN_length; dmn_idx++) {
 		printf("  > Domain %3d: Slave %2d 0x%04x:%02x offset %3d, bitpos %2d, "
-			   "%s\n",
+			   "%s (%s)\n",
 			dmn_idx, IOs[dmn_idx].position, IOs[dmn_idx].index,
 			IOs[dmn_idx].subindex, IOs[dmn_idx].offset,
 			IOs[dmn_idx].bit_position,
-			IOs[dmn_idx].direction % 2 ? "OUT" : "IN");
+			IOs[dmn_idx].direction % 2 ? "OUT" : "IN",
+			domains[IOs[dmn_idx].domain].name.c_str());
 	}
 #endif
 
-	// free allocated memories from startup configurations
-	free(DomainN_regs);
+	// offsets are known after registration, compile the cyclic IO routines
+	for (uint8_t idx = 0; idx < domains.size(); idx++) {
+		IOPlan::build(IOs, &domains[idx].io_plan, idx);
+
+		// free allocated memories from startup configurations
+		free(domains[idx].regs);
+		domains[idx].regs = nullptr;
+	}
 	slave_entries.clear();
 	startup_parameters.clear();
 
@@ -842,23 +1518,50 @@ void init_master_and_domain()
 	fprintf(stdout, "\nMaster & Domain have been initialized.\n");
 	fprintf(stdout, "Number of Slaves : %3ld\n", slaves.size());
 	fprintf(stdout, "Number of Domains: %3d\n", DomainN_length);
+	for (const struct domain_s& dmn : domains) {
+		fprintf(stdout, "  > %s: %d IO(s), every %d cycle(s)\n",
+			dmn.name.c_str(), dmn.length, dmn.divisor);
+	}
 #endif
 
 	is_master_ready = true;
 }
 
-void init()
+void Master::init()
 {
-	init_slaves();
+	// slaves are parsed from JSON by init_master_and_domain() when needed
 	init_master_and_domain();
 }
 
-void activate_master()
+void Master::activate_master()
 {
 
 #if VERBOSE > 0
 	fprintf(stdout, "\nActivating master...\n");
 #endif
+	// nothing of a previous run is carried over into skipped domains
+	inputs_carry = false;
+
+	// DC start times are derived from application time at activation
+	dc_time_base = 0;
+	dc_cycle_adjust = 0;
+	dc_diff_ns = 0;
+	dc_prev_diff_ns = 0;
+	dc_diff_total_ns = 0;
+	dc_delta_total_ns = 0;
+	dc_filter_idx = 0;
+	dc_adjust_ns = 0;
+	dc_started = false;
+
+	if (!dc_configs.empty()) {
+		struct timespec now;
+		clock_gettime(CLOCK_MONOTONIC, &now);
+
+		dc_app_time = Timespec::to_ns(now);
+		dc_prev_app_time = dc_app_time;
+		ecrt_master_application_time(master, dc_app_time);
+	}
+
 	if (ecrt_master_activate(master)) {
 		fprintf(stderr, "Master Activation failed!\n");
 		exit(EXIT_FAILURE);
@@ -867,134 +1570,469 @@ void activate_master()
 #if VERBOSE > 0
 	fprintf(stdout, "\nInitializing Domain data...\n");
 #endif
-	if (!(DomainN_pd = ecrt_domain_data(DomainN))) {
-		fprintf(stderr, "Domain data initialization failed!\n");
-		exit(EXIT_FAILURE);
+	for (struct domain_s& dmn : domains) {
+		if (!(dmn.pd = ecrt_domain_data(dmn.domain))) {
+			fprintf(stderr, "Domain data initialization failed!\n");
+			exit(EXIT_FAILURE);
+		}
+
+		dmn.size = ecrt_domain_size(dmn.domain);
 	}
+
+	cycle_counter = 0;
 }
 
-void set_frequency(uint32_t hz)
+void Master::set_frequency(uint32_t hz)
 {
 	frequency = hz;
 	period_ns = NSEC_PER_SEC / hz;
 }
 
-void set_period(uint32_t ns)
+void Master::set_period(uint32_t ns)
 {
 	period_ns = ns;
 	frequency = NSEC_PER_SEC / ns;
 }
 
-void set_period_us(uint32_t us)
+void Master::set_period_us(uint32_t us)
 {
 	set_period(us * 1'000);
 }
 
-void set_period_ms(uint32_t ms)
+void Master::set_period_ms(uint32_t ms)
 {
 	set_period(ms * 1'000'000);
 }
 
-uint16_t get_frequency()
+uint16_t Master::get_frequency()
 {
 	return frequency;
 }
 
-uint32_t get_period()
+uint32_t Master::get_period()
 {
 	return period_ns;
 }
 
-void attach_process_data(ecat_entries_al** ptr)
+void Master::attach_process_data(ecat_entries_al** ptr)
 {
 	*ptr = &IOs;
 }
 
-void attach_mapped_domain(ecat_domain_map_al** ptr)
+std::string Master::domain_name(const uint8_t& domain)
 {
-	*ptr = &mapped_domains;
+	return domain < domains.size() ? domains[domain].name : "";
 }
 
-void prerun_routine()
+void Master::attach_mapped_domain(ecat_domain_map_al** ptr)
 {
-	if (!is_master_ready) init_master_and_domain();
-
-	// activate master and initialize domain data
-	activate_master();
+	*ptr = &mapped_domains;
 }
 
-void postrun_routine()
+void Master::set_output_refresh(uint32_t cycles)
 {
-	ecrt_master_deactivate(master);
+	output_refresh_cycles.store(cycles, std::memory_order_relaxed);
+	output_refresh_counter.store(cycles, std::memory_order_relaxed);
+}
 
-#if VERBOSE > 0
-	timespec_get(&epoch, TIME_UTC);
-	fprintf(stdout, "%ld.%09ld | Waiting for master deactivation...\n",
-		epoch.tv_sec, epoch.tv_nsec);
-#endif
+void Master::set_dc_drift_compensation(bool enable)
+{
+	dc_follow_reference = enable;
+}
 
-	// wait until OP bit is reset after deactivation
-	while (is_operational.master) {
-		// update master state
-		check_master_state(master);
-		delay_ns(500'000);
-	}
+void Master::set_application_time(const uint64_t& ns)
+{
+	dc_prev_app_time = dc_app_time;
+	dc_app_time = ns + dc_time_base;
+}
 
-	reset_global_vars();
-	ecrt_release_master(master);
+int64_t Master::dc_wakeup_adjust()
+{
+	// application time ahead of the reference clock, next wakeup comes
+	// later by the correction, which is taken off the time base as well
+	int64_t adjust = dc_cycle_adjust;
+	dc_cycle_adjust = 0;
 
-#if VERBOSE > 0
-	timespec_get(&epoch, TIME_UTC);
-	fprintf(stdout, "%ld.%09ld | Stopped.\n", epoch.tv_sec, epoch.tv_nsec);
-#endif
+	return adjust;
 }
 
-bool operational_status()
+void Master::dc_report(ecat_dc_report_al* report)
 {
-	return is_operational.slaves && is_operational.master;
+	report->enabled = !dc_configs.empty();
+	report->follow_reference = dc_follow_reference;
+	report->reference_position = dc_reference_position;
+	report->diff_ns = dc_diff_report.load(std::memory_order_relaxed);
+	report->adjust_ns = dc_adjust_report.load(std::memory_order_relaxed);
 }
 
-uint8_t application_layer_states()
+void Master::set_memory_lock(bool enable)
 {
-	return master_state.al_states;
+	lock_memory = enable;
 }
 
-int8_t domain_write(const ecat_pos_al& s_position, const ecat_index_al& s_index,
-	const ecat_sub_al& s_subindex, const ecat_value_al& value)
+void Master::memory_report(ecat_memory_report_al* report)
 {
-	if (!(master_state.al_states & EC_AL_STATE_OP)) {
-		fprintf(stderr, "Master is not OP!\n");
-		return -1;
+	{
+		std::lock_guard<std::mutex> lock(memory_report_lock);
+		*report = memory_startup;
 	}
 
-	ecat_size_io_al dmn_idx;
-	if (get_domain_index(&dmn_idx, s_position, s_index, s_subindex) < 0) {
-		return -1;
-	}
+	report->minor_faults_loop
+		= minor_faults_loop.load(std::memory_order_relaxed);
+	report->major_faults_loop
+		= major_faults_loop.load(std::memory_order_relaxed);
+}
 
-	IOs[dmn_idx].written_value = value;
+void Master::attach_process_image(
+	ecat_image_value_al* image, const ecat_size_io_al& length)
+{
+	process_image = image;
+	process_image_length = image ? length : 0;
+}
 
-	return 0;
+void Master::detach_process_image()
+{
+	process_image = nullptr;
+	process_image_length = 0;
+	carry_image = nullptr;
 }
 
-int8_t domain_read(const ecat_pos_al& s_position, const ecat_index_al& s_index,
-	const ecat_sub_al& s_subindex, ecat_value_al* value)
+void Master::prerun_routine()
 {
-	if (!(master_state.al_states & EC_AL_STATE_OP)) {
+	if (!is_master_ready) init_master_and_domain();
+
+	// activate master and initialize domain data
+	activate_master();
+
+	axes_frozen.store(true, std::memory_order_release);
+	axis_resolve();
+
+	{
+		std::lock_guard<std::mutex> lock(record_lock);
+
+		// recording requested while stopped
+		if (!record_path.empty()) {
+			record_open();
+		}
+
+		cyclic_running.store(true, std::memory_order_release);
+	}
+
+	// every buffer touched by the cycle is allocated and written by now,
+	// locking keeps all of them resident
+	memory_locked = false;
+	if (lock_memory) {
+		std::lock_guard<std::mutex> lock(masters_lock);
+
+		if (mlockall(MCL_CURRENT | MCL_FUTURE) == -1) {
+			perror("mlockall failed");
+		} else {
+			memory_locked = true;
+			memory_lock_count++;
+		}
+	}
+
+	stack_prefault();
+
+	uint64_t locked_bytes = read_locked_bytes();
+	minor_faults_loop = 0;
+	major_faults_loop = 0;
+
+	// faults from here on happen inside the cyclic loop
+	getrusage(RUSAGE_THREAD, &rusage_startup);
+
+	{
+		std::lock_guard<std::mutex> lock(memory_report_lock);
+		memory_startup.locked = memory_locked;
+		memory_startup.locked_bytes = locked_bytes;
+		memory_startup.minor_faults_startup = rusage_startup.ru_minflt;
+		memory_startup.major_faults_startup = rusage_startup.ru_majflt;
+	}
+
+	if (lock_memory) {
+		fprintf(stdout,
+			"Memory locked %s, %" PRIu64 " bytes | page faults until start: "
+			"minor %jd, major %jd\n",
+			memory_locked ? "yes" : "no", locked_bytes,
+			(intmax_t)rusage_startup.ru_minflt,
+			(intmax_t)rusage_startup.ru_majflt);
+	}
+}
+
+void Master::postrun_routine()
+{
+	// queued SDO requests will never be serviced
+	sdo_request_cancel();
+
+	{
+		std::lock_guard<std::mutex> lock(record_lock);
+
+		cyclic_running.store(false, std::memory_order_release);
+		record_close();
+	}
+
+	axes_frozen.store(false, std::memory_order_release);
+
+	sample_page_faults();
+
+	if (memory_locked) {
+		std::lock_guard<std::mutex> lock(masters_lock);
+
+		if (!--memory_lock_count) {
+			munlockall();
+		}
+		memory_locked = false;
+
+		std::lock_guard<std::mutex> report_lock(memory_report_lock);
+		memory_startup.locked = false;
+	}
+
+	ecrt_master_deactivate(master);
+
+#if VERBOSE > 0
+	timespec_get(&epoch, TIME_UTC);
+	fprintf(stdout, "%ld.%09ld | Waiting for master deactivation...\n",
+		epoch.tv_sec, epoch.tv_nsec);
+#endif
+
+	// wait until OP bit is reset after deactivation
+	while (is_operational.master) {
+		// update master state
+		check_master_state(master);
+		delay_ns(500'000);
+	}
+
+	reset_global_vars();
+	ecrt_release_master(master);
+
+#if VERBOSE > 0
+	timespec_get(&epoch, TIME_UTC);
+	fprintf(stdout, "%ld.%09ld | Stopped.\n", epoch.tv_sec, epoch.tv_nsec);
+#endif
+}
+
+bool Master::operational_status()
+{
+	return is_operational.slaves && is_operational.master;
+}
+
+uint8_t Master::application_layer_states()
+{
+	return master_state.al_states;
+}
+
+ecat_size_io_al Master::domain_resolve(const ecat_pos_al& s_position,
+	const ecat_index_al& s_index, const ecat_sub_al& s_subindex)
+{
+	ecat_size_io_al dmn_idx;
+	if (get_domain_index(&dmn_idx, s_position, s_index, s_subindex) < 0) {
+		return -1;
+	}
+
+	return dmn_idx;
+}
+
+int8_t Master::domain_write(const ecat_pos_al& s_position, const ecat_index_al& s_index,
+	const ecat_sub_al& s_subindex, const ecat_value_al& value)
+{
+	ecat_size_io_al dmn_idx;
+	if (get_domain_index(&dmn_idx, s_position, s_index, s_subindex) < 0) {
+		fprintf(stderr, "Error: Index not found for pos %2d 0x%04x:%02x\n",
+			s_position, s_index, s_subindex);
+		return -1;
+	}
+
+	return domain_write(dmn_idx, value);
+}
+
+int8_t Master::domain_write(const ecat_size_io_al& handle, const ecat_value_al& value)
+{
+	if (!(master_state.al_states & EC_AL_STATE_OP)) {
 		fprintf(stderr, "Master is not OP!\n");
 		return -1;
 	}
 
+	if (handle < 0 || handle >= DomainN_length) {
+		return -1;
+	}
+
+	ecat_size_io_al dmn_idx = handle;
+	output_staging.values[dmn_idx] = value.u64;
+	IOPlan::mark_dirty(output_staging.dirty.data(), dmn_idx);
+
+	// single write outside of a batch is committed immediately
+	if (!is_writing) {
+		return domain_write_commit();
+	}
+
+	return 0;
+}
+
+void Master::domain_write_begin()
+{
+	is_writing = true;
+}
+
+int8_t Master::domain_write_commit()
+{
+	is_writing = false;
+
+	struct output_image_s& outputs = output_image.back();
+
+	// dirty bits of a publication which might be overwritten before cyclic
+	// thread takes it are carried into the next one
+	bool carry_dirty = output_image.pending();
+	size_t dirty_size = output_staging.dirty.size();
+	uint8_t slot = output_image.back_index();
+
+	for (size_t word_idx = 0; word_idx < dirty_size; word_idx++) {
+		uint64_t written = output_staging.dirty[word_idx];
+		uint64_t dirty = written;
+
+		if (carry_dirty) {
+			dirty |= output_unconsumed_dirty[word_idx];
+		}
+
+		outputs.dirty[word_idx] = dirty;
+		output_unconsumed_dirty[word_idx] = dirty;
+		output_staging.dirty[word_idx] = 0;
+
+		// back slot misses what was written while other slots were back
+		uint64_t bits = written | output_stale[slot][word_idx];
+		output_stale[slot][word_idx] = 0;
+
+		for (uint8_t other = 0; other < 3; other++) {
+			if (other != slot) {
+				output_stale[other][word_idx] |= written;
+			}
+		}
+
+		while (bits) {
+			size_t idx = (word_idx << 6) + __builtin_ctzll(bits);
+			bits &= bits - 1;
+
+			outputs.values[idx] = output_staging.values[idx];
+		}
+	}
+
+	output_image.publish();
+
+	return 0;
+}
+
+int8_t Master::domain_read(const ecat_pos_al& s_position, const ecat_index_al& s_index,
+	const ecat_sub_al& s_subindex, ecat_value_al* value)
+{
 	ecat_size_io_al dmn_idx;
 	if (get_domain_index(&dmn_idx, s_position, s_index, s_subindex) < 0) {
+		fprintf(stderr, "Error: Index not found for pos %2d 0x%04x:%02x\n",
+			s_position, s_index, s_subindex);
+		return -1;
+	}
+
+	return domain_read(dmn_idx, value);
+}
+
+int8_t Master::domain_read(const ecat_size_io_al& handle, ecat_value_al* value)
+{
+	if (!(master_state.al_states & EC_AL_STATE_OP)) {
+		fprintf(stderr, "Master is not OP!\n");
 		return -1;
 	}
 
-	*value = IOs[dmn_idx].value;
+	if (handle < 0 || handle >= DomainN_length) {
+		return -1;
+	}
+
+	ecat_size_io_al dmn_idx = handle;
+
+	// inside a batch, every read comes from the same cycle
+	if (!is_reading) {
+		input_image.update();
+	}
+
+	value->u64 = input_image.front()[dmn_idx];
+
+	return 0;
+}
+
+int8_t Master::domain_write_many(const ecat_size_io_al* handles,
+	const size_t& count, const uint64_t* raw)
+{
+	if (!(master_state.al_states & EC_AL_STATE_OP)) {
+		fprintf(stderr, "Master is not OP!\n");
+		return -1;
+	}
+
+	// batch is applied as a whole or not at all
+	for (size_t idx = 0; idx < count; idx++) {
+		if (handles[idx] < 0 || handles[idx] >= DomainN_length) {
+			return -1;
+		}
+	}
+
+	for (size_t idx = 0; idx < count; idx++) {
+		output_staging.values[handles[idx]] = raw[idx];
+		IOPlan::mark_dirty(output_staging.dirty.data(), handles[idx]);
+	}
+
+	if (!is_writing) {
+		return domain_write_commit();
+	}
+
+	return 0;
+}
+
+int8_t Master::domain_read_many(
+	const ecat_size_io_al* handles, const size_t& count, uint64_t* raw)
+{
+	if (!(master_state.al_states & EC_AL_STATE_OP)) {
+		fprintf(stderr, "Master is not OP!\n");
+		return -1;
+	}
+
+	for (size_t idx = 0; idx < count; idx++) {
+		if (handles[idx] < 0 || handles[idx] >= DomainN_length) {
+			return -1;
+		}
+	}
+
+	// every value in a batch comes from the same cycle
+	if (!is_reading) {
+		input_image.update();
+	}
+
+	const ecat_raw_image_al& inputs = input_image.front();
+
+	for (size_t idx = 0; idx < count; idx++) {
+		raw[idx] = inputs[handles[idx]];
+	}
 
 	return 0;
 }
 
+void Master::domain_read_begin()
+{
+	input_image.update();
+	is_reading = true;
+}
+
+void Master::domain_read_end()
+{
+	is_reading = false;
+}
+
+std::string sdo_error_message(const uint32_t& abort_code)
+{
+	auto message = sdo_abort_message.find(abort_code);
+
+	if (message == sdo_abort_message.end()) {
+		return "Unknown abort code";
+	}
+
+	return message->second;
+}
+
 void sdo_print_abort_message(const ecat_pos_al& s_position,
 	const ecat_index_al& s_index, const ecat_sub_al& s_subindex,
 	const int32_t& retval, const uint32_t& code)
@@ -1008,138 +2046,1014 @@ void sdo_print_abort_message(const ecat_pos_al& s_position,
 	}
 }
 
-int32_t sdo_download(const ecat_pos_al& s_position,
+int32_t Master::sdo_download(const ecat_pos_al& s_position,
 	const ecat_index_al& s_index, const ecat_sub_al& s_subindex,
-	const size_t& size, uint8_t* value)
+	const size_t& size, uint8_t* value, uint32_t* abort_code)
 {
-	uint32_t abort_code;
+	uint32_t code = 0;
 	int32_t process = ecrt_master_sdo_download(
-		master, s_position, s_index, s_subindex, value, size, &abort_code);
+		master, s_position, s_index, s_subindex, value, size, &code);
 
 	if (process) {
-		sdo_print_abort_message(
-			s_position, s_index, s_subindex, process, abort_code);
+		sdo_print_abort_message(s_position, s_index, s_subindex, process, code);
+	}
+
+	if (abort_code) {
+		*abort_code = code;
 	}
 
 	return process;
 }
 
-int32_t sdo_upload(const ecat_pos_al& s_position, const ecat_index_al& s_index,
+int32_t Master::sdo_upload(const ecat_pos_al& s_position, const ecat_index_al& s_index,
 	const ecat_sub_al& s_subindex, const size_t& size, size_t* result_size,
-	uint8_t* value)
+	uint8_t* value, uint32_t* abort_code)
 {
-	uint32_t abort_code;
+	uint32_t code = 0;
 	int32_t process = ecrt_master_sdo_upload(master, s_position, s_index,
-		s_subindex, value, size, result_size, &abort_code);
+		s_subindex, value, size, result_size, &code);
 
 	if (process) {
-		sdo_print_abort_message(
-			s_position, s_index, s_subindex, process, abort_code);
+		sdo_print_abort_message(s_position, s_index, s_subindex, process, code);
+	}
+
+	if (abort_code) {
+		*abort_code = code;
 	}
 
 	return process;
 }
 
-int8_t sdo_request(const ecat_pos_al& s_position, const ecat_index_al& s_index,
-	const ecat_sub_al& s_subindex, const uint8_t& size, void* value,
-	const sdo_req_type_al& rtype, const uint32_t& timeout)
+static int8_t sdo_size_class(const uint8_t& size)
 {
-	struct timespec start, current;
-	int64_t elapsed_ns;
-	int64_t timeout_ns = timeout * 1'000'000;
-
-	ec_slave_config_t* slave;
-	ec_slave_config_state_t* state;
+	for (uint8_t cls = 0; cls < sizeof(sdo_request_sizes); cls++) {
+		if (sdo_request_sizes[cls] == size) {
+			return cls;
+		}
+	}
 
-	// SDO Request
-	ec_sdo_request_t* sdo_req;
+	return -1;
+}
 
-	try {
-		slave = slaves.at(s_position).sc;
-		state = &slaves.at(s_position).state;
+void Master::sdo_request_pool_config()
+{
+	sdo_pool_ready = false;
 
-		ecrt_slave_config_state(slave, state);
-	} catch (const std::out_of_range& err) {
-		fprintf(stderr, "Slave pos %d doesn't exist! (max %ld)\n", s_position,
-			slaves.size());
+	// jobs submitted after last cancel, no cyclic thread is running now
+	sdo_request_cancel();
 
-		return SDO::ECAT_SDO_REQ_ERR_SLAVE_NOT_FOUND;
+	if (!sdo_completions.capacity()) {
+		sdo_completions.reserve(SDO_REQUEST_MAX_UNSETTLED);
 	}
 
-#if VERBOSE > 1
-	fprintf(stdout,
-		"%d Slave %d 0x%04x:%02x - Online %02x | OP %02x | State %02x\n", rtype,
-		s_position, s_index, s_subindex, state->online, state->operational,
-		state->al_state);
-#endif
+	sdo_slots.reset(new struct sdo_slot_s[slaves_length]);
+	sdo_slots_length = slaves_length;
 
-	// TODO: Find how Busy Request never ends once it happens.
-	// this condition is to prevent infinite Busy Request, but tbh I'm not
-	// sure why it happens. so for now, I simply prevent creating request
-	// when slave is in INIT state
-	if (state->al_state == 0x01) {
-		fprintf(stderr, "Slave %d 0x%04x:%02x is in INIT state! (%02x)\n",
-			s_position, s_index, s_subindex, state->al_state);
+	for (ecat_size_slave_al pos = 0; pos < sdo_slots_length; pos++) {
+		struct sdo_slot_s& slot = sdo_slots[pos];
 
-		return SDO::ECAT_SDO_REQ_FAILED;
-	}
+		slot.queue.reserve(SDO_REQUEST_QUEUE_DEPTH);
 
-	if (!(sdo_req = ecrt_slave_config_create_sdo_request(
-			  slave, s_index, s_subindex, size))) {
+		for (uint8_t cls = 0; cls < sizeof(sdo_request_sizes); cls++) {
+			// index is assigned per transfer
+			if (!(slot.requests[cls] = ecrt_slave_config_create_sdo_request(
+					  slaves[pos].sc, 0x1000, 0x00, sdo_request_sizes[cls]))) {
 
-		fprintf(stderr, "Failed to create SDO request!\n");
-		return -1;
+				fprintf(stderr, "Failed to create SDO request for slave %d!\n",
+					pos);
+				exit(EXIT_FAILURE);
+			}
+		}
 	}
 
-	ecrt_sdo_request_timeout(sdo_req, timeout);
+	sdo_pool_ready = true;
+}
 
-	if (rtype == ECAT_SDO_READ) {
-		ecrt_sdo_request_read(sdo_req);
-	} else {
-		// data should be set before requesting sdo write
-		memcpy(ecrt_sdo_request_data(sdo_req), value, size);
-		ecrt_sdo_request_write(sdo_req);
+void Master::sdo_request_complete(ecat_sdo_job_al& job, const int32_t& retval)
+{
+	job.retval = retval;
+
+	// never full, submission is bounded by SDO_REQUEST_MAX_UNSETTLED
+	sdo_completions.push(job);
+}
+
+void Master::sdo_request_routine()
+{
+	if (!sdo_unsettled.load(std::memory_order_acquire)) {
+		return;
 	}
 
-	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (ecat_size_slave_al pos = 0; pos < sdo_slots_length; pos++) {
+		struct sdo_slot_s& slot = sdo_slots[pos];
+
+		if (!slot.active) {
+			if (!slot.queue.pop(&slot.job)) {
+				continue;
+			}
+
+			slot.active = slot.requests[sdo_size_class(slot.job.size)];
+			ecrt_sdo_request_index(
+				slot.active, slot.job.index, slot.job.subindex);
+			ecrt_sdo_request_timeout(slot.active, slot.job.timeout);
 
-	for (;;) {
-		switch (ecrt_sdo_request_state(sdo_req)) {
+			// master aborts on timeout by itself, this is a last resort
+			// for a request which stays busy forever
+			slot.cycles_left = slot.job.timeout
+				? (uint64_t)slot.job.timeout * frequency / 1000 + frequency
+				: 0;
 
-		case EC_REQUEST_UNUSED: {
-			fprintf(stderr, "Unused request!\n");
-			// request was not used yet, trigger request
-			if (rtype == ECAT_SDO_READ) {
-				ecrt_sdo_request_read(sdo_req);
+			if (slot.job.rtype == ECAT_SDO_READ) {
+				ecrt_sdo_request_read(slot.active);
 			} else {
-				ecrt_sdo_request_write(sdo_req);
+				memcpy(ecrt_sdo_request_data(slot.active), slot.job.value.bytes,
+					slot.job.size);
+				ecrt_sdo_request_write(slot.active);
 			}
-		} break;
 
-		case EC_REQUEST_BUSY: {
-			// there's possibility the loop stuck in busy state
-			// limit the loop with the timeout
-			clock_gettime(CLOCK_MONOTONIC, &current);
-			Timespec::diff(current, start, &elapsed_ns);
+			continue;
+		}
+
+		ec_request_state_t state = ecrt_sdo_request_state(slot.active);
 
-			if (elapsed_ns > timeout_ns) {
+		if (state == EC_REQUEST_BUSY) {
+			if (slot.cycles_left && !--slot.cycles_left) {
 				fprintf(stderr, "Timeout waiting for Busy Request!\n");
-				return SDO::ECAT_SDO_REQ_ERR_BUSY;
+				sdo_request_complete(slot.job, SDO::ECAT_SDO_REQ_ERR_TIMEOUT);
+				slot.abandoned = true;
 			}
-		} break;
+			continue;
+		}
 
-		case EC_REQUEST_SUCCESS: {
-			if (rtype == ECAT_SDO_READ) {
-				memcpy(value, ecrt_sdo_request_data(sdo_req), size);
+		if (slot.abandoned) {
+			// late result of a job which is already reported
+		} else if (state == EC_REQUEST_SUCCESS) {
+			if (slot.job.rtype == ECAT_SDO_READ) {
+				slot.job.value.u64 = 0;
+				memcpy(slot.job.value.bytes, ecrt_sdo_request_data(slot.active),
+					std::min<size_t>(ecrt_sdo_request_data_size(slot.active),
+						slot.job.size));
 			}
-			return SDO::ECAT_SDO_REQ_SUCCESS;
-		} break;
 
-		case EC_REQUEST_ERROR: {
-			return SDO::ECAT_SDO_REQ_ERR;
-		} break;
+			sdo_request_complete(slot.job, SDO::ECAT_SDO_REQ_SUCCESS);
+		} else {
+			sdo_request_complete(slot.job, SDO::ECAT_SDO_REQ_ERR);
+		}
+
+		slot.active = nullptr;
+		slot.abandoned = false;
+	}
+}
+
+void Master::sdo_request_cancel()
+{
+	sdo_pool_ready = false;
+
+	for (ecat_size_slave_al pos = 0; pos < sdo_slots_length; pos++) {
+		struct sdo_slot_s& slot = sdo_slots[pos];
+
+		if (slot.active && !slot.abandoned) {
+			sdo_request_complete(slot.job, SDO::ECAT_SDO_REQ_FAILED);
+		}
+
+		slot.active = nullptr;
+		slot.abandoned = false;
+
+		ecat_sdo_job_al job;
+		while (slot.queue.pop(&job)) {
+			sdo_request_complete(job, SDO::ECAT_SDO_REQ_FAILED);
 		}
 	}
 }
 
+int8_t Master::sdo_request_submit(const ecat_sdo_job_al& job)
+{
+	if (!sdo_pool_ready.load(std::memory_order_acquire)
+		|| job.position >= sdo_slots_length) {
+
+		fprintf(stderr, "Slave pos %d doesn't exist! (max %d)\n", job.position,
+			sdo_slots_length);
+
+		return SDO::ECAT_SDO_REQ_ERR_SLAVE_NOT_FOUND;
+	}
+
+	if (sdo_size_class(job.size) < 0) {
+		fprintf(stderr, "Invalid SDO request size %d!\n", job.size);
+		return SDO::ECAT_SDO_REQ_FAILED;
+	}
+
+	// counted before queueing, so cyclic thread never misses it
+	if (sdo_unsettled.fetch_add(1, std::memory_order_acq_rel)
+			>= SDO_REQUEST_MAX_UNSETTLED
+		|| !sdo_slots[job.position].queue.push(job)) {
+
+		sdo_unsettled.fetch_sub(1, std::memory_order_release);
+		return SDO::ECAT_SDO_REQ_ERR_BUSY;
+	}
+
+	return SDO::ECAT_SDO_REQ_SUCCESS;
+}
+
+bool Master::sdo_request_poll(ecat_sdo_job_al* job)
+{
+	if (!sdo_completions.pop(job)) {
+		return false;
+	}
+
+	sdo_unsettled.fetch_sub(1, std::memory_order_release);
+
+	return true;
+}
+
+bool Master::sdo_request_completed()
+{
+	return !sdo_completions.empty();
+}
+
+/****************************************************************************/
+
+void Master::axis_resolve()
+{
+	for (std::unique_ptr<struct axis_s>& axis_ptr : axes) {
+		struct axis_s& axis = *axis_ptr;
+		const ecat_axis_config_al& config = axis.config;
+
+		// objects not mapped into a domain are left out, -1
+		auto resolve = [this, &config](const ecat_index_al& index) {
+			return mapped_domains.find(
+				convert_pos_index_sub(config.position, index, 0));
+		};
+
+		axis.controlword = resolve(config.controlword);
+		axis.statusword = resolve(config.statusword);
+		axis.mode_of_operation = resolve(config.mode_of_operation);
+		axis.target_position = resolve(config.target_position);
+		axis.target_velocity = resolve(config.target_velocity);
+		axis.position_actual = resolve(config.position_actual);
+
+		if (axis.controlword < 0 || axis.statusword < 0) {
+			fprintf(stderr,
+				"Axis pos %2d: controlword 0x%04x or statusword 0x%04x is "
+				"not mapped, axis is ignored\n",
+				config.position, config.controlword, config.statusword);
+		}
+
+		axis.setpoint = {};
+		axis.controlword_value = CiA402::CW_DISABLE_VOLTAGE;
+		axis.state = CiA402::NOT_READY_TO_SWITCH_ON;
+		Interpolator::reset(&axis.interpolator, 0);
+
+		ecat_segment_al stale;
+		while (axis.segments.pop(&stale)) { }
+	}
+}
+
+void Master::axis_routine()
+{
+	const uint64_t* raw = input_image.back().data();
+
+	auto write = [this](const ecat_size_io_al& idx, const uint64_t& value) {
+		if (idx < 0) {
+			return;
+		}
+
+		struct domain_s& dmn = domains[IOs[idx].domain];
+		IOPlan::encode_one(dmn.io_plan, dmn.pd, idx, value);
+	};
+
+	for (std::unique_ptr<struct axis_s>& axis_ptr : axes) {
+		struct axis_s& axis = *axis_ptr;
+
+		if (axis.controlword < 0 || axis.statusword < 0) {
+			continue;
+		}
+
+		uint16_t statusword = (uint16_t)raw[axis.statusword];
+		int32_t position_actual = axis.position_actual < 0
+			? axis.setpoint.position
+			: (int32_t)(uint32_t)raw[axis.position_actual];
+
+		CiA402::state_al state = CiA402::decode_state(statusword);
+
+		if (state == CiA402::FAULT && axis.state != CiA402::FAULT) {
+			axis.faults.store(axis.faults.load(std::memory_order_relaxed) + 1,
+				std::memory_order_relaxed);
+		}
+
+		// a reset request only applies to the fault present when it is made
+		if (state != CiA402::FAULT) {
+			axis.fault_reset.store(false, std::memory_order_relaxed);
+		}
+
+		bool fault_reset = axis.config.auto_fault_reset
+			|| axis.fault_reset.load(std::memory_order_relaxed);
+
+		axis.state = state;
+		axis.controlword_value = CiA402::next_controlword(state,
+			(axis_request_al)axis.request.load(std::memory_order_relaxed),
+			fault_reset, axis.controlword_value);
+
+		Interpolator::interpolator_al& ip = axis.interpolator;
+
+		if (state == CiA402::OPERATION_ENABLED) {
+			if (Interpolator::step(&ip, &axis.segments, period_ns,
+					axis.config.hold_deceleration)) {
+				axis.underruns.store(
+					axis.underruns.load(std::memory_order_relaxed) + 1,
+					std::memory_order_relaxed);
+				axes_underruns.store(
+					axes_underruns.load(std::memory_order_relaxed) + 1,
+					std::memory_order_relaxed);
+			}
+		} else {
+			// target follows the drive, so enabling never makes it jump
+			Interpolator::reset(&ip, position_actual);
+
+			ecat_segment_al stale;
+			while (axis.segments.pop(&stale)) { }
+		}
+
+		axis.setpoint.position = (int32_t)std::llround(ip.position);
+		axis.setpoint.velocity
+			= (int32_t)std::llround(ip.velocity * axis.config.velocity_factor);
+
+		write(axis.controlword, axis.controlword_value);
+		if (axis.config.mode >= 0) {
+			write(axis.mode_of_operation, (uint8_t)axis.config.mode);
+		}
+		write(axis.target_position, (uint32_t)axis.setpoint.position);
+		write(axis.target_velocity, (uint32_t)axis.setpoint.velocity);
+
+		axis.statusword_report.store(statusword, std::memory_order_relaxed);
+		axis.controlword_report.store(
+			axis.controlword_value, std::memory_order_relaxed);
+		axis.state_report.store(state, std::memory_order_relaxed);
+		axis.position_report.store(position_actual, std::memory_order_relaxed);
+		axis.setpoint_position_report.store(
+			axis.setpoint.position, std::memory_order_relaxed);
+		axis.setpoint_velocity_report.store(
+			axis.setpoint.velocity, std::memory_order_relaxed);
+		axis.holding_report.store(ip.holding, std::memory_order_relaxed);
+	}
+}
+
+int32_t Master::axis_add(const ecat_axis_config_al& config)
+{
+	if (axes_frozen.load(std::memory_order_acquire)) {
+		fprintf(stderr, "Axes can't be added while master is running!\n");
+		return -1;
+	}
+
+	std::unique_ptr<struct axis_s> axis(new struct axis_s);
+	axis->config = config;
+	axis->segments.reserve(AXIS_SEGMENT_QUEUE_DEPTH);
+
+	axes.push_back(std::move(axis));
+
+	return axes.size() - 1;
+}
+
+int8_t Master::axis_request(const int32_t& axis, const axis_request_al& request)
+{
+	if (axis < 0 || axis >= (int32_t)axes.size()) {
+		fprintf(stderr, "Axis %d doesn't exist!\n", axis);
+		return -1;
+	}
+
+	axes[axis]->request.store(request, std::memory_order_relaxed);
+
+	return 0;
+}
+
+int8_t Master::axis_fault_reset(const int32_t& axis)
+{
+	if (axis < 0 || axis >= (int32_t)axes.size()) {
+		fprintf(stderr, "Axis %d doesn't exist!\n", axis);
+		return -1;
+	}
+
+	axes[axis]->fault_reset.store(true, std::memory_order_relaxed);
+
+	return 0;
+}
+
+int8_t Master::axis_push(const int32_t& axis,
+	const ecat_setpoint_al* setpoints, const size_t& count, size_t* pushed)
+{
+	*pushed = 0;
+
+	if (axis < 0 || axis >= (int32_t)axes.size()) {
+		fprintf(stderr, "Axis %d doesn't exist!\n", axis);
+		return -1;
+	}
+
+	SpscQueue<ecat_segment_al>& queue = axes[axis]->segments;
+	ecat_segment_al segment;
+
+	// every setpoint lasts exactly one cycle, stops at the first not fitting
+	while (*pushed < count) {
+		segment.position = setpoints[*pushed].position;
+		segment.velocity = setpoints[*pushed].velocity;
+
+		if (!queue.push(segment)) {
+			break;
+		}
+
+		(*pushed)++;
+	}
+
+	return 0;
+}
+
+int8_t Master::axis_submit(const int32_t& axis,
+	const ecat_segment_al* segments, const size_t& count, size_t* pushed)
+{
+	*pushed = 0;
+
+	if (axis < 0 || axis >= (int32_t)axes.size()) {
+		fprintf(stderr, "Axis %d doesn't exist!\n", axis);
+		return -1;
+	}
+
+	// nothing is queued if any segment is invalid
+	for (size_t idx = 0; idx < count; idx++) {
+		if (!Interpolator::validate(segments[idx])) {
+			fprintf(stderr, "Axis %d: invalid segment %zu, type %d\n", axis,
+				idx, segments[idx].type);
+			return -1;
+		}
+	}
+
+	SpscQueue<ecat_segment_al>& queue = axes[axis]->segments;
+
+	// stops at the first segment not fitting, order is kept
+	while (*pushed < count && queue.push(segments[*pushed])) {
+		(*pushed)++;
+	}
+
+	return 0;
+}
+
+int8_t Master::axis_status(const int32_t& axis, ecat_axis_status_al* status)
+{
+	if (axis < 0 || axis >= (int32_t)axes.size()) {
+		fprintf(stderr, "Axis %d doesn't exist!\n", axis);
+		return -1;
+	}
+
+	const struct axis_s& src = *axes[axis];
+
+	status->statusword = src.statusword_report.load(std::memory_order_relaxed);
+	status->controlword
+		= src.controlword_report.load(std::memory_order_relaxed);
+	status->state = src.state_report.load(std::memory_order_relaxed);
+	status->position_actual
+		= src.position_report.load(std::memory_order_relaxed);
+	status->setpoint.position
+		= src.setpoint_position_report.load(std::memory_order_relaxed);
+	status->setpoint.velocity
+		= src.setpoint_velocity_report.load(std::memory_order_relaxed);
+	status->queued = src.segments.size();
+	status->holding = src.holding_report.load(std::memory_order_relaxed);
+	status->underruns = src.underruns.load(std::memory_order_relaxed);
+	status->faults = src.faults.load(std::memory_order_relaxed);
+
+	return 0;
+}
+
+void Master::axis_clear()
+{
+	if (axes_frozen.load(std::memory_order_acquire)) {
+		fprintf(stderr, "Axes can't be removed while master is running!\n");
+		return;
+	}
+
+	axes.clear();
+}
+
+void Master::axis_freeze()
+{
+	axes_frozen.store(true, std::memory_order_release);
+}
+
+uint64_t Master::axis_underruns()
+{
+	return axes_underruns.load(std::memory_order_relaxed);
+}
+
+int8_t Master::record_open()
+{
+	Recorder::file_header_al header = {};
+	std::vector<Recorder::file_entry_al> entries;
+	uint32_t payload_size = 0;
+
+	auto describe = [this](const ecat_size_io_al& idx) {
+		const ecat_slave_entry_al& io = IOs[idx];
+
+		Recorder::file_entry_al entry = {};
+		entry.position = io.position;
+		entry.index = io.index;
+		entry.subindex = io.subindex;
+		entry.size = io.size;
+		entry.domain = io.domain;
+		entry.flags = (io.is_signed ? RECORDER_FLAG_SIGNED : 0)
+			| (io.direction == EC_DIR_OUTPUT ? RECORDER_FLAG_OUTPUT : 0);
+
+		return entry;
+	};
+
+	if (record_handles.empty()) {
+		// entries keep their place in process data, found by domain offset
+		std::vector<uint32_t> domain_offsets;
+		for (const struct domain_s& dmn : domains) {
+			domain_offsets.push_back(payload_size);
+			payload_size += dmn.size;
+		}
+
+		for (ecat_size_io_al idx = 0; idx < DomainN_length; idx++) {
+			Recorder::file_entry_al entry = describe(idx);
+			entry.payload_offset
+				= domain_offsets[IOs[idx].domain] + IOs[idx].offset;
+			entry.bit_position = IOs[idx].bit_position;
+			entry.flags |= IOs[idx].swap_endian ? RECORDER_FLAG_SWAP : 0;
+
+			entries.push_back(entry);
+		}
+	} else {
+		// decoded values, as wide as the entry
+		record_widths.clear();
+		for (const ecat_size_io_al& idx : record_handles) {
+			Recorder::file_entry_al entry = describe(idx);
+			entry.payload_offset = payload_size;
+
+			uint8_t width = IOs[idx].size < 8 ? 1 : IOs[idx].size / 8;
+			record_widths.push_back(width);
+			payload_size += width;
+
+			entries.push_back(entry);
+		}
+	}
+
+	header.record_size = sizeof(Recorder::record_header_al)
+		+ ((payload_size + 7) & ~(uint32_t)7);
+	header.period_ns = period_ns;
+	header.master_index = index;
+	header.full_image = record_handles.empty();
+
+	struct timespec now;
+	clock_gettime(CLOCK_REALTIME, &now);
+	header.start_realtime_ns = Timespec::to_ns(now);
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	header.start_monotonic_ns = Timespec::to_ns(now);
+
+	// a few seconds of cycles are buffered unless told otherwise
+	size_t ring_records = record_ring ? record_ring : 2 * frequency;
+
+	std::unique_ptr<Recorder::Recording> rec(new Recorder::Recording());
+	std::string path = record_path;
+	record_path.clear();
+
+	if (rec->open(path, header, entries, ring_records)) {
+		return -1;
+	}
+
+	recording = std::move(rec);
+	recording_active.store(recording.get(), std::memory_order_release);
+
+	return 0;
+}
+
+void Master::record_close()
+{
+	if (!recording) {
+		return;
+	}
+
+	// a record being written by the cyclic thread is finished first
+	recording_active.store(nullptr);
+	while (recording_busy.load()) {
+		std::this_thread::sleep_for(std::chrono::microseconds(100));
+	}
+
+	recording->close();
+	recording.reset();
+}
+
+void Master::record_routine()
+{
+	if (!recording_active.load(std::memory_order_relaxed)) {
+		return;
+	}
+
+	// paired with record_close(), either the recording is seen taken away
+	// or the closing thread sees busy and waits
+	recording_busy.store(true);
+	Recorder::Recording* rec = recording_active.load();
+
+	uint8_t* slot = rec ? rec->claim() : nullptr;
+	if (slot) {
+		struct timespec now;
+		clock_gettime(CLOCK_MONOTONIC, &now);
+
+		Recorder::record_header_al* header = (Recorder::record_header_al*)slot;
+		header->cycle = cycle_counter;
+		header->timestamp_ns = Timespec::to_ns(now);
+
+		uint8_t* payload = slot + sizeof(Recorder::record_header_al);
+
+		if (record_handles.empty()) {
+			for (const struct domain_s& dmn : domains) {
+				memcpy(payload, dmn.pd, dmn.size);
+				payload += dmn.size;
+			}
+		} else {
+			const uint64_t* raw = input_image.back().data();
+			size_t length = record_handles.size();
+
+			for (size_t idx = 0; idx < length; idx++) {
+				memcpy(payload, &raw[record_handles[idx]], record_widths[idx]);
+				payload += record_widths[idx];
+			}
+		}
+
+		rec->commit();
+	}
+
+	recording_busy.store(false, std::memory_order_release);
+}
+
+int8_t Master::record_start(const std::string& path,
+	const ecat_size_io_al* handles, const size_t& count,
+	const size_t& ring_records)
+{
+	std::lock_guard<std::mutex> lock(record_lock);
+
+	if (recording) {
+		fprintf(stderr, "Recording to %s is already running!\n",
+			recording->path().c_str());
+		return -1;
+	}
+
+	for (size_t idx = 0; idx < count; idx++) {
+		if (handles[idx] < 0 || handles[idx] >= DomainN_length) {
+			fprintf(stderr, "Recording: invalid handle %d\n", handles[idx]);
+			return -1;
+		}
+	}
+
+	record_path = path;
+	record_handles.assign(handles, handles + count);
+	record_ring = ring_records;
+
+	// otherwise opened by prerun_routine()
+	if (cyclic_running.load(std::memory_order_acquire)) {
+		return record_open();
+	}
+
+	return 0;
+}
+
+void Master::record_stop()
+{
+	std::lock_guard<std::mutex> lock(record_lock);
+
+	record_path.clear();
+	record_close();
+}
+
+void Master::record_report(ecat_record_report_al* report)
+{
+	std::lock_guard<std::mutex> lock(record_lock);
+
+	report->active = (bool)recording;
+	report->pending = !record_path.empty();
+
+	if (recording) {
+		report->path = recording->path();
+		report->records = recording->records();
+		report->dropped = recording->dropped();
+		report->bytes = recording->bytes();
+	} else {
+		report->path = record_path;
+		report->records = 0;
+		report->dropped = 0;
+		report->bytes = 0;
+	}
+}
+
+/****************************************************************************/
+
+Master* open_master(const uint32_t& index)
+{
+	std::lock_guard<std::mutex> lock(masters_lock);
+
+	std::unique_ptr<Master>& instance = masters[index];
+	if (!instance) {
+		instance.reset(new Master(index));
+	}
+
+	return instance.get();
+}
+
+void use_master(Master* instance)
+{
+	bound_master = instance;
+}
+
+Master* current_master()
+{
+	// threads which never chose an instance use master 0
+	if (!bound_master) {
+		bound_master = open_master(0);
+	}
+
+	return bound_master;
+}
+
+uint32_t master_index()
+{
+	return current_master()->index;
+}
+
+int8_t set_json_path(const std::string& filepath)
+{
+	return current_master()->set_json_path(filepath);
+}
+
+void set_period_ms(uint32_t milliseconds)
+{
+	current_master()->set_period_ms(milliseconds);
+}
+
+void set_period_us(uint32_t microseconds)
+{
+	current_master()->set_period_us(microseconds);
+}
+
+void set_period(uint32_t nanoseconds)
+{
+	current_master()->set_period(nanoseconds);
+}
+
+void set_frequency(uint32_t hertz)
+{
+	current_master()->set_frequency(hertz);
+}
+
+void set_output_refresh(uint32_t cycles)
+{
+	current_master()->set_output_refresh(cycles);
+}
+
+void set_dc_drift_compensation(bool enable)
+{
+	current_master()->set_dc_drift_compensation(enable);
+}
+
+void set_application_time(const uint64_t& ns)
+{
+	current_master()->set_application_time(ns);
+}
+
+int64_t dc_wakeup_adjust()
+{
+	return current_master()->dc_wakeup_adjust();
+}
+
+void dc_report(ecat_dc_report_al* report)
+{
+	current_master()->dc_report(report);
+}
+
+void set_memory_lock(bool enable)
+{
+	current_master()->set_memory_lock(enable);
+}
+
+void memory_report(ecat_memory_report_al* report)
+{
+	current_master()->memory_report(report);
+}
+
+uint16_t get_frequency()
+{
+	return current_master()->get_frequency();
+}
+
+uint32_t get_period()
+{
+	return current_master()->get_period();
+}
+
+void prerun_routine()
+{
+	current_master()->prerun_routine();
+}
+
+void main_routine()
+{
+	current_master()->main_routine();
+}
+
+void postrun_routine()
+{
+	current_master()->postrun_routine();
+}
+
+void init()
+{
+	current_master()->init();
+}
+
+bool operational_status()
+{
+	return current_master()->operational_status();
+}
+
+uint8_t application_layer_states()
+{
+	return current_master()->application_layer_states();
+}
+
+void attach_process_data(ecat_entries_al** ptr)
+{
+	current_master()->attach_process_data(ptr);
+}
+
+std::string domain_name(const uint8_t& domain)
+{
+	return current_master()->domain_name(domain);
+}
+
+void attach_mapped_domain(ecat_domain_map_al** ptr)
+{
+	current_master()->attach_mapped_domain(ptr);
+}
+
+void attach_process_image(
+	ecat_image_value_al* image, const ecat_size_io_al& length)
+{
+	current_master()->attach_process_image(image, length);
+}
+
+void detach_process_image()
+{
+	current_master()->detach_process_image();
+}
+
+int8_t domain_write(const ecat_pos_al& s_position, const ecat_index_al& s_index,
+	const ecat_sub_al& s_subindex, const ecat_value_al& value)
+{
+	return current_master()->domain_write(
+		s_position, s_index, s_subindex, value);
+}
+
+int8_t domain_read(const ecat_pos_al& s_position, const ecat_index_al& s_index,
+	const ecat_sub_al& s_subindex, ecat_value_al* value)
+{
+	return current_master()->domain_read(
+		s_position, s_index, s_subindex, value);
+}
+
+ecat_size_io_al domain_resolve(const ecat_pos_al& s_position,
+	const ecat_index_al& s_index, const ecat_sub_al& s_subindex)
+{
+	return current_master()->domain_resolve(s_position, s_index, s_subindex);
+}
+
+int8_t domain_write(const ecat_size_io_al& handle, const ecat_value_al& value)
+{
+	return current_master()->domain_write(handle, value);
+}
+
+int8_t domain_read(const ecat_size_io_al& handle, ecat_value_al* value)
+{
+	return current_master()->domain_read(handle, value);
+}
+
+int8_t domain_write_many(
+	const ecat_size_io_al* handles, const size_t& count, const uint64_t* raw)
+{
+	return current_master()->domain_write_many(handles, count, raw);
+}
+
+int8_t domain_read_many(
+	const ecat_size_io_al* handles, const size_t& count, uint64_t* raw)
+{
+	return current_master()->domain_read_many(handles, count, raw);
+}
+
+void domain_write_begin()
+{
+	current_master()->domain_write_begin();
+}
+
+int8_t domain_write_commit()
+{
+	return current_master()->domain_write_commit();
+}
+
+void domain_read_begin()
+{
+	current_master()->domain_read_begin();
+}
+
+void domain_read_end()
+{
+	current_master()->domain_read_end();
+}
+
+int8_t sdo_request_submit(const ecat_sdo_job_al& job)
+{
+	return current_master()->sdo_request_submit(job);
+}
+
+bool sdo_request_poll(ecat_sdo_job_al* job)
+{
+	return current_master()->sdo_request_poll(job);
+}
+
+bool sdo_request_completed()
+{
+	return current_master()->sdo_request_completed();
+}
+
+int32_t sdo_upload(const ecat_pos_al& s_position, const ecat_index_al& s_index,
+	const ecat_sub_al& s_subindex, const size_t& size, size_t* result_size,
+	uint8_t* value, uint32_t* abort_code)
+{
+	return current_master()->sdo_upload(s_position, s_index, s_subindex, size,
+		result_size, value, abort_code);
+}
+
+int32_t sdo_download(const ecat_pos_al& s_position,
+	const ecat_index_al& s_index, const ecat_sub_al& s_subindex,
+	const size_t& size, uint8_t* value, uint32_t* abort_code)
+{
+	return current_master()->sdo_download(
+		s_position, s_index, s_subindex, size, value, abort_code);
+}
+
+int32_t axis_add(const ecat_axis_config_al& config)
+{
+	return current_master()->axis_add(config);
+}
+
+int8_t axis_request(const int32_t& axis, const axis_request_al& request)
+{
+	return current_master()->axis_request(axis, request);
+}
+
+int8_t axis_fault_reset(const int32_t& axis)
+{
+	return current_master()->axis_fault_reset(axis);
+}
+
+int8_t axis_push(const int32_t& axis, const ecat_setpoint_al* setpoints,
+	const size_t& count, size_t* pushed)
+{
+	return current_master()->axis_push(axis, setpoints, count, pushed);
+}
+
+int8_t axis_status(const int32_t& axis, ecat_axis_status_al* status)
+{
+	return current_master()->axis_status(axis, status);
+}
+
+int8_t axis_submit(const int32_t& axis, const ecat_segment_al* segments,
+	const size_t& count, size_t* pushed)
+{
+	return current_master()->axis_submit(axis, segments, count, pushed);
+}
+
+void axis_clear()
+{
+	current_master()->axis_clear();
+}
+
+void axis_freeze()
+{
+	current_master()->axis_freeze();
+}
+
+uint64_t axis_underruns()
+{
+	return current_master()->axis_underruns();
+}
+
+int8_t record_start(const std::string& path, const ecat_size_io_al* handles,
+	const size_t& count, const size_t& ring_records)
+{
+	return current_master()->record_start(path, handles, count, ring_records);
+}
+
+void record_stop()
+{
+	current_master()->record_stop();
+}
+
+void record_report(ecat_record_report_al* report)
+{
+	current_master()->record_report(report);
+}
+
 }
@@ -0,0 +1,287 @@
+#include <algorithm>
+#include <cmath>
+
+#include "interpolator.h"
+
+#define NSEC_PER_SEC 1000000000
+
+namespace Interpolator {
+
+using EcatHelper::ecat_segment_al;
+
+/**
+ * Rest-to-rest S-curve, i.e. jerk phases +J, 0, -J, cruise, -J, 0, +J.
+ * Peak velocity and acceleration are lowered when distance is too short
+ * to reach them.
+ */
+static void plan_move(interpolator_al* ip)
+{
+	const ecat_segment_al& seg = ip->segment;
+
+	double distance = seg.position - ip->start_position;
+	double dir = distance < 0 ? -1 : 1;
+	double d = std::fabs(distance);
+
+	double v = seg.max_velocity;
+	double a = seg.max_acceleration;
+	double j = seg.max_jerk;
+
+	// time with jerk applied (tj) and whole acceleration (ta)
+	double tj, ta, tv;
+
+	if (v * j >= a * a) {
+		tj = a / j;
+		ta = v / a + tj;
+	} else {
+		tj = std::sqrt(v / j);
+		ta = 2 * tj;
+	}
+
+	if (d < v * ta) {
+		// peak velocity not reached, d = v * ta solved for v
+		v = a * (std::sqrt(a * a / (j * j) + 4 * d / a) - a / j) / 2;
+
+		if (v * j >= a * a) {
+			tj = a / j;
+			ta = v / a + tj;
+		} else {
+			tj = std::cbrt(d / (2 * j));
+			ta = 2 * tj;
+		}
+
+		tv = 0;
+	} else {
+		tv = (d - v * ta) / v;
+	}
+
+	const double durations[INTERPOLATOR_MOVE_PHASES]
+		= { tj, ta - 2 * tj, tj, tv, tj, ta - 2 * tj, tj };
+	const double jerks[INTERPOLATOR_MOVE_PHASES] = { j, 0, -j, 0, -j, 0, j };
+
+	double p = ip->start_position, vel = 0, acc = 0, t = 0;
+
+	for (uint8_t idx = 0; idx < INTERPOLATOR_MOVE_PHASES; idx++) {
+		double dt = std::max(durations[idx], 0.0);
+		double jerk = dir * jerks[idx];
+
+		ip->phase_time[idx] = t;
+		ip->phase_jerk[idx] = jerk;
+		ip->phase_position[idx] = p;
+		ip->phase_velocity[idx] = vel;
+		ip->phase_acceleration[idx] = acc;
+
+		p += vel * dt + acc * dt * dt / 2 + jerk * dt * dt * dt / 6;
+		vel += acc * dt + jerk * dt * dt / 2;
+		acc += jerk * dt;
+		t += dt;
+	}
+
+	ip->phase_time[INTERPOLATOR_MOVE_PHASES] = t;
+	ip->duration_ns = std::llround(t * NSEC_PER_SEC);
+}
+
+static void begin(interpolator_al* ip, const ecat_segment_al& segment,
+	const uint32_t& period_ns)
+{
+	ip->segment = segment;
+	ip->start_position = ip->position;
+	ip->start_velocity = ip->velocity;
+	ip->active = true;
+	ip->holding = false;
+
+	switch (segment.type) {
+	case EcatHelper::ECAT_SEGMENT_SETPOINT: {
+		ip->duration_ns = period_ns;
+	} break;
+
+	case EcatHelper::ECAT_SEGMENT_MOVE: {
+		// moves start from standstill
+		ip->start_velocity = 0;
+		plan_move(ip);
+	} break;
+
+	default: {
+		ip->duration_ns = segment.duration_ns;
+	} break;
+	}
+}
+
+static void evaluate_move(interpolator_al* ip, const double& t)
+{
+	uint8_t idx = INTERPOLATOR_MOVE_PHASES - 1;
+	while (idx && t < ip->phase_time[idx]) {
+		idx--;
+	}
+
+	double dt = t - ip->phase_time[idx];
+	double acc = ip->phase_acceleration[idx];
+	double jerk = ip->phase_jerk[idx];
+
+	ip->position = ip->phase_position[idx] + ip->phase_velocity[idx] * dt
+		+ acc * dt * dt / 2 + jerk * dt * dt * dt / 6;
+	ip->velocity = ip->phase_velocity[idx] + acc * dt + jerk * dt * dt / 2;
+}
+
+// state at t ns into active segment
+static void evaluate(interpolator_al* ip, const int64_t& t_ns)
+{
+	const ecat_segment_al& seg = ip->segment;
+	double span = (double)seg.position - ip->start_position;
+
+	switch (seg.type) {
+	case EcatHelper::ECAT_SEGMENT_SETPOINT: {
+		ip->position = seg.position;
+
+		// velocity feed forward, derived from position if not given
+		ip->velocity = seg.velocity
+			? (double)seg.velocity
+			: span * NSEC_PER_SEC / ip->duration_ns;
+	} break;
+
+	case EcatHelper::ECAT_SEGMENT_LINEAR: {
+		ip->position = ip->start_position + span * t_ns / ip->duration_ns;
+		ip->velocity = span * NSEC_PER_SEC / ip->duration_ns;
+	} break;
+
+	case EcatHelper::ECAT_SEGMENT_PVT: {
+		// cubic Hermite between start and end position/velocity
+		double T = (double)ip->duration_ns / NSEC_PER_SEC;
+		double s = (double)t_ns / ip->duration_ns;
+		double s2 = s * s, s3 = s2 * s;
+
+		double p0 = ip->start_position, v0 = ip->start_velocity * T;
+		double p1 = seg.position, v1 = seg.velocity * T;
+
+		ip->position = (2 * s3 - 3 * s2 + 1) * p0 + (s3 - 2 * s2 + s) * v0
+			+ (-2 * s3 + 3 * s2) * p1 + (s3 - s2) * v1;
+		ip->velocity = ((6 * s2 - 6 * s) * p0 + (3 * s2 - 4 * s + 1) * v0
+						   + (-6 * s2 + 6 * s) * p1 + (3 * s2 - 2 * s) * v1)
+			/ T;
+	} break;
+
+	case EcatHelper::ECAT_SEGMENT_MOVE: {
+		evaluate_move(ip, (double)t_ns / NSEC_PER_SEC);
+	} break;
+	}
+}
+
+// exact end state, free of rounding of evaluate()
+static void finish(interpolator_al* ip)
+{
+	const ecat_segment_al& seg = ip->segment;
+
+	ip->position = seg.position;
+
+	switch (seg.type) {
+	case EcatHelper::ECAT_SEGMENT_PVT: {
+		ip->velocity = seg.velocity;
+	} break;
+
+	case EcatHelper::ECAT_SEGMENT_MOVE: {
+		ip->velocity = 0;
+	} break;
+
+	default:
+		// keeps velocity of last evaluation
+		break;
+	}
+
+	ip->active = false;
+}
+
+bool validate(const ecat_segment_al& segment)
+{
+	switch (segment.type) {
+	case EcatHelper::ECAT_SEGMENT_SETPOINT: {
+		return true;
+	} break;
+
+	case EcatHelper::ECAT_SEGMENT_LINEAR:
+	case EcatHelper::ECAT_SEGMENT_PVT: {
+		return segment.duration_ns > 0;
+	} break;
+
+	case EcatHelper::ECAT_SEGMENT_MOVE: {
+		return segment.max_velocity > 0 && segment.max_acceleration > 0
+			&& segment.max_jerk > 0;
+	} break;
+
+	default: {
+		return false;
+	} break;
+	}
+}
+
+void reset(interpolator_al* ip, const double& position)
+{
+	ip->position = position;
+	ip->velocity = 0;
+	ip->active = false;
+	ip->elapsed_ns = 0;
+	ip->holding = false;
+}
+
+bool step(interpolator_al* ip, SpscQueue<ecat_segment_al>* queue,
+	const uint32_t& period_ns, const double& hold_deceleration)
+{
+	// time into active segment at the end of this cycle
+	int64_t t = ip->elapsed_ns + period_ns;
+
+	while (true) {
+		if (ip->active) {
+			if (t <= ip->duration_ns) {
+				ip->elapsed_ns = t;
+				evaluate(ip, t);
+
+				return false;
+			}
+
+			t -= ip->duration_ns;
+			finish(ip);
+		}
+
+		ecat_segment_al segment;
+		if (!queue->pop(&segment)) {
+			break;
+		}
+
+		begin(ip, segment, period_ns);
+	}
+
+	// queue ran dry, a new segment starts at the end of this cycle
+	ip->elapsed_ns = 0;
+
+	// linear and setpoint segments end on their last queued point, only a
+	// pvt ending in motion is ramped down
+	if (ip->segment.type == EcatHelper::ECAT_SEGMENT_LINEAR
+		|| ip->segment.type == EcatHelper::ECAT_SEGMENT_SETPOINT) {
+
+		ip->velocity = 0;
+	}
+
+	if (ip->velocity == 0) {
+		return false;
+	}
+
+	bool underrun = !ip->holding;
+	ip->holding = true;
+
+	double dt = (double)period_ns / NSEC_PER_SEC;
+	double dv = hold_deceleration * dt;
+
+	if (hold_deceleration <= 0) {
+		// stop at once, commanded position stays where it was
+		ip->velocity = 0;
+	} else if (std::fabs(ip->velocity) <= dv) {
+		ip->position += ip->velocity * dt / 2;
+		ip->velocity = 0;
+	} else {
+		double velocity = ip->velocity - (ip->velocity > 0 ? dv : -dv);
+		ip->position += (ip->velocity + velocity) * dt / 2;
+		ip->velocity = velocity;
+	}
+
+	return underrun;
+}
+
+}
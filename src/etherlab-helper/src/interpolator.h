@@ -0,0 +1,61 @@
+#ifndef _ECAT_HELPER_INTERPOLATOR_H_
+#define _ECAT_HELPER_INTERPOLATOR_H_
+
+#include <etherlab-helper.h>
+#include <SpscQueue.hpp>
+
+namespace Interpolator {
+
+/** Phases of a jerk-limited move, jerk is constant within each of them */
+#define INTERPOLATOR_MOVE_PHASES 7
+
+/**
+ * Per-cycle setpoint generator of one axis. Position is in counts, velocity
+ * in counts/s. Segments continue from the commanded position of the
+ * previous one, time left over when a segment ends is carried into the next
+ * one so the trajectory never drifts against the cycle.
+ */
+typedef struct interpolator_s {
+	// commanded at the end of current cycle
+	double position = 0;
+	double velocity = 0;
+
+	// segment being interpolated
+	bool active = false;
+	EcatHelper::ecat_segment_al segment;
+	double start_position = 0;
+	double start_velocity = 0;
+	int64_t elapsed_ns = 0;
+	int64_t duration_ns = 0;
+
+	// jerk-limited move, start time in s and state at start of each phase
+	double phase_time[INTERPOLATOR_MOVE_PHASES + 1] = {};
+	double phase_jerk[INTERPOLATOR_MOVE_PHASES] = {};
+	double phase_position[INTERPOLATOR_MOVE_PHASES] = {};
+	double phase_velocity[INTERPOLATOR_MOVE_PHASES] = {};
+	double phase_acceleration[INTERPOLATOR_MOVE_PHASES] = {};
+
+	// buffer ran dry while moving, axis is being stopped or held
+	bool holding = false;
+} interpolator_al;
+
+/** False if segment can't be interpolated, e.g. zero duration or limits */
+bool validate(const EcatHelper::ecat_segment_al& segment);
+
+/** Drops active segment and stands still at given position */
+void reset(interpolator_al* ip, const double& position);
+
+/**
+ * Advances one cycle, taking segments from queue as needed. A trajectory
+ * ending on a linear or setpoint segment stops on its last point. When the
+ * queue runs dry after a pvt while moving, velocity is ramped down with
+ * hold_deceleration
+ * (counts/s^2, 0 stops at once) and position is held.
+ * Returns true on the cycle the underrun started.
+ */
+bool step(interpolator_al* ip, SpscQueue<EcatHelper::ecat_segment_al>* queue,
+	const uint32_t& period_ns, const double& hold_deceleration);
+
+}
+
+#endif
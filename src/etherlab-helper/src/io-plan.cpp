@@ -0,0 +1,403 @@
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <type_traits>
+
+#include "io-plan.h"
+
+namespace IOPlan {
+
+using EcatHelper::ecat_image_value_al;
+using EcatHelper::ecat_size_io_al;
+
+template <typename T> inline static T read_pd(const uint8_t* data);
+template <typename T> inline static void write_pd(uint8_t* data, T value);
+template <typename T> inline static T swap_endian(T value);
+
+template <> inline uint8_t read_pd(const uint8_t* data)
+{
+	return EC_READ_U8(data);
+}
+
+template <> inline uint16_t read_pd(const uint8_t* data)
+{
+	return EC_READ_U16(data);
+}
+
+template <> inline uint32_t read_pd(const uint8_t* data)
+{
+	return EC_READ_U32(data);
+}
+
+template <> inline uint64_t read_pd(const uint8_t* data)
+{
+	return EC_READ_U64(data);
+}
+
+template <> inline void write_pd(uint8_t* data, uint8_t value)
+{
+	EC_WRITE_U8(data, value);
+}
+
+template <> inline void write_pd(uint8_t* data, uint16_t value)
+{
+	EC_WRITE_U16(data, value);
+}
+
+template <> inline void write_pd(uint8_t* data, uint32_t value)
+{
+	EC_WRITE_U32(data, value);
+}
+
+template <> inline void write_pd(uint8_t* data, uint64_t value)
+{
+	EC_WRITE_U64(data, value);
+}
+
+template <> inline uint8_t swap_endian(uint8_t value)
+{
+	return value;
+}
+
+template <> inline uint16_t swap_endian(uint16_t value)
+{
+	return swap_endian16(value);
+}
+
+template <> inline uint32_t swap_endian(uint32_t value)
+{
+	return swap_endian32(value);
+}
+
+template <> inline uint64_t swap_endian(uint64_t value)
+{
+	return swap_endian64(value);
+}
+
+// raw value has the same memory layout as ecat_value_al's first 8 bytes
+template <typename T> inline static uint64_t to_raw(T value)
+{
+	uint64_t raw = 0;
+	memcpy(&raw, &value, sizeof(T));
+
+	return raw;
+}
+
+template <typename T> inline static T from_raw(const uint64_t& raw)
+{
+	T value;
+	memcpy(&value, &raw, sizeof(T));
+
+	return value;
+}
+
+template <typename T, bool SWAP, bool SIGNED, bool IMAGE>
+inline static void decode_loop(const io_group_al& group, const uint8_t* pd,
+	uint64_t* raw, ecat_image_value_al* image)
+{
+	typedef std::make_signed_t<T> signed_t;
+
+	const uint32_t* offsets = group.offsets.data();
+	const ecat_size_io_al* indexes = group.indexes.data();
+	size_t length = group.offsets.size();
+
+	for (size_t idx = 0; idx < length; idx++) {
+		T value = read_pd<T>(pd + offsets[idx]);
+
+		if constexpr (SWAP) {
+			value = swap_endian<T>(value);
+		}
+
+		raw[indexes[idx]] = to_raw<T>(value);
+
+		if constexpr (IMAGE) {
+			image[indexes[idx]] = SIGNED
+				? static_cast<ecat_image_value_al>(
+					static_cast<signed_t>(value))
+				: static_cast<ecat_image_value_al>(value);
+		}
+	}
+}
+
+template <typename T, bool SWAP, bool SIGNED>
+static void decode_group(const io_group_al& group, const uint8_t* pd,
+	uint64_t* raw, ecat_image_value_al* image)
+{
+	if (image) {
+		decode_loop<T, SWAP, SIGNED, true>(group, pd, raw, image);
+	} else {
+		decode_loop<T, SWAP, SIGNED, false>(group, pd, raw, image);
+	}
+}
+
+static void decode_bits(const io_group_al& group, const uint8_t* pd,
+	uint64_t* raw, ecat_image_value_al* image)
+{
+	const uint32_t* offsets = group.offsets.data();
+	const uint8_t* bit_positions = group.bit_positions.data();
+	const ecat_size_io_al* indexes = group.indexes.data();
+	size_t length = group.offsets.size();
+
+	for (size_t idx = 0; idx < length; idx++) {
+		uint8_t value = EC_READ_BIT(pd + offsets[idx], bit_positions[idx]) & 0x1;
+
+		raw[indexes[idx]] = to_raw<uint8_t>(value);
+
+		if (image) {
+			image[indexes[idx]] = value;
+		}
+	}
+}
+
+// values are written as they are, swap_endian only applies when reading
+template <typename T>
+static void encode_group(
+	const io_group_al& group, uint8_t* pd, const uint64_t* raw)
+{
+	const uint32_t* offsets = group.offsets.data();
+	const ecat_size_io_al* indexes = group.indexes.data();
+	size_t length = group.offsets.size();
+
+	for (size_t idx = 0; idx < length; idx++) {
+		write_pd<T>(pd + offsets[idx], from_raw<T>(raw[indexes[idx]]));
+	}
+}
+
+static void encode_bits(
+	const io_group_al& group, uint8_t* pd, const uint64_t* raw)
+{
+	const uint32_t* offsets = group.offsets.data();
+	const uint8_t* bit_positions = group.bit_positions.data();
+	const ecat_size_io_al* indexes = group.indexes.data();
+	size_t length = group.offsets.size();
+
+	for (size_t idx = 0; idx < length; idx++) {
+		EC_WRITE_BIT(pd + offsets[idx], bit_positions[idx],
+			from_raw<uint8_t>(raw[indexes[idx]]) & 0x1);
+	}
+}
+
+template <typename T>
+static void encode_entry(
+	uint8_t* data, const uint8_t& bit_position, const uint64_t& raw)
+{
+	write_pd<T>(data, from_raw<T>(raw));
+}
+
+static void encode_entry_bit(
+	uint8_t* data, const uint8_t& bit_position, const uint64_t& raw)
+{
+	EC_WRITE_BIT(data, bit_position, from_raw<uint8_t>(raw) & 0x1);
+}
+
+static io_encode_entry_fn select_entry_encoder(
+	const EcatHelper::ecat_slave_entry_al& entry)
+{
+	if (entry.direction != EC_DIR_OUTPUT) {
+		return nullptr;
+	}
+
+	switch (entry.size) {
+	case 1: {
+		return encode_entry_bit;
+	} break;
+
+	case 8: {
+		return encode_entry<uint8_t>;
+	} break;
+
+	case 16: {
+		return encode_entry<uint16_t>;
+	} break;
+
+	case 32: {
+		return encode_entry<uint32_t>;
+	} break;
+
+	case 64: {
+		return encode_entry<uint64_t>;
+	} break;
+
+	default: {
+		return nullptr;
+	} break;
+	}
+}
+
+template <typename T> static io_decode_fn select_decode(const io_group_al& group)
+{
+	if (group.swap_endian) {
+		return group.is_signed ? decode_group<T, true, true>
+							   : decode_group<T, true, false>;
+	}
+
+	return group.is_signed ? decode_group<T, false, true>
+						   : decode_group<T, false, false>;
+}
+
+static void assign_routines(io_group_al* group)
+{
+	switch (group->size) {
+	case 1: {
+		group->decode = decode_bits;
+		group->encode = encode_bits;
+	} break;
+
+	case 8: {
+		group->decode = select_decode<uint8_t>(*group);
+		group->encode = encode_group<uint8_t>;
+	} break;
+
+	case 16: {
+		group->decode = select_decode<uint16_t>(*group);
+		group->encode = encode_group<uint16_t>;
+	} break;
+
+	case 32: {
+		group->decode = select_decode<uint32_t>(*group);
+		group->encode = encode_group<uint32_t>;
+	} break;
+
+	case 64: {
+		group->decode = select_decode<uint64_t>(*group);
+		group->encode = encode_group<uint64_t>;
+	} break;
+
+	// unsupported size is read as 64-bit value and never written
+	default: {
+		group->decode = select_decode<uint64_t>(*group);
+		group->encode = nullptr;
+	} break;
+	}
+
+	if (group->direction != EC_DIR_OUTPUT) {
+		group->encode = nullptr;
+	}
+}
+
+inline static uint32_t group_key(const EcatHelper::ecat_slave_entry_al& entry)
+{
+	return (entry.size << 24) | ((entry.direction & 0xff) << 16)
+		| ((entry.swap_endian & 0x1) << 8) | (entry.is_signed & 0x1);
+}
+
+void build(const EcatHelper::ecat_entries_al& entries, io_plan_al* plan,
+	const uint8_t& domain)
+{
+	std::map<uint32_t, size_t> groups;
+	ecat_size_io_al length = entries.size();
+
+	plan->groups.clear();
+	plan->encoders.resize(length);
+	plan->offsets.resize(length);
+	plan->bit_positions.resize(length);
+
+	for (ecat_size_io_al dmn_idx = 0; dmn_idx < length; dmn_idx++) {
+		const EcatHelper::ecat_slave_entry_al& entry = entries[dmn_idx];
+
+		// entries of other domains keep a null encoder and are skipped
+		if (entry.domain != domain) {
+			plan->encoders[dmn_idx] = nullptr;
+			continue;
+		}
+
+		uint32_t key = group_key(entry);
+
+		plan->encoders[dmn_idx] = select_entry_encoder(entry);
+		plan->offsets[dmn_idx] = entry.offset;
+		plan->bit_positions[dmn_idx] = entry.bit_position;
+
+		auto found = groups.find(key);
+		if (found == groups.end()) {
+			found = groups.emplace(key, plan->groups.size()).first;
+
+			plan->groups.push_back({
+				.size = entry.size,
+				.direction = entry.direction,
+				.swap_endian = entry.swap_endian,
+				.is_signed = entry.is_signed,
+			});
+		}
+
+		io_group_al& group = plan->groups[found->second];
+
+		group.offsets.push_back(entry.offset);
+		group.bit_positions.push_back(entry.bit_position);
+		group.indexes.push_back(dmn_idx);
+	}
+
+	for (io_group_al& group : plan->groups) {
+		// bit positions are only needed by 1-bit entries
+		if (group.size != 1) {
+			group.bit_positions.clear();
+		}
+
+		group.offsets.shrink_to_fit();
+		group.bit_positions.shrink_to_fit();
+		group.indexes.shrink_to_fit();
+
+		assign_routines(&group);
+	}
+
+#if VERBOSE > 0
+	printf("\nIO plan (domain %d): %ld group(s) for %d entries\n", domain,
+		plan->groups.size(), length);
+#endif
+}
+
+void decode(const io_plan_al& plan, const uint8_t* pd, uint64_t* raw,
+	ecat_image_value_al* image)
+{
+	for (const io_group_al& group : plan.groups) {
+		group.decode(group, pd, raw, image);
+	}
+}
+
+void encode(const io_plan_al& plan, uint8_t* pd, const uint64_t* raw)
+{
+	for (const io_group_al& group : plan.groups) {
+		if (group.encode) {
+			group.encode(group, pd, raw);
+		}
+	}
+}
+
+void encode_dirty(const io_plan_al& plan, uint8_t* pd, const uint64_t* raw,
+	const uint64_t* dirty)
+{
+	size_t words = dirty_words(plan.encoders.size());
+
+	for (size_t word_idx = 0; word_idx < words; word_idx++) {
+		uint64_t bits = dirty[word_idx];
+
+		while (bits) {
+			ecat_size_io_al idx = (word_idx << 6) + __builtin_ctzll(bits);
+			bits &= bits - 1;
+
+			if (plan.encoders[idx]) {
+				plan.encoders[idx](
+					pd + plan.offsets[idx], plan.bit_positions[idx], raw[idx]);
+			}
+		}
+	}
+}
+
+void carry(const io_plan_al& plan, const uint64_t* prev_raw, uint64_t* raw,
+	const ecat_image_value_al* prev_image, ecat_image_value_al* image)
+{
+	bool copy_image = image && image != prev_image;
+
+	for (const io_group_al& group : plan.groups) {
+		for (const ecat_size_io_al& idx : group.indexes) {
+			raw[idx] = prev_raw[idx];
+		}
+
+		if (copy_image) {
+			for (const ecat_size_io_al& idx : group.indexes) {
+				image[idx] = prev_image[idx];
+			}
+		}
+	}
+}
+
+}
@@ -0,0 +1,97 @@
+#ifndef _ECAT_HELPER_IO_PLAN_H_
+#define _ECAT_HELPER_IO_PLAN_H_
+
+#include <etherlab-helper.h>
+
+namespace IOPlan {
+
+struct io_group_s;
+
+typedef void (*io_decode_fn)(const struct io_group_s& group, const uint8_t* pd,
+	uint64_t* raw, EcatHelper::ecat_image_value_al* image);
+typedef void (*io_encode_fn)(
+	const struct io_group_s& group, uint8_t* pd, const uint64_t* raw);
+typedef void (*io_encode_entry_fn)(
+	uint8_t* data, const uint8_t& bit_position, const uint64_t& raw);
+
+/**
+ * Entries sharing the same size, direction, endianness and signedness.
+ * Each vector holds one element per entry (structure of arrays).
+ */
+typedef struct io_group_s {
+	EcatHelper::ecat_size_al size = 0;
+	uint8_t direction = 0;
+	uint8_t swap_endian = 0;
+	uint8_t is_signed = 0;
+
+	std::vector<uint32_t> offsets;
+	std::vector<uint8_t> bit_positions;
+	std::vector<EcatHelper::ecat_size_io_al> indexes;
+
+	io_decode_fn decode = nullptr;
+	io_encode_fn encode = nullptr;
+} io_group_al;
+
+typedef struct io_plan_s {
+	std::vector<io_group_al> groups;
+
+	// per domain index output routines, used to encode only dirty outputs
+	std::vector<io_encode_entry_fn> encoders;
+	std::vector<uint32_t> offsets;
+	std::vector<uint8_t> bit_positions;
+} io_plan_al;
+
+/**
+ * Groups entries registered in given domain. Indexes stay global, i.e. the
+ * plan is applied to the whole raw image but only touches its own entries.
+ */
+void build(const EcatHelper::ecat_entries_al& entries, io_plan_al* plan,
+	const uint8_t& domain = 0);
+
+void decode(const io_plan_al& plan, const uint8_t* pd, uint64_t* raw,
+	EcatHelper::ecat_image_value_al* image);
+
+void encode(const io_plan_al& plan, uint8_t* pd, const uint64_t* raw);
+
+void encode_dirty(const io_plan_al& plan, uint8_t* pd, const uint64_t* raw,
+	const uint64_t* dirty);
+
+/**
+ * Copies entries of the plan from previous raw image and image, for a domain
+ * not exchanged this cycle. image may be nullptr, or the same as prev_image
+ */
+void carry(const io_plan_al& plan, const uint64_t* prev_raw, uint64_t* raw,
+	const EcatHelper::ecat_image_value_al* prev_image,
+	EcatHelper::ecat_image_value_al* image);
+
+/** Writes one output entry, entries without encoder are skipped */
+inline void encode_one(const io_plan_al& plan, uint8_t* pd,
+	const EcatHelper::ecat_size_io_al& idx, const uint64_t& raw)
+{
+	if (plan.encoders[idx]) {
+		plan.encoders[idx](
+			pd + plan.offsets[idx], plan.bit_positions[idx], raw);
+	}
+}
+
+inline size_t dirty_words(const EcatHelper::ecat_size_io_al& length)
+{
+	return (length + 63) / 64;
+}
+
+inline void mark_dirty(uint64_t* dirty, const EcatHelper::ecat_size_io_al& idx)
+{
+	dirty[idx >> 6] |= 1ULL << (idx & 63);
+}
+
+inline void merge_dirty(
+	uint64_t* dirty, const uint64_t* other, const size_t& words)
+{
+	for (size_t word_idx = 0; word_idx < words; word_idx++) {
+		dirty[word_idx] |= other[word_idx];
+	}
+}
+
+}
+
+#endif
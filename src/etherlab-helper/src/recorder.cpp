@@ -0,0 +1,327 @@
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+
+#include "recorder.h"
+
+namespace Recorder {
+
+// file is mapped and grown this much at a time
+#define RECORDER_MAP_CHUNK (16UL << 20)
+
+// drain thread sleeps this long when the ring is empty
+#define RECORDER_DRAIN_IDLE_MS 2
+
+// niceness of drain thread, it must never compete with the cyclic thread
+#define RECORDER_DRAIN_NICE 10
+
+double decode(const file_entry_al& entry, const uint8_t* payload)
+{
+	const uint8_t* data = payload + entry.payload_offset;
+
+	if (entry.size == 1) {
+		return (data[0] >> entry.bit_position) & 1;
+	}
+
+	uint64_t raw = 0;
+	memcpy(&raw, data, entry.size / 8);
+
+	if (entry.flags & RECORDER_FLAG_SWAP) {
+		switch (entry.size) {
+		case 16: {
+			raw = swap_endian16(raw);
+		} break;
+		case 32: {
+			raw = swap_endian32(raw);
+		} break;
+		case 64: {
+			raw = swap_endian64(raw);
+		} break;
+		}
+	}
+
+	if (entry.flags & RECORDER_FLAG_SIGNED) {
+		uint8_t shift = 64 - entry.size;
+		return (double)((int64_t)(raw << shift) >> shift);
+	}
+
+	return (double)raw;
+}
+
+Recording::~Recording()
+{
+	close();
+}
+
+int8_t Recording::open(const std::string& path, file_header_al header,
+	const std::vector<file_entry_al>& entries, const size_t& ring_records)
+{
+	if ((fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644)) < 0) {
+		perror("Recording open failed");
+		return -1;
+	}
+
+	file_path = path;
+	record_size = header.record_size;
+
+	size_t header_size = sizeof(file_header_al)
+		+ entries.size() * sizeof(file_entry_al);
+	header_size = (header_size + 7) & ~(size_t)7;
+
+	memcpy(header.magic, RECORDER_MAGIC, sizeof(header.magic));
+	header.version = RECORDER_VERSION;
+	header.header_size = header_size;
+	header.entry_count = entries.size();
+	header.record_count = 0;
+
+	std::vector<uint8_t> prefix(header_size, 0);
+	memcpy(prefix.data(), &header, sizeof(header));
+	if (!entries.empty()) {
+		memcpy(prefix.data() + sizeof(header), entries.data(),
+			entries.size() * sizeof(file_entry_al));
+	}
+
+	if (pwrite(fd, prefix.data(), prefix.size(), 0)
+		!= (ssize_t)prefix.size()) {
+		perror("Recording header write failed");
+		::close(fd);
+		fd = -1;
+		return -1;
+	}
+
+	file_size = header_size;
+
+	// power of two slots, written once here so no page is faulted in
+	// by the cyclic thread
+	size_t slots = 2;
+	while (slots < ring_records) {
+		slots <<= 1;
+	}
+
+	ring.assign(slots * record_size, 0);
+	ring_mask = slots - 1;
+	head = 0;
+	tail = 0;
+
+	closing = false;
+	drain_thread = std::thread(&Recording::drain_entry, this);
+
+	return 0;
+}
+
+uint8_t* Recording::claim()
+{
+	size_t t = tail.load(std::memory_order_relaxed);
+
+	if (t - head.load(std::memory_order_acquire) > ring_mask) {
+		dropped_records.store(
+			dropped_records.load(std::memory_order_relaxed) + 1,
+			std::memory_order_relaxed);
+		return nullptr;
+	}
+
+	return ring.data() + (t & ring_mask) * record_size;
+}
+
+void Recording::commit()
+{
+	tail.store(tail.load(std::memory_order_relaxed) + 1,
+		std::memory_order_release);
+}
+
+int8_t Recording::append(const uint8_t* record)
+{
+	size_t size = file_size.load(std::memory_order_relaxed);
+
+	if (!map || size + record_size > map_offset + map_size) {
+		if (map) {
+			msync(map, map_size, MS_ASYNC);
+			munmap(map, map_size);
+			map = nullptr;
+		}
+
+		// window starts at page holding the end of the file
+		size_t page = sysconf(_SC_PAGESIZE);
+		map_offset = size & ~(page - 1);
+		map_size = RECORDER_MAP_CHUNK;
+
+		if (ftruncate(fd, map_offset + map_size) == -1) {
+			perror("Recording grow failed");
+			return -1;
+		}
+
+		void* ptr = mmap(nullptr, map_size, PROT_READ | PROT_WRITE,
+			MAP_SHARED, fd, map_offset);
+		if (ptr == MAP_FAILED) {
+			perror("Recording mmap failed");
+			return -1;
+		}
+
+		map = (uint8_t*)ptr;
+	}
+
+	memcpy(map + (size - map_offset), record, record_size);
+
+	file_size.store(size + record_size, std::memory_order_relaxed);
+	written.store(written.load(std::memory_order_relaxed) + 1,
+		std::memory_order_relaxed);
+
+	return 0;
+}
+
+void Recording::drain_entry()
+{
+	// may be started by the cyclic thread, drop its policy and CPU
+	// and run wherever the main thread may run
+	struct sched_param param = {};
+	pthread_setschedparam(pthread_self(), SCHED_OTHER, &param);
+	setpriority(PRIO_PROCESS, syscall(SYS_gettid), RECORDER_DRAIN_NICE);
+
+	cpu_set_t cpuset;
+	if (!sched_getaffinity(getpid(), sizeof(cpuset), &cpuset)) {
+		pthread_setaffinity_np(pthread_self(), sizeof(cpuset), &cpuset);
+	}
+
+	bool failed = false;
+
+	while (true) {
+		bool last = closing.load(std::memory_order_acquire);
+
+		size_t h = head.load(std::memory_order_relaxed);
+		size_t t = tail.load(std::memory_order_acquire);
+
+		for (; h != t; h++) {
+			if (!failed && append(ring.data() + (h & ring_mask) * record_size)) {
+				failed = true;
+			}
+
+			// slots are handed back one at a time, the cyclic thread
+			// may refill them while the rest is written
+			head.store(h + 1, std::memory_order_release);
+		}
+
+		if (last) {
+			break;
+		}
+
+		if (h == tail.load(std::memory_order_acquire)) {
+			std::this_thread::sleep_for(
+				std::chrono::milliseconds(RECORDER_DRAIN_IDLE_MS));
+		}
+	}
+}
+
+void Recording::close()
+{
+	if (fd < 0) {
+		return;
+	}
+
+	// writer has stopped by now, everything committed is drained
+	closing.store(true, std::memory_order_release);
+	if (drain_thread.joinable()) {
+		drain_thread.join();
+	}
+
+	if (map) {
+		munmap(map, map_size);
+		map = nullptr;
+	}
+
+	size_t size = file_size.load(std::memory_order_relaxed);
+	uint64_t count = written.load(std::memory_order_relaxed);
+
+	if (ftruncate(fd, size) == -1) {
+		perror("Recording truncate failed");
+	}
+
+	if (pwrite(fd, &count, sizeof(count),
+			offsetof(file_header_al, record_count))
+		!= sizeof(count)) {
+		perror("Recording header update failed");
+	}
+
+	fdatasync(fd);
+	::close(fd);
+	fd = -1;
+
+	std::vector<uint8_t>().swap(ring);
+}
+
+Reader::~Reader()
+{
+	if (map) {
+		munmap(map, map_size);
+	}
+}
+
+int8_t Reader::open(const std::string& path)
+{
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0) {
+		perror("Recording open failed");
+		return -1;
+	}
+
+	struct stat st;
+	if (fstat(fd, &st) == -1 || (size_t)st.st_size < sizeof(file_header_al)) {
+		fprintf(stderr, "Recording %s: file too short\n", path.c_str());
+		::close(fd);
+		return -1;
+	}
+
+	map_size = st.st_size;
+	void* ptr = mmap(nullptr, map_size, PROT_READ, MAP_SHARED, fd, 0);
+	::close(fd);
+
+	if (ptr == MAP_FAILED) {
+		perror("Recording mmap failed");
+		return -1;
+	}
+
+	map = (uint8_t*)ptr;
+	file_header = (const file_header_al*)map;
+
+	const file_header_al& hdr = *file_header;
+
+	if (memcmp(hdr.magic, RECORDER_MAGIC, sizeof(hdr.magic))
+		|| hdr.version != RECORDER_VERSION
+		|| hdr.record_size < sizeof(record_header_al)
+		|| hdr.header_size > map_size
+		|| sizeof(file_header_al) + hdr.entry_count * sizeof(file_entry_al)
+			> hdr.header_size) {
+		fprintf(stderr, "Recording %s: not a recording\n", path.c_str());
+		return -1;
+	}
+
+	file_entries = (const file_entry_al*)(map + sizeof(file_header_al));
+	records = map + hdr.header_size;
+	record_size = hdr.record_size;
+
+	// an unfinished file is preallocated, its tail holds no record yet
+	uint64_t available = (map_size - hdr.header_size) / record_size;
+	record_count = hdr.record_count;
+
+	if (!record_count) {
+		record_count = available;
+		while (record_count && !record(record_count - 1).timestamp_ns) {
+			record_count--;
+		}
+	} else if (record_count > available) {
+		record_count = available;
+	}
+
+	return 0;
+}
+
+}
@@ -0,0 +1,181 @@
+#ifndef _ECAT_HELPER_RECORDER_H_
+#define _ECAT_HELPER_RECORDER_H_
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <etherlab-helper.h>
+
+namespace Recorder {
+
+#define RECORDER_MAGIC "ECATREC"
+#define RECORDER_VERSION 1
+
+// file_entry_al::flags
+#define RECORDER_FLAG_SIGNED 0x01
+#define RECORDER_FLAG_SWAP 0x02
+#define RECORDER_FLAG_OUTPUT 0x04
+
+/**
+ * File layout, all little endian:
+ *   file_header_al, entry_count * file_entry_al, padding to header_size,
+ *   then record_count records of record_size bytes, each a
+ *   record_header_al followed by the payload.
+ *
+ * Payload is either a copy of every domain's process data (full image), so
+ * entries are found at their offset and bit position in wire format, or
+ * only selected entries packed one after another, already decoded.
+ */
+typedef struct file_header_s {
+	char magic[8];
+	uint32_t version;
+	uint32_t header_size; /**< Bytes before first record. */
+	uint32_t record_size; /**< Bytes per record, header included. */
+	uint32_t entry_count;
+	uint32_t period_ns;
+	uint32_t master_index;
+	uint64_t start_realtime_ns; /**< Wall clock when recording started. */
+	uint64_t start_monotonic_ns;
+	uint64_t record_count; /**< Written on close, 0 while recording. */
+	uint8_t full_image;
+	uint8_t reserved[7];
+} file_header_al;
+
+typedef struct file_entry_s {
+	uint32_t payload_offset; /**< Byte offset within payload. */
+	uint16_t position;
+	uint16_t index;
+	uint8_t subindex;
+	uint8_t size; /**< Bits. */
+	uint8_t bit_position;
+	uint8_t flags;
+	uint8_t domain;
+	uint8_t reserved[3];
+} file_entry_al;
+
+typedef struct record_header_s {
+	uint64_t cycle;
+	uint64_t timestamp_ns; /**< CLOCK_MONOTONIC when recorded. */
+} record_header_al;
+
+static_assert(sizeof(file_header_al) == 64, "file header layout");
+static_assert(sizeof(file_entry_al) == 16, "file entry layout");
+
+/** Value of entry within a record's payload */
+double decode(const file_entry_al& entry, const uint8_t* payload);
+
+/**
+ * Append-only recording. Cyclic thread fills preallocated ring slots,
+ * a low priority thread drains them into the file through a sliding
+ * memory map, so the cyclic thread never does any I/O.
+ */
+class Recording {
+public:
+	~Recording();
+
+	int8_t open(const std::string& path, file_header_al header,
+		const std::vector<file_entry_al>& entries, const size_t& ring_records);
+
+	/** Cyclic thread. Payload slot, nullptr if ring is full */
+	uint8_t* claim();
+	void commit();
+
+	/** Drains what is left, finalizes header and closes file */
+	void close();
+
+	const std::string& path() const
+	{
+		return file_path;
+	}
+
+	uint64_t records() const
+	{
+		return written.load(std::memory_order_relaxed);
+	}
+
+	uint64_t dropped() const
+	{
+		return dropped_records.load(std::memory_order_relaxed);
+	}
+
+	uint64_t bytes() const
+	{
+		return file_size.load(std::memory_order_relaxed);
+	}
+
+private:
+	void drain_entry();
+	int8_t append(const uint8_t* record);
+
+	std::string file_path;
+	int fd = -1;
+	size_t record_size = 0;
+
+	// ring of record_size slots, single producer and single consumer
+	std::vector<uint8_t> ring;
+	size_t ring_mask = 0;
+	alignas(64) std::atomic<size_t> head { 0 };
+	alignas(64) std::atomic<size_t> tail { 0 };
+
+	// sliding window of the file, grown by a chunk at a time
+	uint8_t* map = nullptr;
+	size_t map_offset = 0;
+	size_t map_size = 0;
+
+	std::thread drain_thread;
+	std::atomic<bool> closing { false };
+
+	std::atomic<uint64_t> written { 0 };
+	std::atomic<uint64_t> dropped_records { 0 };
+	std::atomic<uint64_t> file_size { 0 };
+};
+
+/** Read-only view of a recording file, mapped as a whole */
+class Reader {
+public:
+	~Reader();
+
+	int8_t open(const std::string& path);
+
+	const file_header_al& header() const
+	{
+		return *file_header;
+	}
+
+	const file_entry_al* entries() const
+	{
+		return file_entries;
+	}
+
+	/** Complete records, also of files left unfinished by a crash */
+	uint64_t count() const
+	{
+		return record_count;
+	}
+
+	const record_header_al& record(const uint64_t& idx) const
+	{
+		return *(const record_header_al*)(records + idx * record_size);
+	}
+
+	const uint8_t* payload(const uint64_t& idx) const
+	{
+		return records + idx * record_size + sizeof(record_header_al);
+	}
+
+private:
+	uint8_t* map = nullptr;
+	size_t map_size = 0;
+
+	const file_header_al* file_header = nullptr;
+	const file_entry_al* file_entries = nullptr;
+	const uint8_t* records = nullptr;
+	size_t record_size = 0;
+	uint64_t record_count = 0;
+};
+
+}
+
+#endif
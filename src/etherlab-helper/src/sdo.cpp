@@ -1,6 +1,11 @@
 #include <etherlab-helper.h>
+#include <algorithm>
+#include <atomic>
 #include <map>
+#include <numeric>
 #include <stdexcept>
+#include <thread>
+#include <vector>
 
 namespace EcatHelper::SDO {
 
@@ -194,4 +199,156 @@ int32_t write_i64(const ecat_pos_al& s_position, const ecat_index_al& s_index,
 	return sdo_download(s_position, s_index, s_subindex, size, data.bytes);
 }
 
+static void transfer(ecat_sdo_job_al* job)
+{
+	if (job->rtype == ECAT_SDO_READ) {
+		size_t result_size;
+
+		job->value.u64 = 0;
+		job->retval = sdo_upload(job->position, job->index, job->subindex,
+			job->size, &result_size, job->value.bytes, &job->abort_code);
+	} else {
+		job->retval = sdo_download(job->position, job->index, job->subindex,
+			job->size, job->value.bytes, &job->abort_code);
+	}
+}
+
+/**
+ * Execute SDO transfers concurrently across slaves. A slave mailbox handles
+ * one transfer at a time, so jobs of the same slave run one after another
+ * in the given order, while different slaves are accessed in parallel.
+ * Returns -1 if any transfer failed, see retval and abort_code of each job.
+ */
+int8_t transfer_many(
+	ecat_sdo_job_al* jobs, const size_t& count, const uint16_t& max_threads)
+{
+	// group jobs per slave, keeping their order
+	std::vector<size_t> order(count);
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(),
+		[jobs](const size_t& a, const size_t& b) {
+			return jobs[a].position < jobs[b].position;
+		});
+
+	// [begin, end) of order for every slave
+	std::vector<std::pair<size_t, size_t>> lanes;
+	for (size_t idx = 0; idx < count; idx++) {
+		if (!idx || jobs[order[idx]].position != jobs[order[idx - 1]].position) {
+			lanes.emplace_back(idx, idx);
+		}
+		lanes.back().second = idx + 1;
+	}
+
+	// workers transfer on the same master as the calling thread
+	Master* instance = current_master();
+
+	std::atomic<size_t> next_lane { 0 };
+	auto worker = [&]() {
+		use_master(instance);
+
+		for (;;) {
+			size_t lane = next_lane.fetch_add(1, std::memory_order_relaxed);
+			if (lane >= lanes.size()) {
+				break;
+			}
+
+			for (size_t idx = lanes[lane].first; idx < lanes[lane].second;
+				 idx++) {
+				transfer(&jobs[order[idx]]);
+			}
+		}
+	};
+
+	// calling thread takes a share of the lanes as well
+	size_t thread_count
+		= std::min<size_t>(lanes.size(), std::max<uint16_t>(max_threads, 1));
+	std::vector<std::thread> threads;
+	for (size_t idx = 1; idx < thread_count; idx++) {
+		threads.emplace_back(worker);
+	}
+
+	worker();
+
+	for (std::thread& thread : threads) {
+		thread.join();
+	}
+
+	for (size_t idx = 0; idx < count; idx++) {
+		if (jobs[idx].retval) {
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+void Batch::assign(ecat_sdo_job_al* jobs, const size_t& count)
+{
+	this->jobs = jobs;
+
+	order.resize(count);
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(),
+		[jobs](const size_t& a, const size_t& b) {
+			return jobs[a].position < jobs[b].position;
+		});
+
+	lanes.clear();
+	for (size_t idx = 0; idx < count; idx++) {
+		if (!idx || jobs[order[idx]].position != jobs[order[idx - 1]].position) {
+			lanes.emplace_back(idx, idx);
+		}
+		lanes.back().second = idx + 1;
+	}
+
+	in_flight = 0;
+	pending = count;
+}
+
+size_t Batch::submit()
+{
+	for (std::pair<size_t, size_t>& lane : lanes) {
+		while (lane.first < lane.second) {
+			ecat_sdo_job_al& job = jobs[order[lane.first]];
+			int8_t retval = sdo_request_submit(job);
+
+			// room is made by the next job of the batch coming back
+			if (retval == ECAT_SDO_REQ_ERR_BUSY && in_flight) {
+				break;
+			}
+
+			lane.first++;
+
+			if (retval) {
+				job.retval = retval;
+				pending--;
+			} else {
+				in_flight++;
+			}
+		}
+	}
+
+	return pending;
+}
+
+size_t Batch::complete()
+{
+	in_flight--;
+	pending--;
+
+	return submit();
+}
+
+size_t Batch::cancel()
+{
+	for (std::pair<size_t, size_t>& lane : lanes) {
+		for (; lane.first < lane.second; lane.first++) {
+			jobs[order[lane.first]].retval = ECAT_SDO_REQ_FAILED;
+			pending--;
+		}
+	}
+
+	return pending;
+}
+
 }